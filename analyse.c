@@ -1,7 +1,25 @@
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
 #include "analyse.h"
 #include "utils.h"
 #include "ca.h"
 
+static inline void caana_step(const int order, const size_t n, word_t* const snew, const word_t* const s, const int B, const word_t* const rtab, const mw_filter_t filt)
+{
+	// advance state (order rows, oldest first) by one generation
+	if (order == 1) {filt(n,snew,s,B,rtab); return;}
+	mw_copy(n,snew,s+n);
+	filt(n,snew+n,s+n,B,rtab);
+	mw_xor_rotr(n,snew+n,s,ca2_offset(B)); // cf. ca_run2
+}
+
+static inline int caana_equiv(const int order, const size_t n, const word_t* const s1, const word_t* const s2)
+{
+	return order == 1 ? mw_equiv(n,s1,s2) : mw_equiv2(n,s1,s1+n,s2,s2+n);
+}
+
 void caana_period
 (
 	const size_t        n,
@@ -9,18 +27,344 @@ void caana_period
 	const word_t* const ca,
 	const rtl_t*  const rule,
 	const size_t        prff,
-	const size_t        pmax
+	const size_t        pmax,
+	const int           order,
+	const int           uto
 )
 {
 	printf("calculating CA period... "); fflush(stdout);
-	word_t* const wca = mw_copy_alloc(I*n,ca); // copy to working CA
-	mw_run(prff,n,wca,rule->size,rule->tab);
 	int prot;
-	const size_t period = ca_period(pmax,n,wca,rule->size,rule->tab,&prot);
+	size_t period;
+	if (order == 2) {
+		// twisted initial pair (cf. ca_run2), fast-forwarded a generation at a time
+		word_t* const wca = mw_alloc(2*n);
+		word_t* const wtmp = mw_alloc(2*n);
+		mw_copy(n,wca,ca);
+		mw_rotr(n,wca+n,ca+n,(size_t)uto);
+		const mw_filter_t filt = mw_filter_sel(rule->size);
+		for (size_t i=0;i<prff;++i) {caana_step(2,n,wtmp,wca,rule->size,rule->tab,filt); mw_copy(2*n,wca,wtmp);}
+		period = ca_period2(pmax,n,wca,rule->size,rule->tab,&prot);
+		free(wtmp);
+		free(wca);
+		if (period == pmax) printf("> %zu iterations\n",pmax); else printf("%zu iterations, twist = %d\n",period,prot);
+		return;
+	}
+	word_t* const wca = mw_copy_alloc(n,ca); // copy first row only
+	rt_run(prff,n,wca,rule->size,rule->tab); // fast-forward by composed rule
+	period = ca_period(pmax,n,wca,rule->size,rule->tab,&prot);
 	if (period == pmax) printf("> %zu iterations\n",pmax); else printf("%zu iterations, twist = %d\n",period,prot);
 	free(wca);
 }
 
+// Period census: many random initial rows, each run to its attractor with
+// Brent's cycle detection (a fixed number of rows of memory), then the twisted
+// period (period up to rotation, which divides the exact period) is found by
+// checking rotations at divisors of the exact period. Initial conditions are
+// handed out to threads one at a time; every nchk completions the period and
+// (log-binned) transient distributions are compared with those nchk before, and
+// the census stops once both total variation distances fall below ptol.
+
+static size_t caana_brent(const int order, const size_t n, const word_t* const w0, const int B, const word_t* const rtab, const mw_filter_t filt, const size_t pmax, size_t* const trans, int* const twist, word_t* const tort, word_t* const hare, word_t* const wtmp)
+{
+	// returns twisted period (or 0 if exact cycle not found within pmax steps);
+	// the state is order rows (n words each), as are the work buffers tort, hare, wtmp
+	const size_t ns = (size_t)order*n;
+	mw_copy(ns,tort,w0);
+	caana_step(order,n,hare,w0,B,rtab,filt);
+	size_t power = 1, lam = 1, nsteps = 1;
+	while (!mw_equal(ns,tort,hare)) {
+		if (nsteps++ > pmax) return 0;
+		if (power == lam) {
+			mw_copy(ns,tort,hare);
+			power *= 2;
+			lam = 0;
+		}
+		caana_step(order,n,wtmp,hare,B,rtab,filt);
+		mw_copy(ns,hare,wtmp);
+		++lam;
+	}
+	mw_copy(ns,tort,w0);
+	mw_copy(ns,hare,w0);
+	for (size_t i=0;i<lam;++i) {caana_step(order,n,wtmp,hare,B,rtab,filt); mw_copy(ns,hare,wtmp);}
+	size_t mu = 0;
+	while (!mw_equal(ns,tort,hare)) {
+		caana_step(order,n,wtmp,tort,B,rtab,filt); mw_copy(ns,tort,wtmp);
+		caana_step(order,n,wtmp,hare,B,rtab,filt); mw_copy(ns,hare,wtmp);
+		++mu;
+	}
+	*trans = mu;
+	mw_copy(ns,hare,tort); // tort is on the cycle
+	for (size_t q=1;q<=lam;++q) {
+		caana_step(order,n,wtmp,hare,B,rtab,filt); mw_copy(ns,hare,wtmp);
+		if (lam%q != 0) continue;
+		const int rot = caana_equiv(order,n,tort,hare);
+		if (rot >= 0) {*twist = rot; return q;}
+	}
+	*twist = 0;
+	return lam; // not reached
+}
+
+static double caana_tvdist(const size_t n1, const size_t* const x1, const size_t n2, const size_t* const x2)
+{
+	// total variation distance between empirical distributions of sorted samples x1, x2
+	double tv = 0.0;
+	size_t i = 0, j = 0;
+	while (i < n1 || j < n2) {
+		const size_t v = (j == n2 || (i < n1 && x1[i] < x2[j])) ? x1[i] : x2[j];
+		size_t c1 = 0, c2 = 0;
+		while (i < n1 && x1[i] == v) {++i; ++c1;}
+		while (j < n2 && x2[j] == v) {++j; ++c2;}
+		tv += fabs((double)c1/(double)n1-(double)c2/(double)n2);
+	}
+	return tv/2.0;
+}
+
+typedef struct {
+	size_t          n;
+	int             B;
+	const word_t*   rtab;
+	mw_filter_t     filt;
+	int             order;
+	size_t          nmax;
+	size_t          pmax;
+	ulong           iseed;
+	size_t          nchk;
+	double          ptol;
+	pcen_t*         pcen;
+	size_t          next;   // next initial condition to hand out
+	size_t          ndone;
+	size_t*         ord;    // completion order
+	size_t*         sp;     // sort buffers (period, log-transient)
+	size_t*         st;
+	size_t*         sp0;
+	size_t*         st0;
+	int             stop;
+#ifdef HAVE_PTHREADS
+	pthread_mutex_t mutex;
+#endif
+} pcarg_t;
+
+static void caana_pcen_check(pcarg_t* const a)
+{
+	// compare distributions at this checkpoint with the previous one (call with lock held)
+	const size_t nd = a->ndone;
+	for (size_t i=0;i<nd;++i) {
+		const size_t k = a->ord[i];
+		a->sp[i] = a->pcen->period[k];
+		size_t lt = 0;
+		for (size_t t=a->pcen->trans[k]+1; t>1; t>>=1) ++lt; // floor(log2(transient+1))
+		a->st[i] = lt;
+	}
+	qsort_size_t(nd,a->sp);
+	qsort_size_t(nd,a->st);
+	if (nd >= 2*a->nchk) {
+		const size_t n0 = nd-a->nchk;
+		const double tvp = caana_tvdist(n0,a->sp0,nd,a->sp);
+		const double tvt = caana_tvdist(n0,a->st0,nd,a->st);
+		if (tvp < a->ptol && tvt < a->ptol) a->stop = 1;
+	}
+	memcpy(a->sp0,a->sp,nd*sizeof(size_t));
+	memcpy(a->st0,a->st,nd*sizeof(size_t));
+}
+
+static void* caana_pcen_thread(void* arg)
+{
+	pcarg_t* const a = (pcarg_t*)arg;
+	const size_t n = a->n;
+	const size_t ns = (size_t)a->order*n;
+	word_t* const w0   = mw_alloc(ns); // per-worker buffers
+	word_t* const tort = mw_alloc(ns);
+	word_t* const hare = mw_alloc(ns);
+	word_t* const wtmp = mw_alloc(ns);
+	while (1) {
+#ifdef HAVE_PTHREADS
+		pthread_mutex_lock(&a->mutex);
+#endif
+		const size_t k = a->stop ? a->nmax : a->next++;
+#ifdef HAVE_PTHREADS
+		pthread_mutex_unlock(&a->mutex);
+#endif
+		if (k >= a->nmax) break;
+		mt_t irng;
+		mt_seed(&irng,a->iseed == 0 ? 0 : a->iseed+k); // independent stream per initial condition
+		mw_randomise(ns,w0,&irng);
+		size_t trans = 0;
+		int twist = 0;
+		const size_t period = caana_brent(a->order,n,w0,a->B,a->rtab,a->filt,a->pmax,&trans,&twist,tort,hare,wtmp);
+#ifdef HAVE_PTHREADS
+		pthread_mutex_lock(&a->mutex);
+#endif
+		a->pcen->trans[k]  = trans;
+		a->pcen->period[k] = period;
+		a->pcen->twist[k]  = twist;
+		a->ord[a->ndone++] = k;
+		if (a->nchk > 0 && a->ndone%a->nchk == 0) caana_pcen_check(a);
+#ifdef HAVE_PTHREADS
+		pthread_mutex_unlock(&a->mutex);
+#endif
+	}
+	free(wtmp);
+	free(hare);
+	free(tort);
+	free(w0);
+	return NULL;
+}
+
+pcen_t* caana_period_census
+(
+	const size_t        n,
+	const int           B,
+	const word_t* const rtab,
+	const size_t        nmax,
+	const size_t        pmax,
+	const ulong         iseed,
+	const int           nthreads,
+	const size_t        nchk,
+	const double        ptol,
+	const mw_filter_t   kernel,
+	const int           order
+)
+{
+	pcen_t* const pcen = malloc(sizeof(pcen_t));
+	TEST_ALLOC(pcen);
+	pcen->trans  = calloc(nmax,sizeof(size_t)); // zero-initialises
+	TEST_ALLOC(pcen->trans);
+	pcen->period = calloc(nmax,sizeof(size_t)); // zero-initialises
+	TEST_ALLOC(pcen->period);
+	pcen->twist  = calloc(nmax,sizeof(int));    // zero-initialises
+	TEST_ALLOC(pcen->twist);
+
+	pcarg_t a;
+	a.n     = n;
+	a.B     = B;
+	a.rtab  = rtab;
+	a.filt  = kernel != NULL ? kernel : mw_filter_sel(B); // e.g. native kernel
+	a.order = order;
+	a.nmax  = nmax;
+	a.pmax  = pmax;
+	a.iseed = iseed;
+	a.nchk  = nchk;
+	a.ptol  = ptol;
+	a.pcen  = pcen;
+	a.next  = 0;
+	a.ndone = 0;
+	a.stop  = 0;
+	a.ord   = malloc(5*nmax*sizeof(size_t));
+	TEST_ALLOC(a.ord);
+	a.sp    = a.ord+nmax;
+	a.st    = a.sp +nmax;
+	a.sp0   = a.st +nmax;
+	a.st0   = a.sp0+nmax;
+
+#ifdef HAVE_PTHREADS
+	pthread_mutex_init(&a.mutex,NULL);
+	const size_t nt = nthreads > 1 ? (size_t)nthreads : 1;
+	pthread_t threads[nt];
+	for (size_t t=0;t<nt;++t) {
+		const int tres = pthread_create(&threads[t],NULL,caana_pcen_thread,(void*)&a);
+		PASSERT(tres == 0,"unable to create thread %zu",t+1);
+	}
+	for (size_t t=0;t<nt;++t) {
+		const int tres = pthread_join(threads[t],NULL);
+		PASSERT(tres == 0,"unable to join thread %zu",t+1);
+	}
+	pthread_mutex_destroy(&a.mutex);
+#else
+	caana_pcen_thread((void*)&a);
+#endif
+
+	// keep completed initial conditions only (in completion order)
+
+	pcen->nics = a.ndone;
+	for (size_t i=0;i<a.ndone;++i) {
+		const size_t k = a.ord[i];
+		a.sp[i] = pcen->trans[k];
+		a.st[i] = pcen->period[k];
+		a.sp0[i] = (size_t)pcen->twist[k];
+	}
+	for (size_t i=0;i<a.ndone;++i) {
+		pcen->trans[i]  = a.sp[i];
+		pcen->period[i] = a.st[i];
+		pcen->twist[i]  = (int)a.sp0[i];
+	}
+	free(a.ord);
+
+	return pcen;
+}
+
+void caana_pcen_free(pcen_t* const pcen)
+{
+	if (pcen == NULL) return;
+	free(pcen->twist);
+	free(pcen->period);
+	free(pcen->trans);
+	free(pcen);
+}
+
+static void caana_pcen_hist(const size_t N, const size_t* const x, const size_t maxvals, const char* const name)
+{
+	// print most frequent values
+	size_t* const xs = malloc(N*sizeof(size_t));
+	TEST_ALLOC(xs);
+	memcpy(xs,x,N*sizeof(size_t));
+	qsort_size_t(N,xs);
+	size_t nv = 0;
+	for (size_t i=0;i<N;++i) if (i == 0 || xs[i] != xs[i-1]) ++nv;
+	size_t* const val = malloc(2*nv*sizeof(size_t));
+	TEST_ALLOC(val);
+	size_t* const cnt = val+nv;
+	nv = 0;
+	for (size_t i=0;i<N;++i) {
+		if (i == 0 || xs[i] != xs[i-1]) {val[nv] = xs[i]; cnt[nv++] = 0;}
+		++cnt[nv-1];
+	}
+	printf("%s : %zu distinct values :",name,nv);
+	for (size_t j=0;j<maxvals && j<nv;++j) { // selection of most frequent
+		size_t jmax = j;
+		for (size_t i=j+1;i<nv;++i) if (cnt[i] > cnt[jmax]) jmax = i;
+		const size_t vtmp = val[j]; val[j] = val[jmax]; val[jmax] = vtmp;
+		const size_t ctmp = cnt[j]; cnt[j] = cnt[jmax]; cnt[jmax] = ctmp;
+		printf(" %zu (%.3f)",val[j],(double)cnt[j]/(double)N);
+	}
+	if (nv > maxvals) printf(" ...");
+	putchar('\n');
+	free(val);
+	free(xs);
+}
+
+void caana_pcen_print(const pcen_t* const pcen, const size_t maxvals)
+{
+	const size_t N = pcen->nics;
+	if (N == 0) return;
+	size_t nfound = 0, tmax = 0;
+	double tmean = 0.0;
+	for (size_t i=0;i<N;++i) {
+		if (pcen->period[i] == 0) continue;
+		++nfound;
+		tmean += (double)pcen->trans[i];
+		if (pcen->trans[i] > tmax) tmax = pcen->trans[i];
+	}
+	printf("%zu initial conditions : %zu cycles found (%.3f)",N,nfound,(double)nfound/(double)N);
+	if (nfound > 0) printf(", mean transient = %g, max transient = %zu",tmean/(double)nfound,tmax);
+	putchar('\n');
+	caana_pcen_hist(N,pcen->period,maxvals,"period (0 = not found)");
+	size_t* const tw = malloc(N*sizeof(size_t));
+	TEST_ALLOC(tw);
+	for (size_t i=0;i<N;++i) tw[i] = (size_t)pcen->twist[i];
+	caana_pcen_hist(N,tw,maxvals,"twist");
+	free(tw);
+}
+
+int caana_pcen_write(const pcen_t* const pcen, const char* const fname)
+{
+	// one line per initial condition: transient, period (0 = not found), twist
+	FILE* const fs = fopen(fname,"w");
+	if (fs == NULL) return 0;
+	fprintf(fs,"# transient\tperiod\ttwist\n");
+	for (size_t i=0;i<pcen->nics;++i) fprintf(fs,"%zu\t%zu\t%d\n",pcen->trans[i],pcen->period[i],pcen->twist[i]);
+	return fclose(fs) == 0;
+}
+
 void caana_dps
 (
 	const size_t        n,
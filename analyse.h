@@ -11,9 +11,37 @@ void caana_period
 	const word_t* const ca,
 	const rtl_t*  const rule,
 	const size_t        prff,
-	const size_t        pmax
+	const size_t        pmax,
+	const int           order, // 1, or 2 for second-order CA (cf. ca_run2)
+	const int           uto
 );
 
+typedef struct {
+	size_t  nics;   // number of initial conditions run
+	size_t* trans;  // transient length per initial condition
+	size_t* period; // (twisted) period per initial condition (0 if not found within maximum)
+	int*    twist;  // twist (rotation) per initial condition
+} pcen_t;
+
+pcen_t* caana_period_census
+(
+	const size_t        n,
+	const int           B,
+	const word_t* const rtab,
+	const size_t        nmax,
+	const size_t        pmax,
+	const ulong         iseed,
+	const int           nthreads,
+	const size_t        nchk,
+	const double        ptol,
+	const mw_filter_t   kernel,
+	const int           order // 1, or 2 for second-order CA (initial state is a random pair of rows)
+);
+
+void caana_pcen_free  (pcen_t* const pcen);
+void caana_pcen_print (const pcen_t* const pcen, const size_t maxvals);
+int  caana_pcen_write (const pcen_t* const pcen, const char* const fname);
+
 void caana_dps
 (
 	const size_t        n,
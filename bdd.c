@@ -0,0 +1,484 @@
+#include "bdd.h"
+#include "rtab.h"
+
+#define RB_NONE  UINT32_MAX
+#define RB_SLICE 96 // bit-sliced evaluation if no more than RB_SLICE*B nodes (else stream windows)
+
+static inline uint64_t rb_hmix(uint64_t h) // 64-bit finaliser (splitmix64)
+{
+	h ^= h >> 30; h *= 0xbf58476d1ce4e5b9;
+	h ^= h >> 27; h *= 0x94d049bb133111eb;
+	h ^= h >> 31;
+	return h;
+}
+
+static inline uint64_t rb_nkey(const int var, const uint32_t lo, const uint32_t hi)
+{
+	return rb_hmix(((uint64_t)lo<<32|hi)^((uint64_t)var<<58));
+}
+
+/*********************************************************************/
+/*                      memo (key -> node) map                       */
+/*********************************************************************/
+
+typedef struct {
+	uint64_t* key;
+	uint32_t* val;
+	size_t    n;
+	size_t    mask;
+} rbmemo_t;
+
+#define RB_NOKEY UINT64_MAX
+
+static void rb_memo_init(rbmemo_t* const m, const size_t size)
+{
+	size_t H = 64;
+	while (H < 2*size) H *= 2;
+	m->key = malloc(H*sizeof(uint64_t));
+	TEST_ALLOC(m->key);
+	m->val = malloc(H*sizeof(uint32_t));
+	TEST_ALLOC(m->val);
+	for (size_t i=0;i<H;++i) m->key[i] = RB_NOKEY;
+	m->n = 0;
+	m->mask = H-1;
+}
+
+static void rb_memo_free(rbmemo_t* const m)
+{
+	free(m->val);
+	free(m->key);
+}
+
+static uint32_t rb_memo_get(const rbmemo_t* const m, const uint64_t key)
+{
+	size_t i = (size_t)rb_hmix(key)&m->mask;
+	for (;m->key[i] != RB_NOKEY; i = (i+1)&m->mask) if (m->key[i] == key) return m->val[i];
+	return RB_NONE;
+}
+
+static void rb_memo_put(rbmemo_t* const m, const uint64_t key, const uint32_t val)
+{
+	if (2*(m->n+1) > m->mask+1) { // grow
+		rbmemo_t m2;
+		rb_memo_init(&m2,m->mask+1);
+		for (size_t i=0;i<=m->mask;++i) if (m->key[i] != RB_NOKEY) rb_memo_put(&m2,m->key[i],m->val[i]);
+		rb_memo_free(m);
+		*m = m2;
+	}
+	size_t i = (size_t)rb_hmix(key)&m->mask;
+	while (m->key[i] != RB_NOKEY && m->key[i] != key) i = (i+1)&m->mask;
+	if (m->key[i] == RB_NOKEY) ++m->n;
+	m->key[i] = key;
+	m->val[i] = val;
+}
+
+/*********************************************************************/
+/*                      node store                                   */
+/*********************************************************************/
+
+rbdd_t* rb_alloc(const int size)
+{
+	ASSERT(size >= 1 && size <= RB_MAXB,"rule size out of range for decision diagram");
+	rbdd_t* const rb = malloc(sizeof(rbdd_t));
+	TEST_ALLOC(rb);
+	rb->size = size;
+	rb->root = RB_ZERO;
+	rb->maxnodes = 256;
+	rb->node = malloc(rb->maxnodes*sizeof(rbnode_t));
+	TEST_ALLOC(rb->node);
+	rb->node[RB_ZERO] = (rbnode_t){-1,RB_ZERO,RB_ZERO};
+	rb->node[RB_ONE]  = (rbnode_t){-1,RB_ONE, RB_ONE };
+	rb->nnodes = 2;
+	rb->hmask = 2*rb->maxnodes-1;
+	rb->htab = malloc((rb->hmask+1)*sizeof(uint32_t));
+	TEST_ALLOC(rb->htab);
+	for (size_t i=0;i<=rb->hmask;++i) rb->htab[i] = RB_NONE;
+	return rb;
+}
+
+void rb_free(rbdd_t* const rb)
+{
+	if (rb == NULL) return;
+	free(rb->htab);
+	free(rb->node);
+	free(rb);
+}
+
+uint32_t rb_node(rbdd_t* const rb, const int var, const uint32_t lo, const uint32_t hi)
+{
+	// unique node testing var with children lo, hi (reduced: no node if lo == hi)
+	if (lo == hi) return lo;
+	ASSERT(var >= 0 && var < rb->size && rb->node[lo].var < var && rb->node[hi].var < var,"bad decision diagram node");
+	size_t i = (size_t)rb_nkey(var,lo,hi)&rb->hmask;
+	for (;rb->htab[i] != RB_NONE; i = (i+1)&rb->hmask) {
+		const rbnode_t* const p = rb->node+rb->htab[i];
+		if (p->var == var && p->lo == lo && p->hi == hi) return rb->htab[i];
+	}
+	ASSERT(rb->nnodes < RB_NONE,"too many decision diagram nodes");
+	if (rb->nnodes == rb->maxnodes) { // grow node store and unique table
+		rb->maxnodes *= 2;
+		rbnode_t* const node = realloc(rb->node,rb->maxnodes*sizeof(rbnode_t));
+		TEST_ALLOC(node);
+		rb->node = node;
+		free(rb->htab);
+		rb->hmask = 2*rb->maxnodes-1;
+		rb->htab = malloc((rb->hmask+1)*sizeof(uint32_t));
+		TEST_ALLOC(rb->htab);
+		for (size_t j=0;j<=rb->hmask;++j) rb->htab[j] = RB_NONE;
+		for (uint32_t k=2;k<rb->nnodes;++k) {
+			size_t j = (size_t)rb_nkey(rb->node[k].var,rb->node[k].lo,rb->node[k].hi)&rb->hmask;
+			while (rb->htab[j] != RB_NONE) j = (j+1)&rb->hmask;
+			rb->htab[j] = k;
+		}
+		i = (size_t)rb_nkey(var,lo,hi)&rb->hmask;
+		while (rb->htab[i] != RB_NONE) i = (i+1)&rb->hmask;
+	}
+	const uint32_t k = (uint32_t)rb->nnodes++;
+	rb->node[k] = (rbnode_t){var,lo,hi};
+	rb->htab[i] = k;
+	return k;
+}
+
+static uint32_t rb_copy_node(rbdd_t* const dst, const rbdd_t* const src, const uint32_t k, uint32_t* const map)
+{
+	if (k <= RB_ONE) return k;
+	if (map[k] == RB_NONE) {
+		const rbnode_t* const p = src->node+k;
+		const uint32_t lo = rb_copy_node(dst,src,p->lo,map);
+		const uint32_t hi = rb_copy_node(dst,src,p->hi,map);
+		map[k] = rb_node(dst,p->var,lo,hi);
+	}
+	return map[k];
+}
+
+static uint32_t rb_copy(rbdd_t* const dst, const rbdd_t* const src)
+{
+	// copy function of src into dst; returns its root in dst
+	uint32_t* const map = malloc(src->nnodes*sizeof(uint32_t));
+	TEST_ALLOC(map);
+	for (size_t k=0;k<src->nnodes;++k) map[k] = RB_NONE;
+	const uint32_t root = rb_copy_node(dst,src,src->root,map);
+	free(map);
+	return root;
+}
+
+rbdd_t* rb_compact(const rbdd_t* const rb)
+{
+	rbdd_t* const rbc = rb_alloc(rb->size);
+	rbc->root = rb_copy(rbc,rb);
+	return rbc;
+}
+
+/*********************************************************************/
+/*                 conversion to/from tables and ids                 */
+/*********************************************************************/
+
+static uint32_t rb_build(rbdd_t* const rb, const word_t* const tab, const int v, const size_t off)
+{
+	// subtable of size 2^(v+1) at entry offset off
+	if (v < 0) return (uint32_t)RTBIT(tab,off);
+	if (v < 6) { // subtable within a word: catch constants early
+		const word_t mask = WONES>>(WBITS-(int)POW2(v+1));
+		const word_t u = (tab[off>>6]>>(off&63))&mask;
+		if (u == WZERO) return RB_ZERO;
+		if (u == mask)  return RB_ONE;
+	}
+	const uint32_t lo = rb_build(rb,tab,v-1,off);
+	const uint32_t hi = rb_build(rb,tab,v-1,off+POW2(v));
+	return rb_node(rb,v,lo,hi);
+}
+
+rbdd_t* rb_from_table(const int size, const word_t* const tab)
+{
+	rbdd_t* const rb = rb_alloc(size);
+	rb->root = rb_build(rb,tab,size-1,0);
+	return rb;
+}
+
+rbdd_t* rb_from_totalistic(const int size, const rtype_t rtype, const word_t mask)
+{
+	// no table: the output depends only on the count c of set cells (other than
+	// the centre, for outer-totalistic rules) and on the centre state s, so the
+	// diagram is the counting lattice, built bottom-up with node[c][s] the rule
+	// restricted to c cells set and centre s among the variables above
+	ASSERT((rtype == RT_TOTAL && size <= WTOTMAXB) || (rtype == RT_OUTER && size <= WOUTMAXB),"bad totalistic rule");
+	const int C = rtype == RT_OUTER ? size/2 : -1; // centre variable (none for totalistic)
+	rbdd_t* const wrk = rb_alloc(size);
+	uint32_t lay[2][size+2][2]; // layers v-1 and v
+	for (int c=0;c<=size+1;++c) for (int s=0;s<2;++s) {
+		const int b = rtype == RT_OUTER ? 2*c+s : c; // mask bit
+		lay[0][c][s] = b < WBITS ? (uint32_t)BITON(mask,b) : RB_ZERO;
+	}
+	for (int v=0,cur=1;v<size;++v,cur^=1) {
+		for (int c=0;c<=size;++c) for (int s=0;s<2;++s) {
+			const uint32_t lo = v == C ? lay[cur^1][c][0] : lay[cur^1][c  ][s];
+			const uint32_t hi = v == C ? lay[cur^1][c][1] : lay[cur^1][c+1][s];
+			lay[cur][c][s] = rb_node(wrk,v,lo,hi);
+		}
+		lay[cur][size+1][0] = lay[cur][size+1][1] = RB_ZERO; // unreachable
+	}
+	wrk->root = lay[size&1][0][0];
+	rbdd_t* const rb = rb_compact(wrk); // drop unreachable counts
+	rb_free(wrk);
+	return rb;
+}
+
+static void rb_fill(const rbdd_t* const rb, word_t* const tab, const uint32_t k, const int v, const size_t off)
+{
+	// fill subtable of size 2^(v+1) at entry offset off (zero-initialised) with function k
+	if (k == RB_ZERO) return;
+	const size_t S = POW2(v+1);
+	if (k == RB_ONE) {
+		if (S >= WBITS) memset(tab+(off>>6),0xFF,(S>>6)*sizeof(word_t));
+		else tab[off>>6] |= (WONES>>(WBITS-(int)S))<<(off&63);
+		return;
+	}
+	const rbnode_t* const p = rb->node+k;
+	const int split = p->var == v; // else node does not depend on v
+	rb_fill(rb,tab,split ? p->lo : k,v-1,off);
+	rb_fill(rb,tab,split ? p->hi : k,v-1,off+S/2);
+}
+
+word_t* rb_to_table(const rbdd_t* const rb)
+{
+	word_t* const tab = rt_alloc(rb->size);
+	rb_fill(rb,tab,rb->root,rb->size-1,0);
+	return tab;
+}
+
+rbdd_t* rb_sread_id(const char* const str, int* const size)
+{
+	rtype_t rtype;
+	word_t mask;
+	const int tot = rt_tot_sread_id(str,size,&rtype,&mask);
+	if (tot != 0) { // (outer-)totalistic id: no table, so any size up to the mask limit
+		if (tot < 0) {*size = tot; return NULL;}
+		return rb_from_totalistic(*size,rtype,mask);
+	}
+	word_t* const tab = rt_sread_id(str,size);
+	if (tab == NULL) return NULL;
+	rbdd_t* const rb = rb_from_table(*size,tab);
+	free(tab);
+	return rb;
+}
+
+void rb_fprint_id(const rbdd_t* const rb, FILE* const fstream)
+{
+	// streamed from the diagram: no table required
+	const size_t C = rt_hexchars(rb->size);
+	const word_t S = POW2(rb->size);
+	for (size_t c=0;c<C;++c) {
+		word_t u = WZERO;
+		for (word_t j=0;j<4 && 4*c+j<S;++j) u |= rb_eval(rb,4*c+j)<<j;
+		fputc(hexchar[u],fstream);
+	}
+}
+
+void rb_print_id(const rbdd_t* const rb)
+{
+	rb_fprint_id(rb,stdout);
+}
+
+/*********************************************************************/
+/*                 properties and symmetries                         */
+/*********************************************************************/
+
+size_t rb_nnodes(const rbdd_t* const rb)
+{
+	uint8_t* const live = calloc(rb->nnodes,sizeof(uint8_t)); // zero-initialises
+	TEST_ALLOC(live);
+	live[rb->root] = 1;
+	size_t nn = 0;
+	for (size_t k=rb->nnodes;k-- > 2;) { // children precede parents
+		if (!live[k]) continue;
+		++nn;
+		live[rb->node[k].lo] = live[rb->node[k].hi] = 1;
+	}
+	free(live);
+	return nn;
+}
+
+double rb_lambda(const rbdd_t* const rb)
+{
+	// fraction of table entries set: each node averages its children
+	double* const frac = malloc(rb->nnodes*sizeof(double));
+	TEST_ALLOC(frac);
+	frac[RB_ZERO] = 0.0;
+	frac[RB_ONE]  = 1.0;
+	for (size_t k=2;k<rb->nnodes;++k) frac[k] = 0.5*(frac[rb->node[k].lo]+frac[rb->node[k].hi]);
+	const double lam = frac[rb->root];
+	free(frac);
+	return lam;
+}
+
+static uint32_t rb_complement(rbdd_t* const rb, const uint32_t k, rbmemo_t* const m)
+{
+	// f(~x) complemented: swap children and constants
+	if (k <= RB_ONE) return RB_ONE-k;
+	const uint64_t key = (uint64_t)k<<8;
+	uint32_t c = rb_memo_get(m,key);
+	if (c == RB_NONE) {
+		const rbnode_t p = rb->node[k]; // copy: store may move
+		const uint32_t lo = rb_complement(rb,p.hi,m);
+		const uint32_t hi = rb_complement(rb,p.lo,m);
+		c = rb_node(rb,p.var,lo,hi);
+		rb_memo_put(m,key,c);
+	}
+	return c;
+}
+
+static uint32_t rb_restrict(rbdd_t* const rb, const uint32_t k, const int v, const uint32_t b, rbmemo_t* const m)
+{
+	// k with x_v = b, where k does not depend on variables below v
+	if (k <= RB_ONE || rb->node[k].var < v) return k;
+	if (rb->node[k].var == v) return b ? rb->node[k].hi : rb->node[k].lo;
+	const uint64_t key = (uint64_t)k<<8|(uint64_t)v<<2|(uint64_t)b<<1|1;
+	uint32_t r = rb_memo_get(m,key);
+	if (r == RB_NONE) {
+		const rbnode_t p = rb->node[k];
+		const uint32_t lo = rb_restrict(rb,p.lo,v,b,m);
+		const uint32_t hi = rb_restrict(rb,p.hi,v,b,m);
+		r = rb_node(rb,p.var,lo,hi);
+		rb_memo_put(m,key,r);
+	}
+	return r;
+}
+
+static uint32_t rb_reflect(rbdd_t* const rb, const uint32_t k, const int j, rbmemo_t* const m)
+{
+	// g(x) = f(reverse(x)), where k is f with x_0 .. x_{j-1} fixed; x_j of f becomes x_{B-1-j} of g
+	if (k <= RB_ONE) return k;
+	const uint64_t key = (uint64_t)k<<8|(uint64_t)j<<2|2;
+	uint32_t r = rb_memo_get(m,key);
+	if (r == RB_NONE) {
+		const uint32_t k0 = rb_restrict(rb,k,j,0,m);
+		const uint32_t k1 = rb_restrict(rb,k,j,1,m);
+		const uint32_t lo = rb_reflect(rb,k0,j+1,m);
+		const uint32_t hi = rb_reflect(rb,k1,j+1,m);
+		r = rb_node(rb,rb->size-1-j,lo,hi);
+		rb_memo_put(m,key,r);
+	}
+	return r;
+}
+
+rbdd_t* rb_symmetry(const rbdd_t* const rb, const int g)
+{
+	// g bit 0: left-right reflection, bit 1: 0/1 complement (allocates - remember to free!)
+	rbdd_t* const wrk = rb_alloc(rb->size);
+	wrk->root = rb_copy(wrk,rb);
+	rbmemo_t m;
+	rb_memo_init(&m,wrk->nnodes);
+	if (g&1) wrk->root = rb_reflect(wrk,wrk->root,0,&m);
+	if (g&2) wrk->root = rb_complement(wrk,wrk->root,&m);
+	rb_memo_free(&m);
+	rbdd_t* const rbs = rb_compact(wrk); // drop intermediate nodes
+	rb_free(wrk);
+	return rbs;
+}
+
+static int rb_cmp(const rbdd_t* const rb1, const uint32_t k1, const rbdd_t* const rb2, const uint32_t k2, rbmemo_t* const m)
+{
+	// lexicographic comparison of tables: the lo half of a (sub)table holds the earlier entries
+	if (k1 <= RB_ONE && k2 <= RB_ONE) return k1 == k2 ? 0 : k1 < k2 ? -1 : +1;
+	const uint64_t key = (uint64_t)k1<<32|k2;
+	const uint32_t c = rb_memo_get(m,key);
+	if (c != RB_NONE) return (int)c-1;
+	const rbnode_t* const p1 = rb1->node+k1;
+	const rbnode_t* const p2 = rb2->node+k2;
+	const int top = p1->var > p2->var ? p1->var : p2->var; // functions do not depend on variables above top
+	const uint32_t lo1 = p1->var == top ? p1->lo : k1, hi1 = p1->var == top ? p1->hi : k1;
+	const uint32_t lo2 = p2->var == top ? p2->lo : k2, hi2 = p2->var == top ? p2->hi : k2;
+	int r = rb_cmp(rb1,lo1,rb2,lo2,m);
+	if (r == 0) r = rb_cmp(rb1,hi1,rb2,hi2,m);
+	rb_memo_put(m,key,(uint32_t)(r+1));
+	return r;
+}
+
+int rb_symcmp(const rbdd_t* const rb1, const rbdd_t* const rb2)
+{
+	ASSERT(rb1->size == rb2->size,"rules must be the same size");
+	rbmemo_t m;
+	rb_memo_init(&m,rb1->nnodes+rb2->nnodes);
+	const int r = rb_cmp(rb1,rb1->root,rb2,rb2->root,&m);
+	rb_memo_free(&m);
+	return r;
+}
+
+int rb_canonical(const rbdd_t* const rb, rbdd_t** const crb)
+{
+	// returns symmetry taking rb to canonical form *crb (if not NULL)
+	int gmin = 0;
+	rbdd_t* rbmin = NULL;
+	for (int g=1;g<4;++g) {
+		rbdd_t* const rbs = rb_symmetry(rb,g);
+		if (rb_symcmp(rbs,rbmin != NULL ? rbmin : rb) < 0) {
+			rb_free(rbmin);
+			rbmin = rbs;
+			gmin = g;
+		}
+		else rb_free(rbs);
+	}
+	if (crb != NULL) *crb = rbmin != NULL ? rbmin : rb_compact(rb);
+	else rb_free(rbmin);
+	return gmin;
+}
+
+/*********************************************************************/
+/*                      stepping kernel                              */
+/*********************************************************************/
+
+void rb_filter(const rbdd_t* const rb, const size_t n, word_t* const wnew, const word_t* const w, word_t* const wrk)
+{
+	const int B = rb->size;
+	const size_t N = rb->nnodes;
+	const rbnode_t* const node = rb->node;
+	const uint32_t root = rb->root;
+	if (N <= (size_t)(RB_SLICE*B)) { // bit-sliced: every node for 64 cells at once
+		word_t x[RB_MAXB];
+		wrk[RB_ZERO] = WZERO;
+		wrk[RB_ONE]  = WONES;
+		for (size_t k=0;k<n;++k) {
+			const word_t a = w[k], b = k < n-1 ? w[k+1] : w[0]; // next word : wrap to lo-word on last word
+			x[0] = a;
+			for (int v=1;v<B;++v) x[v] = (a>>v)|(b<<(WBITS-v)); // cell i+v, for each cell i
+			for (size_t j=2;j<N;++j) {
+				const word_t lo = wrk[node[j].lo], hi = wrk[node[j].hi];
+				wrk[j] = lo^(x[node[j].var]&(lo^hi));
+			}
+			wnew[k] = wrk[root];
+		}
+	}
+	else { // stream each window through the diagram
+		for (size_t k=0;k<n;++k) {
+			const word_t a = w[k], b = k < n-1 ? w[k+1] : w[0];
+			word_t wnewk = WZERO;
+			for (int i=0;i<WBITS;++i) {
+				const word_t win = i == 0 ? a : (a>>i)|(b<<(WBITS-i));
+				uint32_t j = root;
+				while (j > RB_ONE) j = BITON(win,node[j].var) ? node[j].hi : node[j].lo;
+				wnewk |= (word_t)j<<i;
+			}
+			wnew[k] = wnewk;
+		}
+	}
+}
+
+void rb_run(const size_t I, const size_t n, word_t* const w, const rbdd_t* const rb)
+{
+	if (I == 0) return; // do nothing
+	rbdd_t* const rbc = rb_compact(rb); // only live nodes are evaluated
+	word_t* const wrk = mw_alloc(rbc->nnodes);
+	word_t* const ww  = mw_alloc(n);
+	const size_t J = I/2;
+	for (size_t j=0;j<J;++j) {
+		rb_filter(rbc,n,ww,w,wrk);
+		rb_filter(rbc,n,w,ww,wrk);
+	}
+	if (2*J != I) { // odd number of iterations - one more to go
+		rb_filter(rbc,n,ww,w,wrk);
+		mw_copy(n,w,ww);
+	}
+	free(ww);
+	free(wrk);
+	rb_free(rbc);
+}
@@ -0,0 +1,76 @@
+#ifndef BDD_H
+#define BDD_H
+
+#include "rtab.h"
+
+/*********************************************************************/
+/*        rules as reduced ordered binary decision diagrams          */
+/*********************************************************************/
+
+// A rule of size B is a boolean function of the window bits x_0 .. x_{B-1}
+// (x_j = cell i+j for output cell i, as for rule tables). Each diagram has
+// its own node store: nodes 0 and 1 are the constant functions, and node k
+// (k > 1) tests variable var, with children lo (x_var = 0) and hi (x_var = 1).
+// Variables are ordered x_{B-1} (root) down to x_0, so that the lo branch of
+// a node covers the lower half of its subtable, as for the bit-packed table.
+// Nodes are unique (hash-consed) and children always precede their parents,
+// so the store is in topological order. Structured rules (totalistic,
+// composed, ...) have compact diagrams even for rule sizes far beyond those
+// for which a 2^B-entry table may be stored; random rules do not.
+
+#define RB_MAXB 63 // windows must fit in a word
+
+typedef struct {
+	int      var; // variable (cell offset) tested; -1 for the constant nodes
+	uint32_t lo;  // child for x_var = 0
+	uint32_t hi;  // child for x_var = 1
+} rbnode_t;
+
+typedef struct {
+	int       size;   // rule size B
+	uint32_t  root;   // root node
+	size_t    nnodes; // nodes in store (including constants)
+	size_t    maxnodes;
+	rbnode_t* node;
+	uint32_t* htab;   // unique table (open addressing)
+	size_t    hmask;
+} rbdd_t;
+
+#define RB_ZERO ((uint32_t)0)
+#define RB_ONE  ((uint32_t)1)
+
+rbdd_t*  rb_alloc      (const int size);                                        // constant zero rule
+void     rb_free       (rbdd_t* const rb);
+uint32_t rb_node       (rbdd_t* const rb, const int var, const uint32_t lo, const uint32_t hi);
+rbdd_t*  rb_compact    (const rbdd_t* const rb);                                // copy of nodes reachable from root
+
+rbdd_t*  rb_from_table (const int size, const word_t* const tab);
+rbdd_t*  rb_from_totalistic (const int size, const rtype_t rtype, const word_t mask); // no table: sizes up to WTOTMAXB/WOUTMAXB
+word_t*  rb_to_table   (const rbdd_t* const rb);                                // allocates - remember to free!
+rbdd_t*  rb_sread_id   (const char* const str, int* const size);                // as rt_sread_id (T/O ids built without a table); NULL on failure
+void     rb_fprint_id  (const rbdd_t* const rb, FILE* const fstream);
+void     rb_print_id   (const rbdd_t* const rb);
+
+size_t   rb_nnodes     (const rbdd_t* const rb);                                // non-constant nodes reachable from root
+double   rb_lambda     (const rbdd_t* const rb);                                // Langton's lambda (exact for B <= 53)
+rbdd_t*  rb_symmetry   (const rbdd_t* const rb, const int g);                   // as rt_symmetry
+int      rb_symcmp     (const rbdd_t* const rb1, const rbdd_t* const rb2);      // as rt_symcmp (lexicographic on table entries)
+int      rb_canonical  (const rbdd_t* const rb, rbdd_t** const crb);            // as rt_canonical (*crb allocated if crb not NULL)
+
+static inline word_t rb_eval(const rbdd_t* const rb, const word_t r)
+{
+	// table entry r
+	uint32_t k = rb->root;
+	while (k > RB_ONE) k = BITON(r,rb->node[k].var) ? rb->node[k].hi : rb->node[k].lo;
+	return (word_t)k;
+}
+
+// Stepping kernel: for small diagrams all nodes are evaluated bit-sliced
+// (64 cells per word operation, in node order), otherwise each window is
+// streamed through the diagram from the root. The work buffer wrk must hold
+// rb->nnodes words.
+
+void rb_filter (const rbdd_t* const rb, const size_t n, word_t* const wnew, const word_t* const w, word_t* const wrk);
+void rb_run    (const size_t I, const size_t n, word_t* const w, const rbdd_t* const rb); // as mw_run
+
+#endif // BDD_H
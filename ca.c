@@ -25,20 +25,82 @@ void ca_prints(const size_t I, const size_t n, const word_t* const ca)
 	ca_fprints(I,n,ca,stdout);
 }
 
-void ca_run(const size_t I, const size_t n, word_t* const ca, word_t* const cawrk, const int B, const word_t* const rtab, const int uto)
+void ca_run(const size_t I, const size_t n, word_t* const ca, const int B, const word_t* const rtab, const int uto)
 {
-	for (word_t* w=ca+n;w<ca+I*n;w+=n) mw_filter(n,w,w-n,B,rtab);
-	if (uto) {
-		ASSERT(cawrk != NULL,"Need CA work buffer to unwrap!");
-		mw_copy(I*n,cawrk,ca);
-		ca_rotl(I,n,ca,cawrk,uto);
+	const mw_filter_t filt = mw_filter_sel(B);
+	if (uto == 0) {
+		for (word_t* w=ca+n;w<ca+I*n;w+=n) filt(n,w,w-n,B,rtab);
+		return;
 	}
+	// untwist in place: step the (twisted) generation in a row buffer, and
+	// write each new row directly into its untwisted position
+	word_t wbuf1[n], wbuf2[n];
+	word_t* wold = wbuf1;
+	word_t* wnew = wbuf2;
+	mw_copy(n,wold,ca);
+	size_t b = 0;
+	for (word_t* w=ca+n;w<ca+I*n;w+=n) {
+		filt(n,wnew,wold,B,rtab);
+		SWAP(word_t*,wnew,wold);
+		b += (size_t)uto;
+		mw_rotl(n,w,wold,b);
+	}
+}
+
+void ca_run2(const size_t I, const size_t n, word_t* const ca, const int B, const word_t* const rtab, const int uto, const mw_filter_t kern)
+{
+	if (I < 3) return; // rows 0 and 1 are initial state
+	const mw_filter_t filt = kern == NULL ? mw_filter_sel(B) : kern;
+	const size_t off = ca2_offset(B);
+	if (uto == 0) {
+		for (word_t* w=ca+2*n;w<ca+I*n;w+=n) {
+			filt(n,w,w-n,B,rtab);
+			mw_xor_rotr(n,w,w-2*n,off);
+		}
+		return;
+	}
+	// as for ca_run; generation i-2 is read back from its stored (untwisted) row
+	word_t wbuf1[n], wbuf2[n];
+	word_t* wold = wbuf1;
+	word_t* wnew = wbuf2;
+	const size_t u = (size_t)uto;
+	mw_rotr(n,wold,ca+n,u);
+	size_t b = u;
+	for (word_t* w=ca+2*n;w<ca+I*n;w+=n) {
+		filt(n,wnew,wold,B,rtab);
+		mw_xor_rotr(n,wnew,w-2*n,b-u+off);
+		SWAP(word_t*,wnew,wold);
+		b += u;
+		mw_rotl(n,w,wold,b);
+	}
+}
+
+static size_t ca_rotmod(const long long r, const size_t n)
+{
+	const long long N = (long long)(n*WBITS);
+	const long long rm = r%N;
+	return (size_t)(rm < 0 ? rm+N : rm);
+}
+
+void ca_rewind2(const size_t I, const size_t n, word_t* const ca, const int B, const int uto)
+{
+	// Stored row t is the physical row rotated right by t*(C-uto); the reversed
+	// pair is re-expressed in the frame of stored rows 0 and 1.
+	ASSERT(I >= 2,"need at least two rows");
+	const long long d = (long long)(B/2-uto);
+	const long long J = (long long)I;
+	word_t w0[n], w1[n];
+	mw_rotl(n,w0,ca+(I-1)*n,ca_rotmod((J-1)*d,n));
+	mw_rotl(n,w1,ca+(I-2)*n,ca_rotmod((J-3)*d,n));
+	mw_copy(n,ca,  w0);
+	mw_copy(n,ca+n,w1);
 }
 
 void ca_filter(const size_t I, const size_t n, word_t* const ca, const word_t* const caold, const int B, const word_t* const rtab)
 {
+	const mw_filter_t filt = mw_filter_sel(B);
 	word_t* wnew = ca;
-	for (const word_t* w=caold;w<caold+I*n;w+=n,wnew+=n) mw_filter(n,wnew,w,B,rtab);
+	for (const word_t* w=caold;w<caold+I*n;w+=n,wnew+=n) filt(n,wnew,w,B,rtab);
 }
 
 size_t ca_period(const size_t I, const size_t n, const word_t* const ca, const int B, const word_t* const rtab, int* const rot)
@@ -47,9 +109,10 @@ size_t ca_period(const size_t I, const size_t n, const word_t* const ca, const i
 	word_t mword2[n];
 	word_t* wold = mword1;
 	word_t* wnew = mword2;
+	const mw_filter_t filt = mw_filter_sel(B);
 	mw_copy(n,wold,ca);
 	for (size_t i=0;i<I;++i) {
-		mw_filter(n,wnew,wold,B,rtab);
+		filt(n,wnew,wold,B,rtab);
 		*rot = mw_equiv(n,ca,wnew);
 		if (*rot >= 0) return i+1;
 		SWAP(word_t*,wnew,wold);
@@ -57,6 +120,25 @@ size_t ca_period(const size_t I, const size_t n, const word_t* const ca, const i
 	return I;
 }
 
+size_t ca_period2(const size_t I, const size_t n, const word_t* const ca2, const int B, const word_t* const rtab, int* const rot)
+{
+	word_t mword[3*n];
+	word_t* wold = mword;
+	word_t* w    = mword+n;
+	word_t* wnew = mword+2*n;
+	const mw_filter_t filt = mw_filter_sel(B);
+	const size_t off = ca2_offset(B);
+	mw_copy(2*n,mword,ca2);
+	for (size_t i=0;i<I;++i) {
+		filt(n,wnew,w,B,rtab);
+		mw_xor_rotr(n,wnew,wold,off);
+		*rot = mw_equiv2(n,ca2,ca2+n,w,wnew);
+		if (*rot >= 0) return i+1;
+		word_t* const wtmp = wold; wold = w; w = wnew; wnew = wtmp;
+	}
+	return I;
+}
+
 void ca_rotl(const size_t I, const size_t n, word_t* const ca, const word_t* const caold, const int nbits)
 {
 	size_t nb = (size_t)nbits;
@@ -19,7 +19,23 @@ void    ca_rotr        (const size_t I, const size_t n, word_t* const ca, const
 void    ca_reverse     (const size_t I, const size_t n, word_t* const ca, const word_t* const caold);
 void    ca_filter      (const size_t I, const size_t n, word_t* const ca, const word_t* const caold, const int B, const word_t* const rtab);
 
-void    ca_run         (const size_t I, const size_t n, word_t* const ca, word_t* const cawrk, const int B, const word_t* const rtab, const int uto);
+void    ca_run         (const size_t I, const size_t n, word_t* const ca, const int B, const word_t* const rtab, const int uto);
+
+// Second-order (reversible) CA: x_{t+1} = F(x_t) XOR x_{t-1}, where the XORed
+// cell is the one under the centre C = B/2 of the rule window. In the twisted
+// frame of the filter kernels (output cell i from cells i .. i+B-1) the window
+// centre drifts right by C cells per generation, so generation t-1 is rotated
+// right by 2C cells before XORing. Rows 0 and 1 are the initial state; stored
+// rows are untwisted by uto as for ca_run. Any pair of consecutive (physical)
+// rows determines the whole orbit in either direction of time: ca_rewind2 sets
+// rows 0 and 1 from the last two rows in reverse order, so that a subsequent
+// ca_run2 runs the CA backwards.
+
+static inline size_t ca2_offset(const int B) {return (size_t)(2*(B/2));}
+
+void    ca_run2        (const size_t I, const size_t n, word_t* const ca, const int B, const word_t* const rtab, const int uto, const mw_filter_t kern); // kern NULL for default
+void    ca_rewind2     (const size_t I, const size_t n, word_t* const ca, const int B, const int uto);
+size_t  ca_period2     (const size_t I, const size_t n, const word_t* const ca2, const int B, const word_t* const rtab, int* const rot); // ca2 is twisted pair
 
 void    ca_dps         (const size_t I, const size_t n, const word_t* const ca, double* const dps, const double* const costab);
 void    ca_autocov     (const size_t I, const size_t n, const word_t* const ca, double* const ac);
@@ -1,4 +1,5 @@
 #include "caX11.h"
+#include "ca.h"
 
 XRectangle* ca_xrects_create(
 	const size_t        I,
@@ -153,6 +154,24 @@ void ca_zpixmap_create(
 	}
 }
 
+static inline void ca_zpixmap_row(const size_t n, const word_t* const w, char* const imrow, const int ppc, const int imx, const int foncol)
+{
+	// ZPixmap data for a single CA row (ppc pixel rows, starting at imrow)
+
+	const uint32_t oncol  = foncol ? 0x000077 : 0x000000; // black, or dark blue for filter
+	const uint32_t offcol = 0xFFFFFF;                     // white
+
+	uint32_t* const prow = (uint32_t*)imrow; // as above, process pixels as 32-bit words
+	uint32_t* p = prow;
+	for (size_t k=0; k<n; ++k) {
+		for (word_t b=0; b<WBITS; ++b) {
+			const uint32_t col = BITON(w[k],b) ? oncol : offcol;
+			for (int v=0; v<ppc; ++v) *p++ = col;
+		}
+	}
+	for (int u=1; u<ppc; ++u) memcpy(prow+u*imx,prow,(size_t)imx*sizeof(uint32_t)); // replicate pixel row
+}
+
 #else // use safe(-ish) version
 
 void ca_zpixmap_create(
@@ -242,4 +261,84 @@ void ca_zpixmap_create(
 	}
 }
 
+static inline void ca_zpixmap_row(const size_t n, const word_t* const w, char* const imrow, const int ppc, const int imx, const int foncol)
+{
+	// ZPixmap data for a single CA row (ppc pixel rows, starting at imrow)
+
+	const char c = (char)255;
+	const char d = (char)(foncol ? 127 : 0);
+
+	char* p = imrow;
+	for (size_t k=0; k<n; ++k) {
+		for (word_t b=0; b<WBITS; ++b) {
+			const int on = BITON(w[k],b);
+			for (int v=0; v<ppc; ++v) {
+				*p++ = on ? d : c; // B
+				*p++ = on ? 0 : c; // G
+				*p++ = on ? 0 : c; // R
+				*p++ = 0;          // pad (probably unnecessary)
+			}
+		}
+	}
+	for (int u=1; u<ppc; ++u) memcpy(imrow+4*u*imx,imrow,4*(size_t)imx); // replicate pixel row
+}
+
 #endif // UNSAFE_ZPIXMAP
+
+
+void ca_run_zpixmap(
+	const size_t        I,
+	const size_t        n,
+	word_t*       const ca,
+	word_t*       const fca,
+	const int           B,
+	const word_t* const rtab,
+	const mw_filter_t   rkern,
+	const int           fsiz,
+	const word_t* const ftab,
+	const int           uto,
+	const int           order,
+	const double        noise,
+	mt_t*         const nrng,
+	char* const         imdata,
+	const int           ppc,
+	const int           imx,
+	const int           foncol
+)
+{
+	// Fused pipeline: run CA from its first row (unless rtab is NULL), untwist,
+	// filter into fca (unless ftab is NULL) and build ZPixmap data, a row at a
+	// time, so that each row is still in cache when filtered and rasterised.
+	// Equivalent to ca_run, then ca_filter, then ca_zpixmap_create. The CA is
+	// stepped by kernel rkern (or the default kernel if NULL). For a second-order
+	// CA (order 2) the first two rows are the initial state, as for ca_run2. If
+	// noise > 0 each output cell is flipped with that probability (wm_noisify).
+
+	word_t wbuf1[n], wbuf2[n];
+	word_t* wold = wbuf1; // current generation (twisted)
+	word_t* wnew = wbuf2;
+	const mw_filter_t rfilt = rkern != NULL ? rkern : mw_filter_sel(B);
+	const mw_filter_t ffilt = mw_filter_sel(fsiz);
+	const size_t off = ca2_offset(B);
+	mw_copy(n,wold,ca);
+	const size_t rowbytes = 4*(size_t)ppc*(size_t)imx; // 4 bytes per pixel
+	for (size_t i=0; i<I; ++i) {
+		word_t* const w = ca+i*n;
+		if (rtab != NULL && order == 2 && i == 1) {
+			mw_rotr(n,wold,w,(size_t)uto); // initial state: twist back
+		}
+		else if (rtab != NULL && i > 0) {
+			rfilt(n,wnew,wold,B,rtab);
+			if (order == 2) mw_xor_rotr(n,wnew,w-2*n,(i-2)*(size_t)uto+off);
+			if (noise > 0.0) wm_noisify(n,wnew,noise,nrng);
+			SWAP(word_t*,wnew,wold);
+			mw_rotl(n,w,wold,i*(size_t)uto); // untwist in place (cf. ca_run)
+		}
+		const word_t* wd = w;
+		if (ftab != NULL) {
+			ffilt(n,fca+i*n,w,fsiz,ftab);
+			wd = fca+i*n;
+		}
+		ca_zpixmap_row(n,wd,imdata+i*rowbytes,ppc,imx,foncol);
+	}
+}
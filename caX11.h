@@ -38,4 +38,24 @@ void ca_zpixmap_create(
 	const int           foncol
 );
 
+void ca_run_zpixmap(
+	const size_t        I,
+	const size_t        n,
+	word_t*       const ca,
+	word_t*       const fca,
+	const int           B,
+	const word_t* const rtab,
+	const mw_filter_t   rkern,
+	const int           fsiz,
+	const word_t* const ftab,
+	const int           uto,
+	const int           order,
+	const double        noise,
+	mt_t*         const nrng,
+	char* const         imdata,
+	const int           ppc,
+	const int           imx,
+	const int           foncol
+);
+
 #endif // CAX11_H
@@ -0,0 +1,484 @@
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "census.h"
+#include "rtab.h"
+#include "pool.h"
+#include "utils.h"
+
+/*********************************************************************/
+/*       attractor/basin census of the global map on rings           */
+/*********************************************************************/
+
+#define BM_ON(bm,x)  BITON((bm)[(x)>>6],(x)&63)
+#define BM_SET(bm,x) SETBIT((bm)[(x)>>6],(x)&63)
+#define BM_CLR(bm,x) ((bm)[(x)>>6] &= ~(WONE<<((x)&63)))
+
+#define CENSUS_CHUNK 1024 // forward-pass start configurations claimed at a time
+
+typedef struct {
+	size_t  n;
+	size_t  cap;
+	word_t* x;
+	uint64_t* d;
+} cstack_t;
+
+static inline void cstack_push(cstack_t* const stk, const word_t x, const uint64_t d)
+{
+	if (stk->n == stk->cap) {
+		stk->cap = stk->cap == 0 ? 1024 : 2*stk->cap;
+		stk->x = realloc(stk->x,stk->cap*sizeof(word_t));
+		TEST_ALLOC(stk->x);
+		stk->d = realloc(stk->d,stk->cap*sizeof(uint64_t));
+		TEST_ALLOC(stk->d);
+	}
+	stk->x[stk->n] = x;
+	stk->d[stk->n] = d;
+	++stk->n;
+}
+
+// Preimages of y on the ring are the closed de Bruijn walks labelled y; walks
+// are extended 8 cells at a time (then m mod 8 cells) using tables of (node,
+// output chunk) -> (input chunk, end node) transitions.
+
+typedef struct {
+	int       c;   // chunk width (cells)
+	size_t*   idx; // (node,output chunk) -> transition list offsets
+	uint16_t* xb;  // input chunk
+	uint32_t* end; // end node
+} ctrans_t;
+
+static size_t ctrans_bytes(const int B, const int c)
+{
+	// peak memory of ctrans_build (transition lists plus fill offsets)
+	const size_t N = POW2(B-1)<<c;
+	return (2*N+1)*sizeof(size_t)+N*(sizeof(uint16_t)+sizeof(uint32_t));
+}
+
+static void ctrans_build(ctrans_t* const T, const int B, const word_t* const tab, const int c)
+{
+	const size_t n = POW2(B-1);
+	const size_t C = POW2(c);
+	const size_t N = n<<c;
+	T->c   = c;
+	T->idx = calloc(N+1,sizeof(size_t)); // zero-initialises
+	TEST_ALLOC(T->idx);
+	T->xb  = malloc(N*sizeof(uint16_t));
+	TEST_ALLOC(T->xb);
+	T->end = malloc(N*sizeof(uint32_t));
+	TEST_ALLOC(T->end);
+	for (int pass=0; pass<2; ++pass) { // first pass counts, second fills
+		size_t* const pos = pass ? malloc(N*sizeof(size_t)) : NULL;
+		if (pass) {TEST_ALLOC(pos); memcpy(pos,T->idx,N*sizeof(size_t));}
+		for (size_t p=0; p<n; ++p) {
+			for (size_t xb=0; xb<C; ++xb) {
+				size_t node = p, yb = 0;
+				for (int j=0; j<c; ++j) {
+					const size_t r = node|(((xb>>j)&1)<<(B-1));
+					yb |= (size_t)RTBIT(tab,r)<<j;
+					node = r>>1;
+				}
+				const size_t k = (p<<c)|yb;
+				if (pass) {
+					T->xb [pos[k]] = (uint16_t)xb;
+					T->end[pos[k]] = (uint32_t)node;
+					++pos[k];
+				}
+				else {
+					++T->idx[k+1];
+				}
+			}
+		}
+		if (pass) free(pos);
+		else for (size_t k=0; k<N; ++k) T->idx[k+1] += T->idx[k];
+	}
+}
+
+static void ctrans_free(ctrans_t* const T)
+{
+	free(T->end);
+	free(T->xb);
+	free(T->idx);
+}
+
+typedef struct {
+	int             m;
+	int             B;
+	word_t          mmask;
+	const word_t*   tab;
+	const ctrans_t* T8; // 8-cell chunks
+	const ctrans_t* Tt; // tail chunk (m mod 8 cells)
+	word_t          y;
+	uint64_t        d;
+	const word_t*   cyc;
+	cstack_t*       stk;
+} cpre_t;
+
+static void census_pre(const cpre_t* const P, const int i, const size_t p0, const size_t node, const word_t xnew)
+{
+	// extend walk from start node p0 (now at node, with new input bits xnew) consistently with y
+	// from cell i; complete (non-cycle) preimages are pushed on the stack
+	const int m = P->m;
+	if (i == m) {
+		if (node != p0) return; // not closed
+		const word_t x = (p0|(xnew<<(P->B-1)))&P->mmask; // wrapped bits agree with p0
+		if (!BM_ON(P->cyc,x)) cstack_push(P->stk,x,P->d);
+		return;
+	}
+	const ctrans_t* const T = m-i >= 8 ? P->T8 : P->Tt;
+	const int c = T->c;
+	const size_t k = (node<<c)|(size_t)((P->y>>i)&(POW2(c)-1));
+	for (size_t e=T->idx[k]; e<T->idx[k+1]; ++e) census_pre(P,i+c,p0,T->end[e],xnew|((word_t)T->xb[e]<<i));
+}
+
+typedef struct {
+	int             m;
+	int             B;
+	const word_t*   tab;
+	wd_filter_t     filt;
+	const word_t*   cyc;
+	cycle_t*        cycles;
+	size_t          ncycles;
+	size_t          next;   // next cycle to hand out
+	size_t          ndepths;
+	uint64_t*       dhist;  // thread-local depth histogram
+#ifdef HAVE_PTHREADS
+	pthread_mutex_t* mutex;
+#endif
+	size_t*         pnext;
+} cbarg_t;
+
+static void* census_basins(void* arg)
+{
+	// explore basins backwards from their cycles
+	cbarg_t* const a = (cbarg_t*)arg;
+	const int m = a->m;
+	cstack_t stk = {0,0,NULL,NULL};
+	ctrans_t T8, Tt;
+	ctrans_build(&T8,a->B,a->tab,8);
+	ctrans_build(&Tt,a->B,a->tab,m%8 == 0 ? 8 : m%8);
+	cpre_t P;
+	P.m     = m;
+	P.B     = a->B;
+	P.mmask = WONES>>(WBITS-m);
+	P.tab   = a->tab;
+	P.T8    = &T8;
+	P.Tt    = &Tt;
+	P.cyc   = a->cyc;
+	P.stk   = &stk;
+	while (1) {
+#ifdef HAVE_PTHREADS
+		if (a->mutex != NULL) pthread_mutex_lock(a->mutex);
+#endif
+		const size_t c = (*a->pnext)++;
+#ifdef HAVE_PTHREADS
+		if (a->mutex != NULL) pthread_mutex_unlock(a->mutex);
+#endif
+		if (c >= a->ncycles) break;
+		cycle_t* const cyc = &a->cycles[c];
+		uint64_t basin = 0, depth = 0;
+		word_t z = cyc->rep;
+		for (uint64_t k=0; k<cyc->len; ++k, z = a->filt(m,z,a->B,a->tab)) cstack_push(&stk,z,0);
+		while (stk.n > 0) {
+			--stk.n;
+			const word_t x = stk.x[stk.n];
+			const uint64_t d = stk.d[stk.n];
+			++basin;
+			if (d > depth) depth = d;
+			if (d >= a->ndepths) {
+				const size_t nd = 2*(d+1);
+				a->dhist = realloc(a->dhist,nd*sizeof(uint64_t));
+				TEST_ALLOC(a->dhist);
+				for (size_t j=a->ndepths; j<nd; ++j) a->dhist[j] = 0;
+				a->ndepths = nd;
+			}
+			++a->dhist[d];
+			P.y = x;
+			P.d = d+1;
+			for (size_t p=0; p<POW2(a->B-1); ++p) census_pre(&P,0,p,p,WZERO);
+		}
+		cyc->basin = basin;
+		cyc->depth = depth;
+	}
+	ctrans_free(&Tt);
+	ctrans_free(&T8);
+	free(stk.d);
+	free(stk.x);
+	return NULL;
+}
+
+static int census_cycle_comp(const void* const x1, const void* const x2)
+{
+	const cycle_t* const c1 = (const cycle_t*)x1;
+	const cycle_t* const c2 = (const cycle_t*)x2;
+	if (c1->basin != c2->basin) return c1->basin > c2->basin ? -1 : +1; // largest first
+	return (c1->rep > c2->rep) - (c1->rep < c2->rep);
+}
+
+// Forward pass. A thread walks from its start configuration x, claiming each
+// configuration with an atomic OR on the visited bitmap, until it reaches one
+// (y) already claimed. It then marks its path done; if y is on it, it has found
+// a new cycle. Otherwise y was claimed by another thread; if that thread's path
+// was not yet done, y is recorded as an exit: the two paths may close a cycle
+// that neither thread sees. Of the threads whose paths share such a cycle, the
+// one that read done first found the next path not yet done, so some exit
+// leads into the cycle; exits are followed up serially after the pass.
+
+typedef struct {
+	size_t   n;
+	size_t   cap;
+	cycle_t* c;
+	cstack_t exits; // exit configurations (depths unused)
+} clist_t;
+
+typedef struct {
+	int           m;
+	int           B;
+	const word_t* tab;
+	wd_filter_t   filt;
+	word_t*       visited;
+	word_t*       done;
+	word_t*       cyc;
+	clist_t*      cl;   // per-thread cycles and exits
+} cfarg_t;
+
+static void census_cycle_add(clist_t* const cl, const word_t y, const int m, const int B, const word_t* const tab, const wd_filter_t filt, word_t* const cyc)
+{
+	// new cycle through y
+	if (cl->n == cl->cap) {
+		cl->cap = cl->cap == 0 ? 16 : 2*cl->cap;
+		cl->c = realloc(cl->c,cl->cap*sizeof(cycle_t));
+		TEST_ALLOC(cl->c);
+	}
+	cycle_t* const c = &cl->c[cl->n++];
+	c->rep = y;
+	c->len = 0;
+	word_t z = y;
+	do {
+		__atomic_fetch_or(&cyc[z>>6],WONE<<(z&63),__ATOMIC_RELAXED);
+		if (z < c->rep) c->rep = z;
+		++c->len;
+		z = filt(m,z,B,tab);
+	} while (z != y);
+}
+
+static void census_fwd(void* const arg, const size_t k, const size_t tnum)
+{
+	cfarg_t* const a = (cfarg_t*)arg;
+	const int m = a->m, B = a->B;
+	const word_t x = (word_t)k;
+	if (BITON(__atomic_load_n(&a->visited[x>>6],__ATOMIC_RELAXED),x&63)) return;
+	word_t y = x;
+	uint64_t L = 0;
+	while (!BITON(__atomic_fetch_or(&a->visited[y>>6],WONE<<(y&63),__ATOMIC_RELAXED),y&63)) {
+		++L;
+		y = a->filt(m,y,B,a->tab);
+	}
+	if (L == 0) return; // x claimed by another thread meanwhile
+	const int ydone = BITON(__atomic_load_n(&a->done[y>>6],__ATOMIC_SEQ_CST),y&63); // read before our path is done
+	int onpath = 0;
+	word_t z = x;
+	for (uint64_t i=0; i<L; ++i) {
+		if (z == y) onpath = 1;
+		__atomic_fetch_or(&a->done[z>>6],WONE<<(z&63),__ATOMIC_SEQ_CST);
+		z = a->filt(m,z,B,a->tab);
+	}
+	if (onpath) census_cycle_add(&a->cl[tnum],y,m,B,a->tab,a->filt,a->cyc);
+	else if (!ydone) cstack_push(&a->cl[tnum].exits,y,0);
+}
+
+census_t* census_run(const int m, const int B, const word_t* const tab, const int nthreads)
+{
+	ASSERT(2*m <= WBITS,"ring too long");
+	ASSERT(B <= m,"ring shorter than rule");
+	ASSERT(B <= CENSUS_MAXB,"rule too big for census (transition tables)");
+	const size_t S   = POW2(m);
+	const size_t nbw = m > 6 ? POW2(m-6) : 1;
+#ifdef HAVE_PTHREADS
+	const size_t nt = nthreads > 1 ? (size_t)nthreads : 1;
+#else
+	const size_t nt = 1;
+#endif
+	TEST_RAM(3*nbw*sizeof(word_t)+nt*(ctrans_bytes(B,8)+ctrans_bytes(B,m%8 == 0 ? 8 : m%8))); // bitmaps, per-thread transition tables
+
+	census_t* const cen = malloc(sizeof(census_t));
+	TEST_ALLOC(cen);
+	cen->m = m;
+
+	// Garden-of-Eden configurations (threaded image bitmap)
+
+	cen->ngoe = S-rt_uwords(B,tab,m,nthreads);
+
+	// cycles: forward walks from start configurations shared out between threads, each
+	// claiming configurations in the visited bitmap until reaching a claimed one; then
+	// the cycles split between the paths of several threads (see census_fwd)
+
+	const wd_filter_t filt = wd_filter_sel(B);
+	word_t* const visited = calloc(nbw,sizeof(word_t)); // zero-initialises
+	TEST_ALLOC(visited);
+	word_t* const done    = calloc(nbw,sizeof(word_t)); // zero-initialises
+	TEST_ALLOC(done);
+	word_t* const cyc     = calloc(nbw,sizeof(word_t)); // zero-initialises
+	TEST_ALLOC(cyc);
+	clist_t cl[nt];
+	for (size_t t=0; t<nt; ++t) {
+		cl[t].n = cl[t].cap = 0;
+		cl[t].c = NULL;
+		cl[t].exits = (cstack_t){0,0,NULL,NULL};
+	}
+	cfarg_t farg = {m,B,tab,filt,visited,done,cyc,cl};
+	pool_run(S,CENSUS_CHUNK,nt,census_fwd,&farg,NULL);
+	free(visited);
+
+	// exits: walk on from each until reaching a cycle or a configuration checked before;
+	// if that is on the current walk, it is on a cycle which no thread found
+
+	clist_t* const cl0 = &cl[0];
+	memset(done,0,nbw*sizeof(word_t)); // now "checked"
+	for (size_t t=0; t<nt; ++t) {
+		for (size_t e=0; e<cl[t].exits.n; ++e) {
+			const word_t x = cl[t].exits.x[e];
+			word_t y = x;
+			uint64_t L = 0;
+			while (!BM_ON(cyc,y) && !BM_ON(done,y)) {
+				BM_SET(done,y);
+				++L;
+				y = filt(m,y,B,tab);
+			}
+			if (BM_ON(cyc,y)) continue;
+			int onwalk = 0;
+			word_t z = x;
+			for (uint64_t i=0; i<L && !onwalk; ++i, z = filt(m,z,B,tab)) onwalk = z == y;
+			if (onwalk) census_cycle_add(cl0,y,m,B,tab,filt,cyc);
+		}
+		free(cl[t].exits.d);
+		free(cl[t].exits.x);
+	}
+	free(done);
+
+	// gather the cycles
+
+	cen->ncycles = 0;
+	for (size_t t=0; t<nt; ++t) cen->ncycles += cl[t].n;
+	cen->cycles = malloc((cen->ncycles > 0 ? cen->ncycles : 1)*sizeof(cycle_t));
+	TEST_ALLOC(cen->cycles);
+	for (size_t t=0, c=0; t<nt; c += cl[t].n, ++t) {
+		if (cl[t].n > 0) memcpy(cen->cycles+c,cl[t].c,cl[t].n*sizeof(cycle_t));
+		free(cl[t].c);
+	}
+
+	// basins and transient lengths: backward exploration, cycles shared out dynamically
+
+	size_t next = 0;
+#ifdef HAVE_PTHREADS
+	pthread_mutex_t mutex;
+	pthread_mutex_init(&mutex,NULL);
+#endif
+	cbarg_t args[nt];
+	for (size_t t=0; t<nt; ++t) {
+		args[t].m       = m;
+		args[t].B       = B;
+		args[t].tab     = tab;
+		args[t].filt    = filt;
+		args[t].cyc     = cyc;
+		args[t].cycles  = cen->cycles;
+		args[t].ncycles = cen->ncycles;
+		args[t].ndepths = 0;
+		args[t].dhist   = NULL;
+		args[t].pnext   = &next;
+#ifdef HAVE_PTHREADS
+		args[t].mutex   = nt > 1 ? &mutex : NULL;
+#endif
+	}
+#ifdef HAVE_PTHREADS
+	if (nt > 1) {
+		pthread_t threads[nt];
+		for (size_t t=0; t<nt; ++t) {
+			const int tres = pthread_create(&threads[t],NULL,census_basins,(void*)&args[t]);
+			PASSERT(tres == 0,"unable to create thread %zu",t+1);
+		}
+		for (size_t t=0; t<nt; ++t) {
+			const int tres = pthread_join(threads[t],NULL);
+			PASSERT(tres == 0,"unable to join thread %zu",t+1);
+		}
+	}
+	else
+#endif
+	census_basins((void*)&args[0]);
+#ifdef HAVE_PTHREADS
+	pthread_mutex_destroy(&mutex);
+#endif
+	free(cyc);
+
+	// merge depth histograms
+
+	cen->ndepths = 0;
+	for (size_t t=0; t<nt; ++t) {
+		for (size_t d=0; d<args[t].ndepths; ++d) if (args[t].dhist[d] > 0 && d+1 > cen->ndepths) cen->ndepths = d+1;
+	}
+	cen->dhist = calloc(cen->ndepths > 0 ? cen->ndepths : 1,sizeof(uint64_t)); // zero-initialises
+	TEST_ALLOC(cen->dhist);
+	for (size_t t=0; t<nt; ++t) {
+		for (size_t d=0; d<args[t].ndepths && d<cen->ndepths; ++d) cen->dhist[d] += args[t].dhist[d];
+		free(args[t].dhist);
+	}
+
+	qsort(cen->cycles,cen->ncycles,sizeof(cycle_t),census_cycle_comp);
+
+	return cen;
+}
+
+void census_free(census_t* const cen)
+{
+	if (cen == NULL) return;
+	free(cen->dhist);
+	free(cen->cycles);
+	free(cen);
+}
+
+void census_print(const census_t* const cen, const size_t maxcycles)
+{
+	const double S = (double)POW2(cen->m);
+	uint64_t ncyc = 0, lmax = 0;
+	for (size_t c=0; c<cen->ncycles; ++c) {
+		ncyc += cen->cycles[c].len;
+		if (cen->cycles[c].len > lmax) lmax = cen->cycles[c].len;
+	}
+	double tmean = 0.0;
+	for (size_t d=1; d<cen->ndepths; ++d) tmean += (double)d*(double)cen->dhist[d];
+	printf("ring length = %d : %zu cycles (%"PRIu64" cyclic configurations, longest cycle = %"PRIu64")\n",cen->m,cen->ncycles,ncyc,lmax);
+	printf("Garden-of-Eden fraction = %8.6f, mean transient = %g, max transient = %zu\n",(double)cen->ngoe/S,tmean/S,cen->ndepths > 0 ? cen->ndepths-1 : 0);
+	const size_t nc = cen->ncycles < maxcycles ? cen->ncycles : maxcycles;
+	for (size_t c=0; c<nc; ++c) {
+		const cycle_t* const cyc = &cen->cycles[c];
+		printf("\tcycle %3zu : length = %8"PRIu64", basin = %10"PRIu64" (%6.4f), max transient = %"PRIu64"\n",c+1,cyc->len,cyc->basin,(double)cyc->basin/S,cyc->depth);
+	}
+	if (nc < cen->ncycles) printf("\t... (%zu more)\n",cen->ncycles-nc);
+}
+
+int census_write(const census_t* const cen, const int B, const word_t* const tab, const char* const fname)
+{
+	// Format (native byte order): magic "CACENS01", int32 ring length, int32 rule size, the
+	// packed rule table (rt_nwords(size) 64-bit words), uint64 GoE count, uint64 number
+	// of cycles, uint64 depth histogram length, then per cycle: uint64 representative,
+	// length, basin size, max transient; then the uint64 depth histogram. Returns 0 on failure.
+	FILE* const fs = fopen(fname,"wb");
+	if (fs == NULL) return 0;
+	const int32_t hdr[2] = {cen->m,B};
+	const size_t nrw = rt_nwords(B);
+	word_t rwords[nrw];
+	rt_to_mwords(B,tab,nrw,rwords);
+	const uint64_t cnts[3] = {cen->ngoe,cen->ncycles,cen->ndepths};
+	int ok = fwrite("CACENS01",1,8,fs) == 8;
+	ok = ok && fwrite(hdr,sizeof(int32_t),2,fs) == 2;
+	ok = ok && fwrite(rwords,sizeof(word_t),nrw,fs) == nrw;
+	ok = ok && fwrite(cnts,sizeof(uint64_t),3,fs) == 3;
+	for (size_t c=0; ok && c<cen->ncycles; ++c) {
+		const uint64_t rec[4] = {cen->cycles[c].rep,cen->cycles[c].len,cen->cycles[c].basin,cen->cycles[c].depth};
+		ok = fwrite(rec,sizeof(uint64_t),4,fs) == 4;
+	}
+	ok = ok && fwrite(cen->dhist,sizeof(uint64_t),cen->ndepths,fs) == cen->ndepths;
+	if (fclose(fs) == -1) ok = 0;
+	return ok;
+}
@@ -0,0 +1,40 @@
+#ifndef CENSUS_H
+#define CENSUS_H
+
+#include "word.h"
+
+/*********************************************************************/
+/*       attractor/basin census of the global map on rings           */
+/*********************************************************************/
+
+// The rule (cyclic on rings of length m) defines a functional graph on all
+// 2^m configurations. The census walks it once: cycles are found by forward
+// walks from start configurations shared out between threads, which claim
+// configurations atomically in a visited bitmap, then each basin is explored
+// backwards from its cycle by preimage enumeration (de Bruijn walks), with
+// basins shared out between threads.
+
+#define CENSUS_MAXB 24 // largest rule: each thread holds 2^(B+7) preimage transitions
+
+typedef struct {
+	word_t   rep;   // cycle representative (smallest configuration on cycle)
+	uint64_t len;   // cycle length
+	uint64_t basin; // basin size (including cycle)
+	uint64_t depth; // maximum transient length in basin
+} cycle_t;
+
+typedef struct {
+	int       m;
+	uint64_t  ngoe;    // number of Garden-of-Eden configurations
+	size_t    ncycles;
+	cycle_t*  cycles;  // sorted by basin size (largest first)
+	size_t    ndepths;
+	uint64_t* dhist;   // number of configurations by transient length (0 = on cycle)
+} census_t;
+
+census_t* census_run   (const int m, const int B, const word_t* const tab, const int nthreads);
+void      census_free  (census_t* const cen);
+void      census_print (const census_t* const cen, const size_t maxcycles);
+int       census_write (const census_t* const cen, const int B, const word_t* const tab, const char* const fname);
+
+#endif // CENSUS_H
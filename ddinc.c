@@ -0,0 +1,204 @@
+#include "ddinc.h"
+#include "rtab.h"
+#include "utils.h"
+
+/*********************************************************************/
+/*       incremental dynamical dependence (single-entry flips)       */
+/*********************************************************************/
+
+static inline void ddi_count(ddi_t* const ddi, const word_t u, const word_t v, const int inc)
+{
+	// add (inc = 1) or remove (inc = 0) a configuration with filtered state u and successor v
+	uint64_t* const n1 = ddi->bin+u;
+	uint64_t* const n2 = ddi->bin2+(u+ddi->S*v);
+	const double* const g = ddi->nlogn;
+	if (inc) {
+		ddi->A1 += g[*n1+1]-g[*n1]; ++*n1;
+		ddi->A2 += g[*n2+1]-g[*n2]; ++*n2;
+	}
+	else {
+		ddi->A1 += g[*n1-1]-g[*n1]; --*n1;
+		ddi->A2 += g[*n2-1]-g[*n2]; --*n2;
+	}
+}
+
+static size_t ddi_windows(const int m, const word_t w, const int B, word_t* const win)
+{
+	// distinct (cyclic) windows of size B in the m-bit word w; returns number found
+	const word_t BMASK = WONES>>(WBITS-B);
+	word_t w2 = (w<<m)|w; // double-up word (cf. wd_filter)
+	size_t nw = 0;
+	for (int i=0; i<m; ++i, w2>>=1) {
+		const word_t r = w2&BMASK;
+		size_t j = 0;
+		while (j < nw && win[j] != r) ++j;
+		if (j == nw) win[nw++] = r;
+	}
+	return nw;
+}
+
+static void ddi_lists(const ddi_t* const ddi, const int B, const word_t* const w1, const word_t* const w2, size_t** const pidx, uint32_t** const plst)
+{
+	// build entry -> configuration lists (compressed rows) for windows of w1 (and w2, if not NULL)
+	const size_t S = ddi->S;
+	const size_t R = POW2(B);
+	const int m = ddi->m;
+	word_t win[2*WBITS];
+	size_t* const idx = calloc(R+1,sizeof(size_t)); // zero-initialises
+	TEST_ALLOC(idx);
+	for (size_t x=0; x<S; ++x) { // first pass: count
+		size_t nw = ddi_windows(m,w1[x],B,win);
+		if (w2 != NULL) {
+			word_t win2[WBITS];
+			const size_t nw2 = ddi_windows(m,w2[x],B,win2);
+			for (size_t k=0; k<nw2; ++k) {
+				size_t j = 0;
+				while (j < nw && win[j] != win2[k]) ++j;
+				if (j == nw) win[nw++] = win2[k];
+			}
+		}
+		for (size_t k=0; k<nw; ++k) ++idx[win[k]+1];
+	}
+	for (size_t r=0; r<R; ++r) idx[r+1] += idx[r]; // cumulative
+	uint32_t* const lst = malloc(idx[R]*sizeof(uint32_t));
+	TEST_ALLOC(lst);
+	size_t* const pos = malloc(R*sizeof(size_t)); // fill positions
+	TEST_ALLOC(pos);
+	memcpy(pos,idx,R*sizeof(size_t));
+	for (size_t x=0; x<S; ++x) { // second pass: fill
+		size_t nw = ddi_windows(m,w1[x],B,win);
+		if (w2 != NULL) {
+			word_t win2[WBITS];
+			const size_t nw2 = ddi_windows(m,w2[x],B,win2);
+			for (size_t k=0; k<nw2; ++k) {
+				size_t j = 0;
+				while (j < nw && win[j] != win2[k]) ++j;
+				if (j == nw) win[nw++] = win2[k];
+			}
+		}
+		for (size_t k=0; k<nw; ++k) lst[pos[win[k]]++] = (uint32_t)x;
+	}
+	free(pos);
+	free(*plst);
+	free(*pidx);
+	*pidx = idx;
+	*plst = lst;
+}
+
+static void ddi_build(ddi_t* const ddi)
+{
+	// (re)compute CA states, histograms and entry lists from scratch
+	const size_t S = ddi->S;
+	const int m = ddi->m;
+	for (size_t y=0; y<S;   ++y) ddi->bin[y]  = 0;
+	for (size_t y=0; y<S*S; ++y) ddi->bin2[y] = 0;
+	ddi->A1 = 0.0;
+	ddi->A2 = 0.0;
+	for (word_t x=WZERO; x<S; ++x) {
+		word_t y = x;
+		for (int i=0; i<ddi->iff; ++i) y = wd_filter(m,y,ddi->rsiz,ddi->rtab);  // advance CA (may be zero)
+		word_t z = y;
+		for (int i=0; i<ddi->ilag; ++i) z = wd_filter(m,z,ddi->rsiz,ddi->rtab); // advance CA (at least 1)
+		ddi->y[x] = y;
+		ddi->z[x] = z;
+		ddi->u[x] = wd_filter(m,y,ddi->fsiz,ddi->ftab);
+		ddi->v[x] = wd_filter(m,z,ddi->fsiz,ddi->ftab);
+		ddi_count(ddi,ddi->u[x],ddi->v[x],1);
+	}
+	ddi_lists(ddi,ddi->fsiz,ddi->y,ddi->z,&ddi->fidx,&ddi->flst);
+	ddi->fstale = 0;
+	if (ddi->iff == 0 && ddi->ilag == 1) ddi_lists(ddi,ddi->rsiz,ddi->y,NULL,&ddi->ridx,&ddi->rlst);
+}
+
+ddi_t* ddi_alloc(const int rsiz, const word_t* const rtab, const int fsiz, const word_t* const ftab, const int m, const int iff, const int ilag)
+{
+	ASSERT(2*m <= WBITS,"sequence too long");
+	ASSERT(rsiz <= m && fsiz <= m,"sequence shorter than rule");
+	ddi_t* const ddi = malloc(sizeof(ddi_t));
+	TEST_ALLOC(ddi);
+	const size_t S = POW2(m);
+	TEST_RAM(S*S*sizeof(uint64_t));
+	ddi->rsiz  = rsiz;
+	ddi->fsiz  = fsiz;
+	ddi->m     = m;
+	ddi->iff   = iff;
+	ddi->ilag  = ilag;
+	ddi->S     = S;
+	ddi->rtab  = rt_alloc(rsiz);
+	ddi->ftab  = rt_alloc(fsiz);
+	rt_copy(rsiz,ddi->rtab,rtab);
+	rt_copy(fsiz,ddi->ftab,ftab);
+	ddi->y     = mw_alloc(S);
+	ddi->z     = mw_alloc(S);
+	ddi->u     = mw_alloc(S);
+	ddi->v     = mw_alloc(S);
+	ddi->bin   = malloc(S*sizeof(uint64_t));
+	TEST_ALLOC(ddi->bin);
+	ddi->bin2  = malloc(S*S*sizeof(uint64_t));
+	TEST_ALLOC(ddi->bin2);
+	ddi->nlogn = malloc((S+1)*sizeof(double));
+	TEST_ALLOC(ddi->nlogn);
+	for (size_t n=0; n<=S; ++n) ddi->nlogn[n] = xlog2x((double)n);
+	ddi->fidx  = NULL;
+	ddi->flst  = NULL;
+	ddi->ridx  = NULL;
+	ddi->rlst  = NULL;
+	ddi_build(ddi);
+	return ddi;
+}
+
+void ddi_free(ddi_t* const ddi)
+{
+	if (ddi == NULL) return;
+	free(ddi->rlst);
+	free(ddi->ridx);
+	free(ddi->flst);
+	free(ddi->fidx);
+	free(ddi->nlogn);
+	free(ddi->bin2);
+	free(ddi->bin);
+	free(ddi->v);
+	free(ddi->u);
+	free(ddi->z);
+	free(ddi->y);
+	free(ddi->ftab);
+	free(ddi->rtab);
+	free(ddi);
+}
+
+void ddi_flip_filt(ddi_t* const ddi, const size_t r)
+{
+	ASSERT(r < POW2(ddi->fsiz),"filter table entry out of range");
+	if (ddi->fstale) {
+		ddi_lists(ddi,ddi->fsiz,ddi->y,ddi->z,&ddi->fidx,&ddi->flst);
+		ddi->fstale = 0;
+	}
+	RTFLIP(ddi->ftab,r);
+	const int m = ddi->m;
+	for (const uint32_t* px=ddi->flst+ddi->fidx[r]; px<ddi->flst+ddi->fidx[r+1]; ++px) {
+		const size_t x = *px;
+		ddi_count(ddi,ddi->u[x],ddi->v[x],0);
+		ddi->u[x] = wd_filter(m,ddi->y[x],ddi->fsiz,ddi->ftab);
+		ddi->v[x] = wd_filter(m,ddi->z[x],ddi->fsiz,ddi->ftab);
+		ddi_count(ddi,ddi->u[x],ddi->v[x],1);
+	}
+}
+
+void ddi_flip_rule(ddi_t* const ddi, const size_t r)
+{
+	ASSERT(r < POW2(ddi->rsiz),"rule table entry out of range");
+	RTFLIP(ddi->rtab,r);
+	if (ddi->ridx == NULL) { // no entry lists (advance or lag) - the flip propagates everywhere
+		ddi_build(ddi);
+		return;
+	}
+	const int m = ddi->m;
+	for (const uint32_t* px=ddi->rlst+ddi->ridx[r]; px<ddi->rlst+ddi->ridx[r+1]; ++px) {
+		const size_t x = *px; // note: y = x here, so u is unaffected
+		ddi_count(ddi,ddi->u[x],ddi->v[x],0);
+		ddi->z[x] = wd_filter(m,ddi->y[x],ddi->rsiz,ddi->rtab);
+		ddi->v[x] = wd_filter(m,ddi->z[x],ddi->fsiz,ddi->ftab);
+		ddi_count(ddi,ddi->u[x],ddi->v[x],1);
+	}
+	ddi->fstale = 1; // successor windows have changed
+}
@@ -0,0 +1,56 @@
+#ifndef DDINC_H
+#define DDINC_H
+
+#include "word.h"
+
+/*********************************************************************/
+/*       incremental dynamical dependence (single-entry flips)       */
+/*********************************************************************/
+
+// Maintains the histograms behind rt_entro/rt_dd for a CA/filter pair on
+// sequences of length m, together with (for each rule/filter table entry)
+// the list of configurations whose windows hit that entry. Flipping a table
+// entry then only touches the affected configurations, and the filter
+// entropy and DD are updated in time proportional to their number.
+
+typedef struct {
+	int       rsiz;
+	int       fsiz;
+	int       m;
+	int       iff;
+	int       ilag;
+	size_t    S;     // number of configurations (2^m)
+	word_t*   rtab;  // own copy of CA rule table
+	word_t*   ftab;  // own copy of filter rule table
+	word_t*   y;     // CA state at filtering time, per configuration
+	word_t*   z;     // CA state after lag, per configuration
+	word_t*   u;     // filtered y
+	word_t*   v;     // filtered z
+	uint64_t* bin;   // filtered state histogram (2^m)
+	uint64_t* bin2;  // filtered state/successor histogram (2^(2m))
+	double*   nlogn; // n*log2(n) for n = 0,...,S
+	double    A1;    // sum of n*log2(n) over bin
+	double    A2;    // sum of n*log2(n) over bin2
+	size_t*   fidx;  // filter entry -> configurations (compressed row offsets)
+	uint32_t* flst;
+	int       fstale; // filter lists need rebuilding (CA states have changed)
+	size_t*   ridx;  // rule entry -> configurations (only for iff = 0, ilag = 1)
+	uint32_t* rlst;
+} ddi_t;
+
+ddi_t* ddi_alloc     (const int rsiz, const word_t* const rtab, const int fsiz, const word_t* const ftab, const int m, const int iff, const int ilag);
+void   ddi_free      (ddi_t* const ddi);
+void   ddi_flip_filt (ddi_t* const ddi, const size_t r);
+void   ddi_flip_rule (ddi_t* const ddi, const size_t r);
+
+static inline double ddi_entro(const ddi_t* const ddi) // filtered entropy H(U) (cf. rt_entro)
+{
+	return (double)ddi->m-ddi->A1/(double)ddi->S;
+}
+
+static inline double ddi_dd(const ddi_t* const ddi) // dynamical dependence H(V|U) (cf. rt_dd)
+{
+	return (ddi->A1-ddi->A2)/(double)ddi->S;
+}
+
+#endif // DDINC_H
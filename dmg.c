@@ -0,0 +1,178 @@
+#include "dmg.h"
+#include "rtab.h"
+
+/*********************************************************************/
+/*        damage spreading and maximum Lyapunov exponent             */
+/*********************************************************************/
+
+static inline size_t dmg_lo(const size_t n, const word_t* const d)
+{
+	// lowest set cell (n*WBITS if none)
+	for (size_t k=0;k<n;++k) if (d[k]) return k*WBITS+(size_t)__builtin_ctzll(d[k]);
+	return n*WBITS;
+}
+
+static inline size_t dmg_hi(const size_t n, const word_t* const d)
+{
+	// highest set cell (n*WBITS if none)
+	for (size_t k=n;k-->0;) if (d[k]) return k*WBITS+(size_t)(WBITS-1-__builtin_clzll(d[k]));
+	return n*WBITS;
+}
+
+static inline size_t dmg_hamming(const size_t n, const word_t* const w1, const word_t* const w2, word_t* const d)
+{
+	size_t b = 0;
+	for (size_t k=0;k<n;++k) b += (size_t)__builtin_popcountll(d[k] = w1[k]^w2[k]);
+	return b;
+}
+
+static double dmg_paths(const size_t n, const int B, const word_t* const D, const double* const xi, double* const xinew)
+{
+	// one step of the linearised dynamics; returns |xi(t+1)| (xinew normalised)
+	const size_t N = n*WBITS;
+	for (size_t i=0;i<N;++i) xinew[i] = 0.0;
+	for (int j=0;j<B;++j) {
+		const word_t* const Dj = D+(size_t)j*n;
+		for (size_t k=0;k<n;++k) {
+			for (word_t u=Dj[k]; u; u &= u-1) {
+				const size_t i = k*WBITS+(size_t)__builtin_ctzll(u);
+				const size_t ij = i+(size_t)j;
+				xinew[i] += xi[ij < N ? ij : ij-N];
+			}
+		}
+	}
+	double s = 0.0;
+	for (size_t i=0;i<N;++i) s += xinew[i];
+	if (s > 0.0) for (size_t i=0;i<N;++i) xinew[i] /= s;
+	return s;
+}
+
+dmg_t* dmg_run
+(
+	const size_t        n,
+	const int           B,
+	const word_t* const rtab,
+	const mw_filter_t   kernel,
+	const size_t        T,
+	const size_t        nruns,
+	const double        pflip,
+	const ulong         iseed
+)
+{
+	ASSERT(T > 0 && nruns > 0,"need at least one generation and one run");
+	ASSERT((size_t)B <= n*WBITS,"rule size exceeds row length");
+
+	dmg_t* const dmg = malloc(sizeof(dmg_t));
+	TEST_ALLOC(dmg);
+	dmg->T     = T;
+	dmg->nruns = nruns;
+	dmg->ham   = calloc(2*(T+1),sizeof(double)); // zero-initialises
+	TEST_ALLOC(dmg->ham);
+	dmg->alive = dmg->ham+(T+1);
+
+	const mw_filter_t filt = kernel != NULL ? kernel : mw_filter_sel(B);
+	const mw_filter_t dfilt = mw_filter_sel(B); // derivative tables are not structured
+	const size_t N  = n*WBITS;
+	const size_t x0 = N/2;      // single-cell damage site
+	const size_t C  = (size_t)(B/2);
+
+	// Boolean derivative tables: dtab_j[r] = tab[r] XOR tab[r with input j flipped]
+
+	const size_t nw = rt_nwords(B);
+	word_t* const dtab = calloc((size_t)B*nw,sizeof(word_t)); // zero-initialises
+	TEST_ALLOC(dtab);
+	for (int j=0;j<B;++j) {
+		word_t* const dtj = dtab+(size_t)j*nw;
+		for (size_t r=0;r<POW2(B);++r) RTSET(dtj,r,RTBIT(rtab,r)^RTBIT(rtab,r^POW2(j)));
+	}
+
+	word_t* const wbuf = mw_alloc((5+(size_t)B)*n);
+	word_t* w1   = wbuf;
+	word_t* w2   = wbuf+n;
+	word_t* w1n  = wbuf+2*n;
+	word_t* w2n  = wbuf+3*n;
+	word_t* const d = wbuf+4*n;
+	word_t* const D = wbuf+5*n; // B derivative rows
+	double* const xbuf = malloc(2*N*sizeof(double));
+	TEST_ALLOC(xbuf);
+	double* xi    = xbuf;
+	double* xinew = xbuf+N;
+
+	size_t nsurv = 0, nlyap = 0, nvel = 0;
+	double lyap = 0.0, vleft = 0.0, vright = 0.0;
+	for (size_t r=0;r<nruns;++r) {
+		mt_t irng;
+		mt_seed(&irng,iseed == 0 ? 0 : iseed+r); // independent stream per run
+		mw_randomise(n,w1,&irng);
+		mw_copy(n,w2,w1);
+		if (pflip > 0.0) wm_noisify(n,w2,pflip,&irng);
+		if (pflip <= 0.0 || mw_equal(n,w1,w2)) FLIPBIT(w2[x0/WBITS],x0%WBITS);
+		const double h0 = (double)dmg_hamming(n,w1,w2,d);
+		for (size_t i=0;i<N;++i) xi[i] = (double)(WONE&(d[i/WBITS]>>(i%WBITS)))/h0;
+		dmg->ham[0]   += h0/(double)N;
+		dmg->alive[0] += 1.0;
+
+		double lsum = 0.0;
+		int lalive = 1;
+		size_t tv = 0; // last valid fronts (single-cell damage), relative to damage site
+		double left = 0.0, right = 0.0;
+		int fvalid = pflip <= 0.0;
+		size_t h = 1;
+		for (size_t t=1;t<=T;++t) {
+			if (lalive) { // linearised dynamics along the trajectory of w1
+				for (int j=0;j<B;++j) dfilt(n,D+(size_t)j*n,w1,B,dtab+(size_t)j*nw);
+				const double s = dmg_paths(n,B,D,xi,xinew);
+				if (s > 0.0) {lsum += log(s); SWAP(double*,xi,xinew);} else lalive = 0;
+			}
+			filt(n,w1n,w1,B,rtab);
+			SWAP(word_t*,w1,w1n);
+			if (h == 0) continue; // twins have merged (for good)
+			filt(n,w2n,w2,B,rtab);
+			SWAP(word_t*,w2,w2n);
+			h = dmg_hamming(n,w1,w2,d);
+			if (h == 0) continue;
+			dmg->ham[t]   += (double)h/(double)N;
+			dmg->alive[t] += 1.0;
+			if (fvalid) { // fronts in the physical frame (twisted by C cells per generation)
+				mw_rotl(n,w1n,d,(t*C)%N);
+				const size_t lo = dmg_lo(n,w1n), hi = dmg_hi(n,w1n);
+				if (lo == 0 || hi == N-1) fvalid = 0; // damage reached row ends
+				else {tv = t; left = (double)x0-(double)lo; right = (double)hi-(double)x0;}
+			}
+		}
+		if (lalive) {lyap += lsum/(double)T; ++nlyap;}
+		if (h > 0) {
+			++nsurv;
+			if (pflip <= 0.0 && tv > 0) {
+				vleft  += left /(double)tv;
+				vright += right/(double)tv;
+				++nvel;
+			}
+		}
+	}
+	for (size_t t=0;t<=T;++t) {dmg->ham[t] /= (double)nruns; dmg->alive[t] /= (double)nruns;}
+	dmg->lyap   = nlyap > 0 ? lyap/(double)nlyap : -INFINITY;
+	dmg->plyap  = (double)nlyap/(double)nruns;
+	dmg->vleft  = nvel > 0 ? vleft /(double)nvel : NAN;
+	dmg->vright = nvel > 0 ? vright/(double)nvel : NAN;
+	dmg->psurv  = (double)nsurv/(double)nruns;
+
+	free(xbuf);
+	free(wbuf);
+	free(dtab);
+
+	return dmg;
+}
+
+void dmg_free(dmg_t* const dmg)
+{
+	if (dmg == NULL) return;
+	free(dmg->ham); // includes alive
+	free(dmg);
+}
+
+void dmg_print(const dmg_t* const dmg)
+{
+	printf("Lyapunov = %8.6f (%.3f), velocity left = %6.4f, right = %6.4f, damage = %8.6f (survival = %.3f)\n",
+		dmg->lyap,dmg->plyap,dmg->vleft,dmg->vright,dmg->ham[dmg->T],dmg->psurv);
+}
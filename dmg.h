@@ -0,0 +1,51 @@
+#ifndef DMG_H
+#define DMG_H
+
+#include "word.h"
+
+/*********************************************************************/
+/*        damage spreading and maximum Lyapunov exponent             */
+/*********************************************************************/
+
+// Each run steps a random row alongside a twin differing in one cell (at the
+// middle of the row), or in cells flipped independently with probability
+// pflip. The damage (XOR of the twins) is measured word-parallel: its size by
+// popcount, its left/right fronts by ctz/clz, in the physical (untwisted)
+// frame and until the damage wraps around the row. Front velocities are in
+// cells per generation (positive for spreading) for runs in which the damage
+// survives; they are only defined for single-cell damage.
+//
+// The maximum Lyapunov exponent is that of the linearised dynamics (Bagnoli,
+// Rechtman and Ruffo, 1992): the number of damage paths xi evolves as
+// xi_i(t+1) = sum_j D_j[i](t) xi_{i+j}(t), where the Boolean derivative D_j
+// (output cell i sensitive to input cell i+j) is computed word-parallel from
+// the rule table with input j flipped, and lambda = (1/T) ln |xi(T)|.
+
+typedef struct {
+	size_t  T;      // number of generations
+	size_t  nruns;  // number of runs (seeds)
+	double* ham;    // T+1 : mean damage (normalised Hamming distance between twins)
+	double* alive;  // T+1 : fraction of runs with damage
+	double  lyap;   // mean maximum Lyapunov exponent, over runs in which xi survives
+	double  plyap;  // fraction of runs in which xi survives
+	double  vleft;  // mean left front velocity (NaN if not defined)
+	double  vright; // mean right front velocity (NaN if not defined)
+	double  psurv;  // fraction of runs in which damage survives
+} dmg_t;
+
+dmg_t* dmg_run
+(
+	const size_t        n,
+	const int           B,
+	const word_t* const rtab,
+	const mw_filter_t   kernel, // NULL for default
+	const size_t        T,
+	const size_t        nruns,
+	const double        pflip,  // 0 for single-cell damage
+	const ulong         iseed   // run r seeded with iseed+r (0 for unpredictable)
+);
+
+void dmg_free  (dmg_t* const dmg);
+void dmg_print (const dmg_t* const dmg);
+
+#endif // DMG_H
@@ -0,0 +1,283 @@
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "ens.h"
+#include "utils.h"
+
+/*********************************************************************/
+/*       ensembles of CA rows with streaming statistics              */
+/*********************************************************************/
+
+static void ens_blocks(const size_t n, const word_t* const w, const int K, size_t* const c)
+{
+	// count (cyclic) blocks of K cells starting at each cell (cf. mw_get_part)
+	const word_t mask = POW2(K)-1;
+	for (size_t k=0;k<n;++k) {
+		const word_t lo = w[k];
+		const word_t hi = w[k+1 < n ? k+1 : 0];
+		++c[lo&mask];
+		for (int i=1;i<WBITS;++i) ++c[((lo>>i)|(hi<<(WBITS-i)))&mask];
+	}
+}
+
+static inline size_t ens_popcount(const size_t n, const word_t* const w)
+{
+	size_t b = 0;
+	for (size_t k=0;k<n;++k) b += (size_t)__builtin_popcountll(w[k]);
+	return b;
+}
+
+static inline size_t ens_hamming(const size_t n, const word_t* const w1, const word_t* const w2)
+{
+	size_t b = 0;
+	for (size_t k=0;k<n;++k) b += (size_t)__builtin_popcountll(w1[k]^w2[k]);
+	return b;
+}
+
+static inline void ens_welford(const size_t k, const double x, double* const mean, double* const m2)
+{
+	// running mean and sum of squared deviations; x is sample number k (1-based)
+	const double d = x-*mean;
+	*mean += d/(double)k;
+	*m2   += d*(x-*mean);
+}
+
+typedef struct {
+	const ens_t*    ens;
+	int             B;
+	const word_t*   rtab;
+	mw_filter_t     filt;
+	double          p0;
+	ulong           iseed;
+	size_t          chunk;
+	size_t          next;  // next member to hand out
+#ifdef HAVE_PTHREADS
+	pthread_mutex_t mutex;
+#endif
+} earg_t;
+
+typedef struct {
+	earg_t* a;
+	size_t  nm;    // members run by this thread
+	double* mean;  // I x nobs
+	double* m2;    // I x nobs
+} ethr_t;
+
+static void* ens_thread(void* arg)
+{
+	ethr_t* const th = (ethr_t*)arg;
+	earg_t* const a = th->a;
+	const ens_t* const ens = a->ens;
+	const size_t E = ens->E, I = ens->I, n = ens->n, nobs = ens->nobs, chunk = a->chunk;
+	const int    obs = ens->obs, K = ens->K, B = a->B;
+	const size_t nbk = (obs&ENS_BLOCK) ? POW2(K) : 0;
+	const size_t jb  = (obs&ENS_DENS) ? 1 : 0;  // first block observable
+	const size_t jh  = jb+nbk;                   // Hamming observable
+	const double ncells = (double)(n*WBITS);
+
+	word_t* wold = mw_alloc(chunk*n);
+	word_t* wnew = mw_alloc(chunk*n);
+	size_t* const bcnt = malloc((nbk > 0 ? nbk : 1)*sizeof(size_t));
+	TEST_ALLOC(bcnt);
+
+	while (1) {
+#ifdef HAVE_PTHREADS
+		pthread_mutex_lock(&a->mutex);
+#endif
+		const size_t e0 = a->next;
+		a->next += chunk;
+#ifdef HAVE_PTHREADS
+		pthread_mutex_unlock(&a->mutex);
+#endif
+		if (e0 >= E) break;
+		const size_t ne = e0+chunk <= E ? chunk : E-e0;
+
+		for (size_t e=0;e<ne;++e) {
+			xr_t irng;
+			xr_seed(&irng,a->iseed == 0 ? 0 : a->iseed+e0+e); // independent stream per member
+			if (a->p0 == 0.5) mw_randomise_xr(n,wold+e*n,&irng); else mw_randomiseb_xr(n,wold+e*n,a->p0,&irng);
+		}
+
+		for (size_t t=0;t<I;++t) {
+			double* const mt = th->mean+t*nobs;
+			double* const m2 = th->m2  +t*nobs;
+			for (size_t e=0;e<ne;++e) {
+				const word_t* const w = wold+e*n;
+				const size_t k = th->nm+e+1; // sample number
+				if (obs&ENS_DENS) ens_welford(k,(double)ens_popcount(n,w)/ncells,mt,m2);
+				if (obs&ENS_BLOCK) {
+					memset(bcnt,0,nbk*sizeof(size_t));
+					ens_blocks(n,w,K,bcnt);
+					for (size_t b=0;b<nbk;++b) ens_welford(k,(double)bcnt[b]/ncells,mt+jb+b,m2+jb+b);
+				}
+				if ((obs&ENS_HAMM) && e%2 == 1) ens_welford(k/2,(double)ens_hamming(n,w-n,w)/ncells,mt+jh,m2+jh);
+			}
+			if (t+1 == I) break;
+			for (size_t e=0;e<ne;++e) a->filt(n,wnew+e*n,wold+e*n,B,a->rtab);
+			SWAP(word_t*,wnew,wold);
+		}
+		th->nm += ne;
+	}
+
+	free(bcnt);
+	free(wnew);
+	free(wold);
+	return NULL;
+}
+
+ens_t* ens_run
+(
+	const size_t        E,
+	const size_t        I,
+	const size_t        n,
+	const int           B,
+	const word_t* const rtab,
+	const mw_filter_t   kernel,
+	const int           obs,
+	const int           K,
+	const double        p0,
+	const ulong         iseed,
+	const int           nthreads,
+	const size_t        chunk
+)
+{
+	ASSERT(E > 1 && I > 0,"need at least two members and one generation");
+	ASSERT(!(obs&ENS_BLOCK) || (K >= 1 && K <= ENS_MAXK),"block length must be 1 - %d",ENS_MAXK);
+	ASSERT(!(obs&ENS_HAMM) || (E%2 == 0 && chunk%2 == 0),"ensemble size and chunk size must be even for Hamming distance");
+	ASSERT(chunk > 0,"chunk size must be positive");
+
+	ens_t* const ens = malloc(sizeof(ens_t));
+	TEST_ALLOC(ens);
+	ens->E    = E;
+	ens->I    = I;
+	ens->n    = n;
+	ens->obs  = obs;
+	ens->K    = (obs&ENS_BLOCK) ? K : 0;
+	ens->nobs = ((obs&ENS_DENS) ? 1 : 0)+((obs&ENS_BLOCK) ? POW2(K) : 0)+((obs&ENS_HAMM) ? 1 : 0);
+	ASSERT(ens->nobs > 0,"no observables selected");
+	const size_t nobs = ens->nobs;
+	ens->cnt  = malloc(nobs*sizeof(size_t));
+	TEST_ALLOC(ens->cnt);
+	for (size_t j=0;j<nobs;++j) ens->cnt[j] = E;
+	if (obs&ENS_HAMM) ens->cnt[nobs-1] = E/2;
+	ens->mean = calloc(I*nobs,sizeof(double)); // zero-initialises
+	TEST_ALLOC(ens->mean);
+	ens->var  = calloc(I*nobs,sizeof(double)); // zero-initialises
+	TEST_ALLOC(ens->var);
+
+	earg_t a;
+	a.ens   = ens;
+	a.B     = B;
+	a.rtab  = rtab;
+	a.filt  = kernel != NULL ? kernel : mw_filter_sel(B);
+	a.p0    = p0;
+	a.iseed = iseed;
+	a.chunk = chunk;
+	a.next  = 0;
+
+#ifdef HAVE_PTHREADS
+	const size_t nt = nthreads > 1 ? (size_t)nthreads : 1;
+#else
+	const size_t nt = 1;
+#endif
+	ethr_t th[nt];
+	double* const acc = calloc(2*nt*I*nobs,sizeof(double)); // zero-initialises
+	TEST_ALLOC(acc);
+	for (size_t t=0;t<nt;++t) {
+		th[t].a    = &a;
+		th[t].nm   = 0;
+		th[t].mean = acc+(2*t  )*I*nobs;
+		th[t].m2   = acc+(2*t+1)*I*nobs;
+	}
+
+#ifdef HAVE_PTHREADS
+	pthread_mutex_init(&a.mutex,NULL);
+	pthread_t threads[nt];
+	for (size_t t=0;t<nt;++t) {
+		const int tres = pthread_create(&threads[t],NULL,ens_thread,(void*)&th[t]);
+		PASSERT(tres == 0,"unable to create thread %zu",t+1);
+	}
+	for (size_t t=0;t<nt;++t) {
+		const int tres = pthread_join(threads[t],NULL);
+		PASSERT(tres == 0,"unable to join thread %zu",t+1);
+	}
+	pthread_mutex_destroy(&a.mutex);
+#else
+	ens_thread((void*)&th[0]);
+#endif
+
+	// combine per-thread accumulators (Chan et al.); the Hamming observable
+	// has one sample per pair of members
+
+	double* const m2 = ens->var; // sum of squared deviations, until normalised
+	for (size_t j=0;j<nobs;++j) {
+		const int hamm = (obs&ENS_HAMM) && j == nobs-1;
+		double na = 0.0;
+		for (size_t t=0;t<nt;++t) {
+			const double nb = (double)(hamm ? th[t].nm/2 : th[t].nm);
+			if (nb == 0.0) continue;
+			const double nab = na+nb;
+			for (size_t i=0;i<I;++i) {
+				const size_t ij = i*nobs+j;
+				const double d = th[t].mean[ij]-ens->mean[ij];
+				ens->mean[ij] += d*nb/nab;
+				m2[ij] += th[t].m2[ij]+d*d*na*nb/nab;
+			}
+			na = nab;
+		}
+		for (size_t i=0;i<I;++i) m2[i*nobs+j] = na > 1.0 ? m2[i*nobs+j]/(na-1.0) : 0.0;
+	}
+	free(acc);
+
+	return ens;
+}
+
+void ens_free(ens_t* const ens)
+{
+	if (ens == NULL) return;
+	free(ens->var);
+	free(ens->mean);
+	free(ens->cnt);
+	free(ens);
+}
+
+void ens_print(const ens_t* const ens, const size_t stride)
+{
+	// density and Hamming distance (mean and standard deviation) every stride generations
+	const size_t nobs = ens->nobs;
+	const int dens = ens->obs&ENS_DENS;
+	const int hamm = ens->obs&ENS_HAMM;
+	printf("generation");
+	if (dens) printf("      density (sd)    ");
+	if (hamm) printf("      Hamming (sd)    ");
+	if (ens->obs&ENS_BLOCK) printf("   (%zu block frequencies in output file)",POW2(ens->K));
+	putchar('\n');
+	for (size_t i=0;i<ens->I;i+=stride) {
+		const double* const mt = ens->mean+i*nobs;
+		const double* const vr = ens->var +i*nobs;
+		printf("%10zu",i);
+		if (dens) printf("    %8.6f (%8.6f)",mt[0],sqrt(vr[0]));
+		if (hamm) printf("    %8.6f (%8.6f)",mt[nobs-1],sqrt(vr[nobs-1]));
+		putchar('\n');
+	}
+}
+
+int ens_write(const ens_t* const ens, const char* const fname)
+{
+	// one line per generation: generation, then mean and variance of each observable
+	FILE* const fs = fopen(fname,"w");
+	if (fs == NULL) return 0;
+	const size_t nobs = ens->nobs;
+	fprintf(fs,"# ensemble size = %zu, row length = %zu bits, observables:",ens->E,ens->n*WBITS);
+	if (ens->obs&ENS_DENS) fprintf(fs," density");
+	if (ens->obs&ENS_BLOCK) fprintf(fs," blocks[%zu]",POW2(ens->K));
+	if (ens->obs&ENS_HAMM) fprintf(fs," Hamming");
+	fprintf(fs," (mean, variance)\n");
+	for (size_t i=0;i<ens->I;++i) {
+		fprintf(fs,"%zu",i);
+		for (size_t j=0;j<nobs;++j) fprintf(fs,"\t%.10g\t%.10g",ens->mean[i*nobs+j],ens->var[i*nobs+j]);
+		fputc('\n',fs);
+	}
+	return fclose(fs) == 0;
+}
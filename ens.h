@@ -0,0 +1,62 @@
+#ifndef ENS_H
+#define ENS_H
+
+#include "word.h"
+
+/*********************************************************************/
+/*       ensembles of CA rows with streaming statistics              */
+/*********************************************************************/
+
+// E independent rows of the same rule are advanced together, held as two
+// flat E x n generation buffers (no spacetime is kept), so that any stepping
+// kernel (tuned, native, ...) applies unchanged. Members are handed out to
+// threads in chunks; per-generation observables are computed on the fly and
+// their ensemble means and variances accumulated (Welford, with per-thread
+// accumulators combined at the end). All observables are invariant under
+// rotation, so rows are stepped in the (twisted) kernel frame.
+//
+// Observables per generation (in this order, as selected):
+//
+//   ENS_DENS  : density of set cells
+//   ENS_BLOCK : frequencies of the 2^K (cyclic) blocks of K cells
+//   ENS_HAMM  : normalised Hamming distance between members 2j and 2j+1
+
+#define ENS_DENS  1
+#define ENS_BLOCK 2
+#define ENS_HAMM  4
+
+#define ENS_MAXK 12 // maximum block length
+
+typedef struct {
+	size_t  E;     // ensemble size
+	size_t  I;     // number of generations (including initial)
+	size_t  n;     // row length (words)
+	int     obs;   // observables selected (ENS_DENS|ENS_BLOCK|ENS_HAMM)
+	int     K;     // block length (ENS_BLOCK)
+	size_t  nobs;  // observables per generation
+	size_t* cnt;   // number of samples per observable
+	double* mean;  // I x nobs means
+	double* var;   // I x nobs (unbiased) variances
+} ens_t;
+
+ens_t* ens_run
+(
+	const size_t        E,        // ensemble size (even, if ENS_HAMM)
+	const size_t        I,        // number of generations
+	const size_t        n,        // row length (words)
+	const int           B,
+	const word_t* const rtab,
+	const mw_filter_t   kernel,   // NULL for default
+	const int           obs,
+	const int           K,
+	const double        p0,       // initial density
+	const ulong         iseed,    // member e seeded with iseed+e (0 for unpredictable)
+	const int           nthreads,
+	const size_t        chunk     // members per work unit
+);
+
+void ens_free  (ens_t* const ens);
+void ens_print (const ens_t* const ens, const size_t stride);
+int  ens_write (const ens_t* const ens, const char* const fname);
+
+#endif // ENS_H
@@ -8,12 +8,18 @@
 int sim_ana   (int argc, char* argv[], int info);
 int sim_bmark (int argc, char* argv[], int info);
 int sim_test  (int argc, char* argv[], int info);
+int sim_rclass(int argc, char* argv[], int info);
+int sim_period(int argc, char* argv[], int info);
+int sim_ens   (int argc, char* argv[], int info);
+int sim_dmg   (int argc, char* argv[], int info);
 #ifdef HAVE_X11
 int sim_xplor (int argc, char* argv[], int info);
 #endif
 #ifdef HAVE_PTHREADS
 int sim_ddf   (int argc, char* argv[], int info);
 int sim_ddr   (int argc, char* argv[], int info);
+int sim_ddo   (int argc, char* argv[], int info);
+int sim_dde   (int argc, char* argv[], int info);
 #endif
 
 int main(int argc, char* argv[])
@@ -39,12 +45,18 @@ int main(int argc, char* argv[])
 	if      (strcmp(argv[1],"ana"  )  == 0) sim = sim_ana;
 	else if (strcmp(argv[1],"bmark")  == 0) sim = sim_bmark;
 	else if (strcmp(argv[1],"test" )  == 0) sim = sim_test;
+	else if (strcmp(argv[1],"rclass") == 0) sim = sim_rclass;
+	else if (strcmp(argv[1],"period") == 0) sim = sim_period;
+	else if (strcmp(argv[1],"ens"  )  == 0) sim = sim_ens;
+	else if (strcmp(argv[1],"dmg"  )  == 0) sim = sim_dmg;
 #ifdef HAVE_X11
 	else if (strcmp(argv[1],"xplor")  == 0) sim = sim_xplor;
 #endif
 #ifdef HAVE_PTHREADS
 	else if (strcmp(argv[1],"ddf"  )  == 0) sim = sim_ddf;
 	else if (strcmp(argv[1],"ddr"  )  == 0) sim = sim_ddr;
+	else if (strcmp(argv[1],"ddo"  )  == 0) sim = sim_ddo;
+	else if (strcmp(argv[1],"dde"  )  == 0) sim = sim_dde;
 #endif
 	else {
 		fprintf(stderr,"\nUnknown simulation \"%s\"\n",argv[1]);
@@ -0,0 +1,105 @@
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "pool.h"
+#include "utils.h"
+
+/*********************************************************************/
+/*                  parallel task pool                               */
+/*********************************************************************/
+
+typedef struct {
+	size_t      ntasks;
+	size_t      chunk;
+	pool_task_t task;
+	void*       arg;
+	size_t      next; // next task to hand out (atomic)
+} pool_t;
+
+typedef struct {
+	pool_t*     pool;
+	size_t      tnum;
+	pool_stat_t stat;
+} pwork_t;
+
+static void* pool_worker(void* arg)
+{
+	pwork_t* const w = (pwork_t*)arg;
+	pool_t*  const p = w->pool;
+	const double wts = get_wall_time();
+	const double cts = get_thread_cpu_time();
+	w->stat.ntasks = 0;
+	while (1) {
+		const size_t k0 = __atomic_fetch_add(&p->next,p->chunk,__ATOMIC_RELAXED);
+		if (k0 >= p->ntasks) break;
+		const size_t k1 = k0+p->chunk < p->ntasks ? k0+p->chunk : p->ntasks;
+		for (size_t k=k0;k<k1;++k) p->task(p->arg,k,w->tnum);
+		w->stat.ntasks += k1-k0;
+	}
+	w->stat.cpu  = get_thread_cpu_time()-cts;
+	w->stat.wall = get_wall_time()-wts;
+	return NULL;
+}
+
+void pool_run
+(
+	const size_t        ntasks,
+	const size_t        chunk,
+	const size_t        nthreads,
+	const pool_task_t   task,
+	void* const         arg,
+	pool_stat_t* const  stat
+)
+{
+	ASSERT(chunk > 0,"chunk size must be positive");
+
+	pool_t p;
+	p.ntasks = ntasks;
+	p.chunk  = chunk;
+	p.task   = task;
+	p.arg    = arg;
+	p.next   = 0;
+
+#ifdef HAVE_PTHREADS
+	const size_t nt = nthreads > 1 ? nthreads : 1;
+#else
+	const size_t nt = 1;
+#endif
+	pwork_t w[nt];
+	for (size_t t=0;t<nt;++t) {
+		w[t].pool = &p;
+		w[t].tnum = t;
+	}
+
+#ifdef HAVE_PTHREADS
+	pthread_t threads[nt];
+	for (size_t t=0;t<nt;++t) {
+		const int tres = pthread_create(&threads[t],NULL,pool_worker,(void*)&w[t]);
+		PASSERT(tres == 0,"unable to create thread %zu",t+1);
+	}
+	for (size_t t=0;t<nt;++t) {
+		const int tres = pthread_join(threads[t],NULL);
+		PASSERT(tres == 0,"unable to join thread %zu",t+1);
+	}
+#else
+	pool_worker((void*)&w[0]);
+#endif
+
+	if (stat == NULL) return;
+	for (size_t t=0;t<nthreads;++t) {
+		if (t < nt) stat[t] = w[t].stat;
+		else {stat[t].ntasks = 0; stat[t].cpu = 0.0; stat[t].wall = 0.0;}
+	}
+}
+
+void pool_print_stat(const size_t nthreads, const pool_stat_t* const stat)
+{
+	double cpu = 0.0, wall = 0.0;
+	for (size_t t=0;t<nthreads;++t) {
+		printf("thread %2zu : %4zu tasks (cpu time = %.4f, wall time = %.4f)\n",t+1,stat[t].ntasks,stat[t].cpu,stat[t].wall);
+		cpu += stat[t].cpu;
+		if (stat[t].wall > wall) wall = stat[t].wall;
+	}
+	printf("total cpu time = %.4f, wall time = %.4f (cpu/wall = %.2f of %zu threads)\n",cpu,wall,wall > 0.0 ? cpu/wall : 0.0,nthreads);
+}
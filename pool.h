@@ -0,0 +1,37 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/*********************************************************************/
+/*                  parallel task pool                               */
+/*********************************************************************/
+
+// Tasks 0,...,ntasks-1 are claimed by nthreads workers in chunks of consecutive
+// indices from a shared atomic counter, so that a worker which finishes early
+// simply takes the next chunk: with tasks of very uneven cost the batch wall
+// time approaches the total CPU time divided by the number of threads. The task
+// function gets the worker number, for indexing per-worker scratch buffers.
+// Without pthreads, tasks are run in order on the calling thread.
+
+typedef void (*pool_task_t)(void* const arg, const size_t k, const size_t tnum); // run task k on worker tnum
+
+typedef struct {
+	size_t ntasks; // tasks run
+	double cpu;    // thread CPU time (secs)
+	double wall;   // wall time (secs)
+} pool_stat_t;
+
+void pool_run
+(
+	const size_t        ntasks,
+	const size_t        chunk,    // consecutive tasks claimed at a time
+	const size_t        nthreads,
+	const pool_task_t   task,
+	void* const         arg,      // shared by all tasks
+	pool_stat_t* const  stat      // nthreads per-worker statistics (or NULL)
+);
+
+void pool_print_stat(const size_t nthreads, const pool_stat_t* const stat);
+
+#endif // POOL_H
@@ -1,3 +1,9 @@
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include <unistd.h>
+
 #include "rtab.h"
 #include "utils.h"
 
@@ -5,7 +11,7 @@
 /*              rule table (double-linked) list                         */
 /*********************************************************************/
 
-rtl_t* rtl_add(rtl_t* curr, const int size) // insert at end
+static rtl_t* rtl_link(rtl_t* curr) // new node at end
 {
 	if (curr == NULL) { // empty list
 		curr = malloc(sizeof(rtl_t));
@@ -23,11 +29,56 @@ rtl_t* rtl_add(rtl_t* curr, const int size) // insert at end
 		oldcurr->next = curr;
 	}
 	curr->filt = NULL;
+	return curr;
+}
+
+rtl_t* rtl_add(rtl_t* curr, const int size) // insert at end
+{
+	curr = rtl_link(curr);
 	curr->size = size;
 	curr->tab = rt_alloc(size);
+	curr->rtype = RT_TABLE;
+	curr->mask = WZERO;
+	return curr;
+}
+
+rtl_t* rtl_add_tot(rtl_t* curr, const int size, const rtype_t rtype, const word_t mask) // insert at end
+{
+	ASSERT(rtype != RT_TABLE && size <= rt_tot_maxb(rtype),"bad totalistic rule");
+	if (size <= RT_TOTTABMAXB) {
+		curr = rtl_add(curr,size);
+		rt_from_totalistic(size,curr->tab,rtype,mask);
+	}
+	else { // no table
+		curr = rtl_link(curr);
+		curr->size = size;
+		curr->tab = NULL;
+	}
+	curr->rtype = rtype;
+	curr->mask = mask;
+	return curr;
+}
+
+rtl_t* rtl_add_id(rtl_t* curr, const char* const str, int* const size) // insert at end
+{
+	rtype_t rtype;
+	word_t  mask;
+	if (rt_tot_sread_id(str,size,&rtype,&mask) == 1 && *size > RT_TOTTABMAXB) return rtl_add_tot(curr,*size,rtype,mask);
+	word_t* const tab = rt_sread_id(str,size);
+	if (tab == NULL) return curr; // failure - *size says why
+	curr = rtl_add(curr,*size);
+	rt_copy(*size,curr->tab,tab);
+	free(tab);
+	rtl_classify(curr);
 	return curr;
 }
 
+void rtl_classify(rtl_t* const r)
+{
+	// O(2^size), but rarely runs to completion for non-totalistic rules
+	if (r->tab != NULL) r->rtype = rt_totalistic(r->size,r->tab,&r->mask);
+}
+
 rtl_t* rtl_del(rtl_t* curr)
 {
 	if (curr == NULL) return NULL; // nothing to delete
@@ -65,11 +116,38 @@ rtl_t* rtl_find(const rtl_t* const rule, const int size, const word_t* const tab
 {
 	if (rule == NULL) return NULL;
 	const rtl_t* r = rule;
-	const size_t S = POW2(size);
+	const size_t nw = rt_nwords(size);
+	while (r->prev != NULL) r = r->prev; // go to beginning of list
+	while (r != NULL) {
+		if (size == r->size && r->tab != NULL) {
+			if (mw_equal(nw,tab,r->tab)) return (rtl_t*)r;
+		}
+		r = r->next;
+	}
+	return NULL;
+}
+
+rtl_t* rtl_find_tot(const rtl_t* const rule, const int size, const rtype_t rtype, const word_t mask)
+{
+	if (rule == NULL) return NULL;
+	const rtl_t* r = rule;
+	while (r->prev != NULL) r = r->prev; // go to beginning of list
+	while (r != NULL) {
+		if (size == r->size && rtype == r->rtype && mask == r->mask) return (rtl_t*)r;
+		r = r->next;
+	}
+	return NULL;
+}
+
+rtl_t* rtl_equiv(const rtl_t* const rule, const int size, const word_t* const tab)
+{
+	// first rule in list equivalent to tab under reflection/complement symmetries
+	if (rule == NULL) return NULL;
+	const rtl_t* r = rule;
 	while (r->prev != NULL) r = r->prev; // go to beginning of list
 	while (r != NULL) {
-		if (size == r->size) {
-			if (mw_equal(S,tab,r->tab)) return (rtl_t*)r;
+		if (size == r->size && r->tab != NULL) {
+			if (rt_equiv(size,tab,r->tab) >= 0) return (rtl_t*)r;
 		}
 		r = r->next;
 	}
@@ -142,7 +220,7 @@ rtl_t* rtl_fread(FILE* rtfs)
 
 		printf(" CA id = %s",token);
 		int rsiz;
-		word_t* const rtab = rt_sread_id(token,&rsiz);
+		rtl_t* const rnew = rtl_add_id(rule,token,&rsiz);
 		if (rsiz == -1) {
 			printf(" - ERROR: bad size - skipped\n");
 			continue;
@@ -151,16 +229,15 @@ rtl_t* rtl_fread(FILE* rtfs)
 			printf(" - ERROR: id contains non-hex characters - skipped\n");
 			continue;
 		}
-		rtl_t* const rrule = rtl_find(rule,rsiz,rtab); // rule already read?
-		if (rrule == NULL) {
+		const rtl_t* const rrule = rnew->tab != NULL ? rtl_find(rnew,rsiz,rnew->tab) : rtl_find_tot(rnew,rsiz,rnew->rtype,rnew->mask); // rule already read?
+		if (rrule == rnew) {
 			printf(" (new)");
-			rule = rtl_add(rule,rsiz);
-			rt_copy(rsiz,rule->tab,rtab);
+			rule = rnew;
 		}
 		else {
 			printf(" (old)");
+			rtl_del(rnew);
 		}
-		free(rtab);
 
 		token = strtok(NULL,delimit); // second string: a filter id
 		if (token == NULL) { // no filter id
@@ -214,7 +291,7 @@ rtl_t* rtl_fread(FILE* rtfs)
 word_t* rt_alloc(const int size)
 {
 	ASSERT(size<WBITS,"rule too wide");
-	word_t* const tab = calloc(POW2(size),sizeof(word_t)); // note: zero initialises (this is fine)
+	word_t* const tab = calloc(rt_nwords(size),sizeof(word_t)); // bit-packed; note: zero initialises (this is fine)
 	TEST_ALLOC(tab);
 	return tab;
 }
@@ -223,72 +300,658 @@ void rt_randomb(const int size, word_t* const tab, const size_t b, mt_t* const p
 {
 	const size_t S = POW2(size);
 	ASSERT(b<=S,"too many bits");
-	memset(tab,0,S*sizeof(word_t));
-	for (size_t i=0; i<b; ++i) tab[i] = WONE;
+	memset(tab,0,rt_nwords(size)*sizeof(word_t));
+	for (size_t i=0; i<b; ++i) RTSET(tab,i,WONE);
 	for (size_t i=0; i<b; ++i) {
 		size_t j = i+RANDI(size_t,S-i,prng);
-		const word_t tmp = tab[i];
-		tab[i] = tab[j];
-		tab[j] = tmp;
+		const word_t tmp = RTBIT(tab,i);
+		RTSET(tab,i,RTBIT(tab,j));
+		RTSET(tab,j,tmp);
+	}
+}
+
+/*********************************************************************/
+/*               (outer-)totalistic rules                            */
+/*********************************************************************/
+
+static inline word_t rt_tot_entry(const int size, const rtype_t rtype, const word_t mask, const word_t r)
+{
+	if (rtype == RT_TOTAL) return BITON(mask,wd_nsetbits(r));
+	const int C = size/2;
+	return BITON(mask,2*wd_nsetbits(r&~POW2(C))+(int)BITON(r,C));
+}
+
+rtype_t rt_totalistic(const int size, const word_t* const tab, word_t* const mask)
+{
+	const size_t S = POW2(size);
+	rtype_t rtype = RT_TOTAL;
+	word_t m = wd_total_mask(size,tab);
+	for (size_t r=0;r<S;++r) if (RTBIT(tab,r) != rt_tot_entry(size,rtype,m,r)) {rtype = RT_TABLE; break;}
+	if (rtype == RT_TABLE && size <= WOUTMAXB) {
+		rtype = RT_OUTER;
+		m = wd_outer_mask(size,tab);
+		for (size_t r=0;r<S;++r) if (RTBIT(tab,r) != rt_tot_entry(size,rtype,m,r)) {rtype = RT_TABLE; break;}
+	}
+	if (mask != NULL) *mask = rtype == RT_TABLE ? WZERO : m;
+	return rtype;
+}
+
+void rt_from_totalistic(const int size, word_t* const tab, const rtype_t rtype, const word_t mask)
+{
+	ASSERT(rtype != RT_TABLE && size <= rt_tot_maxb(rtype),"bad totalistic rule");
+	const size_t S = POW2(size);
+	memset(tab,0,rt_nwords(size)*sizeof(word_t));
+	for (size_t r=0;r<S;++r) tab[r>>6] |= rt_tot_entry(size,rtype,mask,r)<<(r&63);
+}
+
+word_t rt_tot_random(const int size, const rtype_t rtype, const double lam, mt_t* const prng)
+{
+	ASSERT(rtype != RT_TABLE && size <= rt_tot_maxb(rtype),"bad totalistic rule");
+	const int nbits = rtype == RT_OUTER ? 2*size : size+1;
+	word_t mask = WZERO;
+	for (int i=0;i<nbits;++i) if (mt_rand(prng) < lam) SETBIT(mask,i);
+	return mask;
+}
+
+word_t rt_tot_random_xr(const int size, const rtype_t rtype, const double lam, xr_t* const prng)
+{
+	ASSERT(rtype != RT_TABLE && size <= rt_tot_maxb(rtype),"bad totalistic rule");
+	const int nbits = rtype == RT_OUTER ? 2*size : size+1;
+	word_t mask = WZERO;
+	for (int i=0;i<nbits;++i) if (xr_rand(prng) < lam) SETBIT(mask,i);
+	return mask;
+}
+
+int rt_tot_sread_id(const char* const str, int* const size, rtype_t* const rtype, word_t* const mask)
+{
+	if      (str[0] == 'T') *rtype = RT_TOTAL;
+	else if (str[0] == 'O') *rtype = RT_OUTER;
+	else return 0; // not a totalistic id
+	char* s;
+	const long B = strtol(str+1,&s,10);
+	if (s == str+1 || *s != ':' || B < 1 || B > rt_tot_maxb(*rtype)) return -1; // bad size
+	*size = (int)B;
+	++s;
+	const size_t len = strlen(s);
+	if (len == 0) return -2;
+	word_t m = WZERO;
+	for (size_t c=0;c<len;++c) {
+		const word_t u = hex2word(s[c]);
+		if (u == 999 || (m>>(WBITS-4)) != WZERO) return -2; // non-hex, or overflow
+		m = (m<<4)|u;
+	}
+	if ((m&~rt_tot_bits(*size,*rtype)) != WZERO) return -2; // mask too long for size
+	*mask = m;
+	return 1;
+}
+
+void rt_tot_fprint_id(const int size, const rtype_t rtype, const word_t mask, FILE* const fstream)
+{
+	fprintf(fstream,"%c%d:%"PRIX64,rtype == RT_OUTER ? 'O' : 'T',size,mask);
+}
+
+void rt_tot_print_id(const int size, const rtype_t rtype, const word_t mask)
+{
+	rt_tot_fprint_id(size,rtype,mask,stdout);
+}
+
+double rt_tot_lambda(const int size, const rtype_t rtype, const word_t mask)
+{
+	// binomially-weighted mask bits (no table)
+	const int N = rtype == RT_OUTER ? size-1 : size; // cells counted
+	double lam = 0.0, binom = 1.0; // binom = N choose c
+	for (int c=0;c<=N;++c) {
+		lam += binom*(rtype == RT_OUTER ? (double)(BITON(mask,2*c)+BITON(mask,2*c+1)) : (double)BITON(mask,c));
+		binom = binom*(double)(N-c)/(double)(c+1);
+	}
+	return lam/ldexp(1.0,size);
+}
+
+mw_filter_t rt_tot_kernel(const rtype_t rtype)
+{
+	return rtype == RT_OUTER ? mw_outer : rtype == RT_TOTAL ? mw_total : NULL;
+}
+
+/*********************************************************************/
+/*       rule table symmetries (left-right reflection, complement)   */
+/*********************************************************************/
+
+// Rules related by left-right reflection and/or 0/1 complement (conjugation
+// by the complement map) have identical entropy; rule/filter pairs related by
+// the same symmetry applied to both have identical entropy and DD. Symmetries
+// are indexed g = 0,...,3 (bit 0: reflection, bit 1: complement). The canonical
+// form is the lexicographically smallest table in the orbit (entry 0 first).
+
+static inline int rt_symcmp(const int size, const word_t* const tab1, const int g1, const word_t* const tab2, const int g2)
+{
+	for (size_t r=0;r<POW2(size);++r) {
+		const word_t t1 = rt_symval(size,tab1,g1,r);
+		const word_t t2 = rt_symval(size,tab2,g2,r);
+		if (t1 != t2) return t1 < t2 ? -1 : +1;
+	}
+	return 0;
+}
+
+static inline uint64_t rt_hmix(uint64_t h) // 64-bit finaliser (splitmix64)
+{
+	h ^= h >> 30; h *= 0xbf58476d1ce4e5b9;
+	h ^= h >> 27; h *= 0x94d049bb133111eb;
+	h ^= h >> 31;
+	return h;
+}
+
+static inline uint64_t rt_symhash(const int size, const word_t* const tab, const int g, uint64_t h)
+{
+	// hash of table transformed by symmetry g, packed 64 entries at a time
+	const size_t S = POW2(size);
+	h = rt_hmix(h^(uint64_t)size);
+	for (size_t r0=0;r0<S;r0+=WBITS) {
+		word_t w = WZERO;
+		for (size_t r=r0;r<S && r<r0+WBITS;++r) PUTBIT(w,r-r0,rt_symval(size,tab,g,r));
+		h = rt_hmix(h^w);
+	}
+	return h;
+}
+
+void rt_symmetry(const int size, word_t* const dest, const word_t* const src, const int g)
+{
+	ASSERT(dest != src,"symmetry cannot be applied in place");
+	memset(dest,0,rt_nwords(size)*sizeof(word_t));
+	for (size_t r=0;r<POW2(size);++r) if (rt_symval(size,src,g,r)) RTSET(dest,r,WONE);
+}
+
+int rt_canonical(const int size, const word_t* const tab, word_t* const ctab)
+{
+	// returns symmetry taking tab to canonical form ctab (if not NULL)
+	int gmin = 0;
+	for (int g=1;g<4;++g) if (rt_symcmp(size,tab,g,tab,gmin) < 0) gmin = g;
+	if (ctab != NULL) rt_symmetry(size,ctab,tab,gmin);
+	return gmin;
+}
+
+int rt_canonical_pair(const int rsiz, const word_t* const rtab, const int fsiz, const word_t* const ftab, word_t* const crtab, word_t* const cftab)
+{
+	// same symmetry applied to rule and filter; ordered by rule, then filter
+	int gmin = 0;
+	for (int g=1;g<4;++g) {
+		const int c = rt_symcmp(rsiz,rtab,g,rtab,gmin);
+		if (c < 0 || (c == 0 && rt_symcmp(fsiz,ftab,g,ftab,gmin) < 0)) gmin = g;
+	}
+	if (crtab != NULL) rt_symmetry(rsiz,crtab,rtab,gmin);
+	if (cftab != NULL) rt_symmetry(fsiz,cftab,ftab,gmin);
+	return gmin;
+}
+
+int rt_equiv(const int size, const word_t* const tab1, const word_t* const tab2)
+{
+	// returns symmetry taking tab1 to tab2, or -1 if not equivalent
+	for (int g=0;g<4;++g) if (rt_symcmp(size,tab1,g,tab2,0) == 0) return g;
+	return -1;
+}
+
+int rt_equiv_pair(const int rsiz, const word_t* const rtab1, const word_t* const rtab2, const int fsiz, const word_t* const ftab1, const word_t* const ftab2)
+{
+	// returns symmetry taking rule/filter pair 1 to pair 2, or -1 if not equivalent
+	for (int g=0;g<4;++g) if (rt_symcmp(rsiz,rtab1,g,rtab2,0) == 0 && rt_symcmp(fsiz,ftab1,g,ftab2,0) == 0) return g;
+	return -1;
+}
+
+uint64_t rt_hash(const int size, const word_t* const tab)
+{
+	// symmetry-invariant hash (minimum over orbit; no canonical table required)
+	uint64_t hmin = UINT64_MAX;
+	for (int g=0;g<4;++g) {
+		const uint64_t h = rt_symhash(size,tab,g,0);
+		if (h < hmin) hmin = h;
 	}
+	return hmin;
 }
 
-size_t rt_uwords(const int size, const word_t* const tab,const int m)
+uint64_t rt_hash_tab(const int size, const word_t* const tab)
+{
+	// hash of the table itself (not symmetry-invariant)
+	return rt_symhash(size,tab,0,0);
+}
+
+uint64_t rt_hash_pair(const int rsiz, const word_t* const rtab, const int fsiz, const word_t* const ftab)
+{
+	uint64_t hmin = UINT64_MAX;
+	for (int g=0;g<4;++g) {
+		const uint64_t h = rt_symhash(fsiz,ftab,g,rt_symhash(rsiz,rtab,g,0));
+		if (h < hmin) hmin = h;
+	}
+	return hmin;
+}
+
+size_t rt_pair_dups(const size_t n, const int* const rsiz, const word_t* const* const rtab, const int* const fsiz, const word_t* const* const ftab, size_t* const dup)
+{
+	// For each of n rule/filter pairs, dup[k] is the index of the first pair equivalent to pair k
+	// (dup[k] = k if there is none); returns the number of duplicates. Uses an open-addressing
+	// hash table, so the cost is linear in n.
+	size_t H = 2;
+	while (H < 2*n) H <<= 1;
+	const size_t HMASK = H-1;
+	size_t* const htab = malloc(H*sizeof(size_t)); // pair indices (n = empty)
+	TEST_ALLOC(htab);
+	uint64_t* const hash = malloc(n*sizeof(uint64_t));
+	TEST_ALLOC(hash);
+	for (size_t i=0;i<H;++i) htab[i] = n;
+	size_t ndups = 0;
+	for (size_t k=0;k<n;++k) {
+		hash[k] = rt_hash_pair(rsiz[k],rtab[k],fsiz[k],ftab[k]);
+		dup[k] = k;
+		size_t i = (size_t)hash[k]&HMASK;
+		for (;htab[i] != n; i = (i+1)&HMASK) {
+			const size_t j = htab[i];
+			if (hash[j] == hash[k] && rsiz[j] == rsiz[k] && fsiz[j] == fsiz[k] && rt_equiv_pair(rsiz[k],rtab[k],rtab[j],fsiz[k],ftab[k],ftab[j]) >= 0) {
+				dup[k] = j;
+				++ndups;
+				break;
+			}
+		}
+		if (dup[k] == k) htab[i] = k;
+	}
+	free(hash);
+	free(htab);
+	return ndups;
+}
+
+typedef struct {
+	int           size;
+	const word_t* tab;
+	int           m;
+	word_t        vbeg;
+	word_t        vend;
+	word_t*       bmap;
+	int           atomic;
+} rt_uwarg_t;
+
+static void* rt_uwords_mark(void* arg)
+{
+	// mark images of words vbeg,...,vend-1 in bitmap
+	const rt_uwarg_t* const a = (rt_uwarg_t*)arg;
+	if (a->atomic) {
+		for (word_t v=a->vbeg;v<a->vend;++v) {
+			const word_t u = wd_filter(a->m,v,a->size,a->tab);
+			__atomic_fetch_or(&a->bmap[u>>6],WONE<<(u&63),__ATOMIC_RELAXED);
+		}
+	}
+	else {
+		for (word_t v=a->vbeg;v<a->vend;++v) {
+			const word_t u = wd_filter(a->m,v,a->size,a->tab);
+			SETBIT(a->bmap[u>>6],u&63);
+		}
+	}
+	return NULL;
+}
+
+size_t rt_uwords(const int size, const word_t* const tab, const int m, const int nthreads)
 {
 	// Find the number of unique words generated by rule tab of breadth size
-	// operating on all words of length m.
+	// operating on all (cyclic) words of length m. Images are marked in a
+	// 2^m-bit bitmap, so time is linear in 2^m; the words are split between
+	// nthreads threads (if available).
+	ASSERT(m <= WBITS/2,"word too long!");
+	ASSERT(size <= m,"word shorter than rule");
 	const size_t M = POW2(m);
-	const int WB  = WBITS-size;
-	const int Wm  = WBITS-m;
-	const int WBm = WB+m;
-	if (m > WBITS) EEXIT("word too long!");
-	word_t* const w = mw_alloc(M);
-	for (word_t v=0;v<M;++v) {
-		word_t wv = 0;
-		int i = 0;
-		for (;i<m-size+1;++i) PUTBIT(wv,i,tab[(v<<(WB-i))>>WB]);
-		for (;i<m    ;++i) PUTBIT(wv,i,tab[((v<<Wm)>>(Wm+i))|((v<<(WBm-i))>>WB)]);
-		w[v] = wv;
-	}
-	size_t n = 1;
-	for (size_t v=1;v<M;++v) {
-		size_t u = 0;
-		for (;u<v;++u) if (w[u] == w[v]) break;
-		if (u == v) ++n;
-	}
-	free(w);
+	const size_t nbw = m > 6 ? POW2(m-6) : 1;
+	TEST_RAM(nbw*sizeof(word_t));
+	word_t* const bmap = calloc(nbw,sizeof(word_t)); // zero-initialises
+	TEST_ALLOC(bmap);
+#ifdef HAVE_PTHREADS
+	const size_t nt = nthreads > 1 && M >= POW2(16) ? (size_t)nthreads : 1;
+#else
+	const size_t nt = 1;
+#endif
+	rt_uwarg_t args[nt];
+	for (size_t t=0;t<nt;++t) {
+		args[t].size   = size;
+		args[t].tab    = tab;
+		args[t].m      = m;
+		args[t].vbeg   = (M/nt)*t;
+		args[t].vend   = t == nt-1 ? M : (M/nt)*(t+1);
+		args[t].bmap   = bmap;
+		args[t].atomic = nt > 1;
+	}
+#ifdef HAVE_PTHREADS
+	if (nt > 1) {
+		pthread_t threads[nt];
+		for (size_t t=0;t<nt;++t) {
+			const int tres = pthread_create(&threads[t],NULL,rt_uwords_mark,(void*)&args[t]);
+			PASSERT(tres == 0,"unable to create thread %zu",t+1);
+		}
+		for (size_t t=0;t<nt;++t) {
+			const int tres = pthread_join(threads[t],NULL);
+			PASSERT(tres == 0,"unable to join thread %zu",t+1);
+		}
+	}
+	else
+#endif
+	rt_uwords_mark((void*)&args[0]);
+	size_t n = 0;
+	for (size_t k=0;k<nbw;++k) n += (size_t)__builtin_popcountll(bmap[k]);
+	free(bmap);
 	return n;
 }
 
+/*********************************************************************/
+/*                     rule composition                              */
+/*********************************************************************/
+
+// k steps of a size B rule, followed by a size F filter, is itself a rule
+// of size k(B-1)+F: output cell i depends on cells i, ..., i+k(B-1)+F-1.
+// The composed table is built once, by running the rule on each (open)
+// window; applied with wd_filter/mw_filter it then advances several
+// generations per lookup. Composed tables are only worth it while they stay
+// in cache, so k is chosen to keep the table within a cache budget.
+
+#define RT_COMPOSE_MAXK 16 // cap on composition steps (only bites for size 1 rules)
+
+int rt_compose_k(const int size, size_t cbytes) // largest k for which F^k table fits in cbytes (0 for L2 cache size)
+{
+	if (cbytes == 0) {
+		const long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+		cbytes = l2 > 0 ? (size_t)l2 : 256*1024; // guess if unavailable
+	}
+	int k = 1;
+	while (k < RT_COMPOSE_MAXK && (k+1)*(size-1)+1 < WBITS && rt_nwords((k+1)*(size-1)+1)*sizeof(word_t) <= cbytes) ++k;
+	return k;
+}
+
+word_t* rt_compose_filt(const int rsiz, const word_t* const rtab, const int k, const int fsiz, const word_t* const ftab, int* const csiz)
+{
+	// table for filter o F^k (allocates - remember to free!); built outward from
+	// the filter, one step at a time: entry x of the filter o F^j table is entry
+	// F(x) of the filter o F^(j-1) table, so each level costs one rule step per entry
+	const int size = k*(rsiz-1)+fsiz;
+	ASSERT(k >= 0 && size < WBITS,"composed rule too wide");
+	const word_t RMASK = WONES>>(WBITS-rsiz);
+	word_t* ptab = rt_alloc(fsiz);
+	rt_copy(fsiz,ptab,ftab);
+	for (int j=1,len=fsiz+rsiz-1; j<=k; ++j,len+=rsiz-1) {
+		word_t* const ctab = rt_alloc(len);
+		const int plen = len-(rsiz-1);
+		const size_t S = POW2(len);
+		for (word_t x=WZERO; x<S; ++x) {
+			word_t y = WZERO;
+			for (int i=0; i<plen; ++i) y |= RTBIT(rtab,(x>>i)&RMASK)<<i;
+			if (RTBIT(ptab,y)) RTSET(ctab,x,WONE);
+		}
+		free(ptab);
+		ptab = ctab;
+	}
+	*csiz = size;
+	return ptab;
+}
+
+word_t* rt_compose(const int size, const word_t* const tab, const int k, int* const csiz)
+{
+	// table for F^k (allocates - remember to free!)
+	static const word_t idtab[1] = {2}; // identity filter (packed: entry 0 -> 0, entry 1 -> 1)
+	return rt_compose_filt(size,tab,k,1,idtab,csiz);
+}
+
+void rt_run(const size_t I, const size_t n, word_t* const w, const int size, const word_t* const tab)
+{
+	// as mw_run, but advances by composed rule where possible
+	const int k = rt_compose_k(size,0);
+	if (k < 2 || I < (size_t)k) {
+		mw_run(I,n,w,size,tab);
+		return;
+	}
+	int csiz;
+	word_t* const ctab = rt_compose(size,tab,k,&csiz);
+	mw_run(I/(size_t)k,n,w,csiz,ctab);
+	mw_run(I%(size_t)k,n,w,size,tab);
+	free(ctab);
+}
+
+/*********************************************************************/
+/*       de Bruijn graph analysis (surjectivity, injectivity)        */
+/*********************************************************************/
+
+// The de Bruijn graph of a rule of breadth B has nodes the 2^(B-1) words of
+// length B-1, and an edge labelled tab[r] from (low B-1 bits of) r to r>>1
+// for each window r. Bi-infinite configurations are bi-infinite paths, and
+// their images the label sequences. The pair graph has nodes (p,q) of de
+// Bruijn nodes, with an edge wherever p and q have edges with equal labels.
+//
+// F is surjective iff no two distinct finite paths with the same label
+// sequence share start and end nodes (no "diamond" in the pair graph) [Moore-
+// Myhill], and injective iff every bi-infinite path of the pair graph lies on
+// the diagonal. (Since injectivity on periodic configurations is equivalent
+// to injectivity, F is then also injective on rings of every length.)
+
+int rt_surjective(const int size, const word_t* const tab)
+{
+	ASSERT(size >= 1 && size <= 13,"rule size must be in range 1 - 13");
+	const size_t n  = POW2(size-1); // de Bruijn nodes
+	const size_t N  = n*n;          // pair graph nodes (p,q) -> p*n+q
+	const int    B1 = size-1;
+	uint8_t* const seen  = calloc(N,sizeof(uint8_t)); // zero-initialises
+	TEST_ALLOC(seen);
+	size_t*  const stack = malloc(N*sizeof(size_t));
+	TEST_ALLOC(stack);
+	size_t ns = 0;
+	for (size_t p=0;p<n;++p) { // split from diagonal (p,p) along differently-extended edges with equal labels
+		const size_t r0 = p, r1 = p|((size_t)1<<B1);
+		if (RTBIT(tab,r0) != RTBIT(tab,r1)) continue;
+		if ((r0>>1) == (r1>>1)) {ns = 0; break;} // size 1: parallel edges
+		const size_t k = (r0>>1)*n+(r1>>1);
+		if (!seen[k]) {seen[k] = 1; stack[ns++] = k;}
+		const size_t kk = (r1>>1)*n+(r0>>1);
+		if (!seen[kk]) {seen[kk] = 1; stack[ns++] = kk;}
+	}
+	int surj = size > 1 || RTBIT(tab,0) != RTBIT(tab,1);
+	while (ns > 0 && surj) { // depth-first search of off-diagonal nodes; a return to the diagonal is a diamond
+		const size_t k = stack[--ns];
+		const size_t p = k/n, q = k%n;
+		for (size_t a=0;a<2 && surj;++a) {
+			const size_t rp = p|(a<<B1);
+			for (size_t b=0;b<2;++b) {
+				const size_t rq = q|(b<<B1);
+				if (RTBIT(tab,rp) != RTBIT(tab,rq)) continue;
+				const size_t p1 = rp>>1, q1 = rq>>1;
+				if (p1 == q1) {surj = 0; break;}
+				const size_t k1 = p1*n+q1;
+				if (!seen[k1]) {seen[k1] = 1; stack[ns++] = k1;}
+			}
+		}
+	}
+	free(stack);
+	free(seen);
+	return surj;
+}
+
+int rt_injective(const int size, const word_t* const tab)
+{
+	ASSERT(size >= 1 && size <= 13,"rule size must be in range 1 - 13");
+	if (!rt_surjective(size,tab)) return 0; // injective implies surjective
+	const size_t n  = POW2(size-1);
+	const size_t N  = n*n;
+	const int    B1 = size-1;
+	uint8_t* const indeg  = calloc(N,sizeof(uint8_t)); // zero-initialises (degrees at most 4)
+	TEST_ALLOC(indeg);
+	uint8_t* const outdeg = calloc(N,sizeof(uint8_t)); // zero-initialises
+	TEST_ALLOC(outdeg);
+	uint8_t* const gone   = calloc(N,sizeof(uint8_t)); // zero-initialises
+	TEST_ALLOC(gone);
+	size_t*  const stack  = malloc(N*sizeof(size_t));
+	TEST_ALLOC(stack);
+	for (size_t k=0;k<N;++k) {
+		const size_t p = k/n, q = k%n;
+		for (size_t a=0;a<2;++a) for (size_t b=0;b<2;++b) {
+			const size_t rp = p|(a<<B1), rq = q|(b<<B1);
+			if (RTBIT(tab,rp) != RTBIT(tab,rq)) continue;
+			++outdeg[k];
+			++indeg[(rp>>1)*n+(rq>>1)];
+		}
+	}
+	// prune nodes with no predecessor or no successor; what remains carries the bi-infinite paths
+	size_t ns = 0;
+	for (size_t k=0;k<N;++k) if (indeg[k] == 0 || outdeg[k] == 0) {gone[k] = 1; stack[ns++] = k;}
+	while (ns > 0) {
+		const size_t k = stack[--ns];
+		const size_t p = k/n, q = k%n;
+		for (size_t a=0;a<2;++a) for (size_t b=0;b<2;++b) { // successors lose a predecessor
+			const size_t rp = p|(a<<B1), rq = q|(b<<B1);
+			if (RTBIT(tab,rp) != RTBIT(tab,rq)) continue;
+			const size_t k1 = (rp>>1)*n+(rq>>1);
+			if (!gone[k1] && --indeg[k1] == 0) {gone[k1] = 1; stack[ns++] = k1;}
+		}
+		for (size_t a=0;a<2;++a) for (size_t b=0;b<2;++b) { // predecessors lose a successor
+			const size_t rp = (p<<1|a)&(n-1), rq = (q<<1|b)&(n-1);       // predecessor nodes
+			const size_t wp = (p<<1|a), wq = (q<<1|b);                    // connecting windows
+			if (RTBIT(tab,wp) != RTBIT(tab,wq)) continue;
+			const size_t k1 = rp*n+rq;
+			if (!gone[k1] && --outdeg[k1] == 0) {gone[k1] = 1; stack[ns++] = k1;}
+		}
+	}
+	int inj = 1;
+	for (size_t k=0;k<N && inj;++k) if (!gone[k] && k/n != k%n) inj = 0;
+	free(stack);
+	free(gone);
+	free(outdeg);
+	free(indeg);
+	return inj;
+}
+
+/*********************************************************************/
+/*       Garden-of-Eden count on rings (relation matrices)           */
+/*********************************************************************/
+
+// A word y of length m has a preimage on the ring of length m iff the de
+// Bruijn graph has a closed walk labelled y, i.e. the boolean matrix product
+// M[y_0]...M[y_{m-1}] has nonzero trace, where M[b] is the adjacency matrix of
+// edges labelled b. The distinct products are propagated as automaton states
+// (rows are 2^(B-1) <= 64 bit words) together with the number of words
+// reaching them, so the count does not enumerate words (but the number of
+// states may grow; we give up beyond maxstates).
+
+typedef struct {
+	size_t    n;       // matrix dimension (rows per state)
+	size_t    nstates;
+	size_t    maxstates;
+	size_t    hmask;
+	word_t*   rows;    // state matrices
+	uint64_t* count;   // number of words reaching each state
+	size_t*   htab;    // hash table of state indices (maxstates = empty)
+} rt_rmset_t;
+
+static void rt_rmset_init(rt_rmset_t* const set, const size_t n, const size_t maxstates)
+{
+	set->n = n;
+	set->nstates = 0;
+	set->maxstates = maxstates;
+	size_t H = 2;
+	while (H < 2*maxstates) H <<= 1;
+	set->hmask = H-1;
+	set->rows  = mw_alloc(maxstates*n);
+	set->count = malloc(maxstates*sizeof(uint64_t));
+	TEST_ALLOC(set->count);
+	set->htab  = malloc(H*sizeof(size_t));
+	TEST_ALLOC(set->htab);
+	for (size_t i=0;i<H;++i) set->htab[i] = maxstates;
+}
+
+static void rt_rmset_clear(rt_rmset_t* const set)
+{
+	for (size_t i=0;i<=set->hmask;++i) set->htab[i] = set->maxstates;
+	set->nstates = 0;
+}
+
+static void rt_rmset_free(rt_rmset_t* const set)
+{
+	free(set->htab);
+	free(set->count);
+	free(set->rows);
+}
+
+static int rt_rmset_add(rt_rmset_t* const set, const word_t* const mat, const uint64_t cnt)
+{
+	// add count to state mat (inserting if new); returns 0 if maxstates exceeded
+	const size_t n = set->n;
+	uint64_t h = 0;
+	for (size_t i=0;i<n;++i) h = rt_hmix(h^mat[i]);
+	size_t j = (size_t)h&set->hmask;
+	for (;set->htab[j] != set->maxstates; j = (j+1)&set->hmask) {
+		const size_t s = set->htab[j];
+		if (mw_equal(n,set->rows+s*n,mat)) {set->count[s] += cnt; return 1;}
+	}
+	if (set->nstates == set->maxstates) return 0;
+	const size_t s = set->nstates++;
+	memcpy(set->rows+s*n,mat,n*sizeof(word_t));
+	set->count[s] = cnt;
+	set->htab[j] = s;
+	return 1;
+}
+
+int rt_ring_goe(const int size, const word_t* const tab, const int m, const size_t maxstates, uint64_t* const ngoe)
+{
+	// number of Garden-of-Eden words (no preimage) on the ring of length m; returns 0 if maxstates exceeded
+	ASSERT(size >= 1 && size <= 7,"rule size must be in range 1 - 7");
+	ASSERT(m >= size && m < WBITS,"ring length must be in range rule size - 63");
+	const size_t n  = POW2(size-1);
+	word_t M[2][WBITS]; // adjacency matrices for labels 0, 1: row p has bit q set for each edge p -> q
+	for (size_t p=0;p<n;++p) {M[0][p] = WZERO; M[1][p] = WZERO;}
+	for (size_t r=0;r<2*n;++r) SETBIT(M[RTBIT(tab,r)][r&(n-1)],r>>1);
+	rt_rmset_t set[2];
+	rt_rmset_init(&set[0],n,maxstates);
+	rt_rmset_init(&set[1],n,maxstates);
+	word_t mat[WBITS];
+	for (size_t p=0;p<n;++p) mat[p] = WONE<<p; // identity
+	rt_rmset_add(&set[0],mat,1);
+	int ok = 1;
+	int cur = 0;
+	for (int i=0;i<m && ok;++i, cur = 1-cur) {
+		rt_rmset_t* const s0 = &set[cur];
+		rt_rmset_t* const s1 = &set[1-cur];
+		rt_rmset_clear(s1);
+		for (size_t s=0;s<s0->nstates && ok;++s) {
+			const word_t* const A = s0->rows+s*n;
+			for (int b=0;b<2 && ok;++b) { // A*M[b]
+				for (size_t p=0;p<n;++p) {
+					word_t row = WZERO;
+					for (word_t u=A[p]; u; u &= u-1) row |= M[b][__builtin_ctzll(u)];
+					mat[p] = row;
+				}
+				ok = rt_rmset_add(s1,mat,s0->count[s]);
+			}
+		}
+	}
+	if (ok) {
+		uint64_t nimg = 0;
+		const rt_rmset_t* const sf = &set[cur];
+		for (size_t s=0;s<sf->nstates;++s) {
+			const word_t* const A = sf->rows+s*n;
+			int tr = 0;
+			for (size_t p=0;p<n && !tr;++p) tr = (int)BITON(A[p],p);
+			if (tr) nimg += sf->count[s];
+		}
+		*ngoe = POW2(m)-nimg;
+	}
+	rt_rmset_free(&set[1]);
+	rt_rmset_free(&set[0]);
+	return ok;
+}
+
 void rt_to_mwords(const int size, const word_t* const tab, const size_t nrtwords, word_t* const rtwords)
 {
 	ASSERT(nrtwords == rt_nwords(size),"Wrong number of words!");
-	const size_t S = POW2(size);
-	word_t* p = rtwords;
-	*p = WZERO;
-	int i = 0;
-	for (size_t r=0;r<S;++r) {
-		PUTBIT(*p,i,tab[r]);
-		if (++i == WBITS) {*(++p) = WZERO; i = 0;}
-	}
+	rt_copy(size,rtwords,tab); // rule tables are already bit-packed
 }
 
 void rt_from_mwords(const int size, word_t* const tab, const size_t nrtwords, const word_t* const rtwords)
 {
 	ASSERT(nrtwords == rt_nwords(size),"Wrong number of words!");
-	const size_t S = POW2(size);
-	const word_t* p = rtwords;
-	int i = 0;
-	for (size_t r=0;r<S;++r) {
-		tab[r] = BITON(*p,i);
-		if (++i == WBITS) {++p; i = 0;}
-	}
+	rt_copy(size,tab,rtwords); // rule tables are already bit-packed
+	if (size < 6) tab[0] &= WONES>>(WBITS-(int)POW2(size)); // clear unused hi-bits
 }
 
 void rt_fprint(const int size, const word_t* const tab, FILE* const fstream)
 {
 	const size_t S = POW2(size);
-	for (size_t r=0;r<S;++r) fprintf(fstream,"%3zu = "PBP08" -> %"PRIw"\n",r,PBI08(r),tab[r]);
+	for (size_t r=0;r<S;++r) fprintf(fstream,"%3zu = "PBP08" -> %"PRIw"\n",r,PBI08(r),RTBIT(tab,r));
 }
 
 void rt_print(const int size, const word_t* const tab)
@@ -298,17 +961,8 @@ void rt_print(const int size, const word_t* const tab)
 
 void rt_fprint_id(const int size, const word_t* const tab, FILE* const fstream)
 {
-	const size_t S = POW2(size);
-	word_t u = 0;
-	int i = 0;
-	for (size_t r=0;r<S;++r) {
-		PUTBIT(u,i,tab[r]);
-		if ((++i)%4 == 0) {
-			fputc(hexchar[u],fstream);
-			u = 0;
-			i = 0;
-		}
-	}
+	const size_t C = rt_hexchars(size);
+	for (size_t c=0;c<C;++c) fputc(hexchar[(tab[c>>4]>>(4*(c&15)))&0xF],fstream); // 4 entries per hex char
 }
 
 void rt_print_id(const int size, const word_t* const tab)
@@ -319,22 +973,11 @@ void rt_print_id(const int size, const word_t* const tab)
 size_t rt_sprint_id(const int size, const word_t* const tab, size_t sbuflen, char* const str)
 {
 	// Note: *concatenates* rtid to string; string buffer must be long enough to accommodate it!
-	const size_t S = POW2(size);
 	const size_t C = rt_hexchars(size);
 	const size_t slen = strlen(str);
 	ASSERT(slen+C < sbuflen,"string buffer too short!"); // note extra char for NUL terminator
-	word_t u = 0;
-	int i = 0;
-	size_t c = slen;
-	for (size_t r=0;r<S;++r) {
-		PUTBIT(u,i,tab[r]);
-		if ((++i)%4 == 0) {
-			str[c++] = hexchar[u];
-			u = 0;
-			i = 0;
-		}
-	}
-	str[c] = '\0'; // null terminate
+	for (size_t c=0;c<C;++c) str[slen+c] = hexchar[(tab[c>>4]>>(4*(c&15)))&0xF]; // 4 entries per hex char
+	str[slen+C] = '\0'; // null terminate
 	return C; // number of chars written not including NUL terminator
 }
 
@@ -357,12 +1000,23 @@ word_t* rt_read_id(int* const size) // allocates rule table on sucess - remember
 
 word_t* rt_sread_id(const char* const str, int* const size) // allocates rule table on sucess - remember to free!
 {
+	rtype_t rtype;
+	word_t  mask;
+	const int tot = rt_tot_sread_id(str,size,&rtype,&mask);
+	if (tot != 0) { // (outer-)totalistic id
+		if (tot < 0 || *size > RT_TOTTABMAXB) { // failure - bad size (or too big for a table) or bad mask
+			*size = tot == -2 ? -2 : -1;
+			return NULL;
+		}
+		word_t* const tab = rt_alloc(*size);
+		rt_from_totalistic(*size,tab,rtype,mask);
+		return tab;
+	}
 	const size_t len = strlen(str);
 	*size = rt_hexsize(len);
 	if (*size == -1) return NULL; // failure - ID is bad size
-	size_t r = 0;
 	word_t* const tab = rt_alloc(*size);
-	const int nepc = *size == 1 ? 2 : 4; // number of table entries per char
+	const word_t cmask = *size == 1 ? 3 : 15; // table entries per char: 2 or 4
 	for (size_t c=0;c<len;++c) {
 		const word_t u = hex2word(str[c]);
 		if (u == 999) {
@@ -370,7 +1024,7 @@ word_t* rt_sread_id(const char* const str, int* const size) // allocates rule ta
 			*size = -2; // failure - non-hex chars
 			return NULL;
 		}
-		for (int i=0;i<nepc;++i) tab[r++] = BITON(u,i);
+		tab[c>>4] |= (u&cmask)<<(4*(c&15));
 	}
 	return tab; // success
 }
@@ -388,10 +1042,20 @@ double rt_entro( // Entropy for CA rule on sequence of length m after iff iterat
 
 	const size_t S = POW2(m);
 	for (size_t y=0; y<S; ++y) bin[y] = 0;
-	for (word_t x=WZERO; x<S; ++x) {
-		word_t y = x;
-		for (int i=0; i<iff; ++i) y = wd_filter(m,y,size,tab); // advance CA (at least 1)
-		++bin[y];
+	if (iff > 1 && iff*(size-1)+1 <= m) { // advance by composed rule (table no bigger than histogram)
+		int csiz;
+		word_t* const ctab = rt_compose(size,tab,iff,&csiz);
+		const wd_filter_t cfilt = wd_filter_sel(csiz);
+		for (word_t x=WZERO; x<S; ++x) ++bin[cfilt(m,x,csiz,ctab)];
+		free(ctab);
+	}
+	else {
+		const wd_filter_t filt = wd_filter_sel(size);
+		for (word_t x=WZERO; x<S; ++x) {
+			word_t y = x;
+			for (int i=0; i<iff; ++i) y = filt(m,y,size,tab); // advance CA (at least 1)
+			++bin[y];
+		}
 	}
 
 	// Calculate entropy
@@ -421,19 +1085,135 @@ double rt_dd( // dynamical dependence for CA/filter rules on sequence of length
 	const size_t S2 = POW2(2*m);
 	for (size_t y=0; y<S;  ++y) bin[y]  = 0;
 	for (size_t y=0; y<S2; ++y) bin2[y] = 0;
-	for (word_t x=WZERO; x<S; ++x) {
-		word_t y = x;
-		for (int i=0; i<iff; ++i) y = wd_filter(m,y,rsiz,rtab);  // advance CA (may be zero)
-		const word_t u = wd_filter(m,y,fsiz,ftab);               // filter CA
-		for (int i=0; i<ilag; ++i) y = wd_filter(m,y,rsiz,rtab); // advance CA (at least 1)
-		const word_t v = wd_filter(m,y,fsiz,ftab);               // filter CA
+	if (iff+ilag > 1 && (iff+ilag)*(rsiz-1)+fsiz <= m) { // filter o advance by composed rules (tables no bigger than histogram)
+		int usiz, vsiz;
+		word_t* const utab = rt_compose_filt(rsiz,rtab,iff,     fsiz,ftab,&usiz);
+		word_t* const vtab = rt_compose_filt(rsiz,rtab,iff+ilag,fsiz,ftab,&vsiz);
+		const wd_filter_t ufilt = wd_filter_sel(usiz);
+		const wd_filter_t vfilt = wd_filter_sel(vsiz);
+		for (word_t x=WZERO; x<S; ++x) {
+			const word_t u = ufilt(m,x,usiz,utab);
+			const word_t v = vfilt(m,x,vsiz,vtab);
+			++bin[u];
+			++bin2[u+S*v];
+		}
+		free(vtab);
+		free(utab);
+	}
+	else {
+		const wd_filter_t rfilt = wd_filter_sel(rsiz);
+		const wd_filter_t ffilt = wd_filter_sel(fsiz);
+		for (word_t x=WZERO; x<S; ++x) {
+			word_t y = x;
+			for (int i=0; i<iff; ++i) y = rfilt(m,y,rsiz,rtab);  // advance CA (may be zero)
+			const word_t u = ffilt(m,y,fsiz,ftab);               // filter CA
+			for (int i=0; i<ilag; ++i) y = rfilt(m,y,rsiz,rtab); // advance CA (at least 1)
+			const word_t v = ffilt(m,y,fsiz,ftab);               // filter CA
+			++bin[u];
+			++bin2[u+S*v];
+		}
+	}
+
+	// Calculate entropies
+
+	const double f = 1.0/(double)S;
+	double* const p = (double* const)bin; // alias histogram as double array (!)
+	for (size_t y=0; y<S; ++y) p[y] = f*(double)bin[y];
+	const double H = entro2(S,p);
+	double* const p2 = (double* const)bin2; // alias histogram as double array (!)
+	for (size_t y2=0; y2<S2; ++y2) p2[y2] = f*(double)bin2[y2];
+	const double H2 = entro2(S2,p2);
+	return H2-H;
+}
+
+// Second-order CA (cf. ca_run2): the state is a pair (x_{t-1},x_t) of m-bit cyclic
+// sequences, drawn uniformly from all 2^(2m) pairs; x_{t+1} = F(x_t) XOR x_{t-1}
+// rotated right by 2C bits (the twisted frame), C = size/2.
+
+static inline word_t rt_rotr_cyc(const int m, const word_t y, const int b)
+{
+	// rotate m-bit sequence y right by b bits
+	const int c = b%m;
+	return c == 0 ? y : ((y>>c)|(y<<(m-c)))&(POW2(m)-1);
+}
+
+double rt_entro2( // Entropy for second-order CA rule on sequence of length m after iff iterations
+	const int           size,
+	const word_t* const tab,
+	const int           m,
+	const int           iff,
+	uint64_t*     const bin
+)
+{
+	// Construct histogram
+
+	const size_t S = POW2(m);
+	const word_t M = S-1;
+	const int off = 2*(size/2);
+	for (size_t y=0; y<S; ++y) bin[y] = 0;
+	const wd_filter_t filt = wd_filter_sel(size);
+	for (word_t x=WZERO; x<S*S; ++x) {
+		word_t y0 = x&M, y1 = x>>m;
+		for (int i=0; i<iff; ++i) { // advance CA (at least 1)
+			const word_t y2 = filt(m,y1,size,tab)^rt_rotr_cyc(m,y0,off);
+			y0 = y1;
+			y1 = y2;
+		}
+		++bin[y1];
+	}
+
+	// Calculate entropy
+
+	const double f = 1.0/((double)S*(double)S);
+	double* const p = (double* const)bin; // alias histogram as double array (!)
+	for (size_t y=0; y<S; ++y) p[y] = f*(double)bin[y];
+	const double H = entro2(S,p);
+	return H;
+}
+
+double rt_dd2( // dynamical dependence for second-order CA/filter rules on sequence of length m after iff iterations, with lag ilag
+	const int           rsiz,
+	const word_t* const rtab,
+	const int           fsiz,
+	const word_t* const ftab,
+	const int           m,
+	const int           iff,
+	const int           ilag,
+	uint64_t*     const bin,
+	uint64_t*     const bin2
+)
+{
+	// Construct histograms (the filter sees the current generation only)
+
+	const size_t S  = POW2(m);
+	const size_t S2 = POW2(2*m);
+	const word_t M  = S-1;
+	const int off = 2*(rsiz/2);
+	for (size_t y=0; y<S;  ++y) bin[y]  = 0;
+	for (size_t y=0; y<S2; ++y) bin2[y] = 0;
+	const wd_filter_t rfilt = wd_filter_sel(rsiz);
+	const wd_filter_t ffilt = wd_filter_sel(fsiz);
+	for (word_t x=WZERO; x<S2; ++x) {
+		word_t y0 = x&M, y1 = x>>m;
+		for (int i=0; i<iff; ++i) { // advance CA (may be zero)
+			const word_t y2 = rfilt(m,y1,rsiz,rtab)^rt_rotr_cyc(m,y0,off);
+			y0 = y1;
+			y1 = y2;
+		}
+		const word_t u = ffilt(m,y1,fsiz,ftab); // filter CA
+		for (int i=0; i<ilag; ++i) { // advance CA (at least 1)
+			const word_t y2 = rfilt(m,y1,rsiz,rtab)^rt_rotr_cyc(m,y0,off);
+			y0 = y1;
+			y1 = y2;
+		}
+		const word_t v = ffilt(m,y1,fsiz,ftab); // filter CA
 		++bin[u];
 		++bin2[u+S*v];
 	}
 
 	// Calculate entropies
 
-	const double f = 1.0/(double)S;
+	const double f = 1.0/(double)S2;
 	double* const p = (double* const)bin; // alias histogram as double array (!)
 	for (size_t y=0; y<S; ++y) p[y] = f*(double)bin[y];
 	const double H = entro2(S,p);
@@ -442,3 +1222,266 @@ double rt_dd( // dynamical dependence for CA/filter rules on sequence of length
 	const double H2 = entro2(S2,p2);
 	return H2-H;
 }
+
+static inline int rt_curve_done(const int m, const int mmin, const double* const x, const double ctol, const double tbud, const double tused, const double tnext)
+{
+	// Sequence-length scheduler: if normalised x(m) ~ x(inf) + c/m, then the projected
+	// change from x(m) to x(inf) is |x(m-1)-x(m)|*(m-1). Stop when this has been within
+	// tolerance ctol for two successive lengths, or when the predicted time for the next
+	// length would exceed the time budget tbud (zero means no tolerance/budget).
+	if (tbud > 0.0 && tused+tnext > tbud) return 1;
+	if (ctol > 0.0 && m >= mmin+2) {
+		const double d1 = fabs(x[m-1]-x[m  ])*(double)(m-1);
+		const double d2 = fabs(x[m-2]-x[m-1])*(double)(m-2);
+		if (d1 < ctol && d2 < ctol) return 1;
+	}
+	return 0;
+}
+
+int rt_entro_curve( // normalised entropy curve for sequence lengths mmin,...,mmax, with optional early stopping (returns final length)
+	const int           size,
+	const word_t* const tab,
+	const int           mmin,
+	const int           mmax,
+	const int           iff,
+	const int           order,
+	const double        ctol,
+	const double        tbud,
+	uint64_t*     const bin,
+	double*       const H
+)
+{
+	// Note: entries of H above the returned sequence length are not touched
+	const double ts = get_thread_cpu_time();
+	double tm = ts;
+	const double cgrow = order == 2 ? 4.0 : 2.0; // cost doubles with m (quadruples for pairs)
+	for (int m=mmin; m<=mmax; ++m) {
+		H[m] = (order == 2 ? rt_entro2(size,tab,m,iff,bin) : rt_entro(size,tab,m,iff,bin))/(double)m;
+		const double t = get_thread_cpu_time();
+		if (rt_curve_done(m,mmin,H,ctol,tbud,t-ts,cgrow*(t-tm))) return m;
+		tm = t;
+	}
+	return mmax;
+}
+
+int rt_dd_curve( // normalised DD curve for sequence lengths mmin,...,mmax, with optional early stopping (returns final length)
+	const int           rsiz,
+	const word_t* const rtab,
+	const int           fsiz,
+	const word_t* const ftab,
+	const int           mmin,
+	const int           mmax,
+	const int           iff,
+	const int           ilag,
+	const int           order,
+	const double        ctol,
+	const double        tbud,
+	uint64_t*     const bin,
+	uint64_t*     const bin2,
+	double*       const DD
+)
+{
+	// Note: entries of DD above the returned sequence length are not touched
+	const double ts = get_thread_cpu_time();
+	double tm = ts;
+	for (int m=mmin; m<=mmax; ++m) {
+		DD[m] = (order == 2 ? rt_dd2(rsiz,rtab,fsiz,ftab,m,iff,ilag,bin,bin2) : rt_dd(rsiz,rtab,fsiz,ftab,m,iff,ilag,bin,bin2))/(double)m;
+		const double t = get_thread_cpu_time();
+		if (rt_curve_done(m,mmin,DD,ctol,tbud,t-ts,4.0*(t-tm))) return m; // cost quadruples with m (joint histogram)
+		tm = t;
+	}
+	return mmax;
+}
+
+int rt_lumpable( // exact test for zero dynamical dependence of CA/filter rules on sequence of length m
+	const int           rsiz,
+	const word_t* const rtab,
+	const int           fsiz,
+	const word_t* const ftab,
+	const int           m,
+	const int           iff,
+	const int           ilag,
+	word_t*       const succ
+)
+{
+	// DD = 0 iff the filtered process is a deterministic function of its
+	// own past, i.e. every preimage of filtered state u maps to the same
+	// filtered successor v. We record v for each u in the consistency table
+	// succ (length 2^m) and bail out on the first conflict.
+
+	const size_t S = POW2(m);
+	for (size_t u=0; u<S; ++u) succ[u] = WONES; // sentinel: no filtered state has all bits set above m
+	for (word_t x=WZERO; x<S; ++x) {
+		word_t y = x;
+		for (int i=0; i<iff; ++i) y = wd_filter(m,y,rsiz,rtab);  // advance CA (may be zero)
+		const word_t u = wd_filter(m,y,fsiz,ftab);               // filter CA
+		for (int i=0; i<ilag; ++i) y = wd_filter(m,y,rsiz,rtab); // advance CA (at least 1)
+		const word_t v = wd_filter(m,y,fsiz,ftab);               // filter CA
+		if (succ[u] == WONES) succ[u] = v;
+		else if (succ[u] != v) return 0; // conflict: DD > 0
+	}
+	return 1; // lumpable: DD = 0
+}
+
+int rt_lumpable_mmax( // first sequence length in [mmin,mmax] with nonzero DD (or 0 if none)
+	const int           rsiz,
+	const word_t* const rtab,
+	const int           fsiz,
+	const word_t* const ftab,
+	const int           mmin,
+	const int           mmax,
+	const int           iff,
+	const int           ilag,
+	word_t*       const succ
+)
+{
+	// Note: succ must have length at least 2^mmax
+	for (int m=mmin; m<=mmax; ++m) if (!rt_lumpable(rsiz,rtab,fsiz,ftab,m,iff,ilag,succ)) return m;
+	return 0;
+}
+
+/*********************************************************************/
+/*       topological entropy of image language (de Bruijn automaton) */
+/*********************************************************************/
+
+// The image language of F (words labelling some de Bruijn path) is accepted
+// by the de Bruijn graph read as an NFA with all states initial and final.
+// Subset construction from the full node set gives a DFA whose non-empty
+// states are all accepting, so the number of image words of length k is the
+// number of length-k paths from the start state; the topological entropy is
+// then log2 of the spectral radius of the transition matrix of the (Moore-
+// minimised) DFA. The spectral radius is found by power iteration on A+I (the
+// shift makes the dominant eigenvalue unique in modulus).
+
+typedef struct {
+	size_t s;
+	size_t sig[3];
+} rt_msig_t;
+
+static int rt_msig_comp(const void* const x1, const void* const x2)
+{
+	const rt_msig_t* const a = (const rt_msig_t*)x1;
+	const rt_msig_t* const b = (const rt_msig_t*)x2;
+	for (int i=0;i<3;++i) if (a->sig[i] != b->sig[i]) return a->sig[i] < b->sig[i] ? -1 : +1;
+	return 0;
+}
+
+double rt_topent(const int size, const word_t* const tab, const size_t maxstates, size_t* const ndfa, size_t* const nmin)
+{
+	// topological entropy (bits per symbol) of image language; returns NaN if DFA exceeds maxstates
+	ASSERT(size >= 1 && size <= 7,"rule size must be in range 1 - 7");
+	const size_t n = POW2(size-1);
+	word_t T[2][WBITS]; // node p -> successors under label b
+	for (size_t p=0;p<n;++p) {T[0][p] = WZERO; T[1][p] = WZERO;}
+	for (size_t r=0;r<2*n;++r) SETBIT(T[RTBIT(tab,r)][r&(n-1)],r>>1);
+
+	// subset construction (dead state = maxstates)
+
+	const size_t DEAD = maxstates;
+	size_t H = 2;
+	while (H < 2*maxstates) H <<= 1;
+	const size_t HMASK = H-1;
+	word_t* const sub  = mw_alloc(maxstates);
+	size_t* const d    = malloc(2*maxstates*sizeof(size_t));
+	TEST_ALLOC(d);
+	size_t* const htab = malloc(H*sizeof(size_t));
+	TEST_ALLOC(htab);
+	for (size_t i=0;i<H;++i) htab[i] = DEAD;
+	size_t ns = 0;
+	sub[ns++] = n == WBITS ? WONES : POW2(n)-1; // start: all nodes
+	htab[(size_t)rt_hmix(sub[0])&HMASK] = 0;
+	int ok = 1;
+	for (size_t s=0;s<ns && ok;++s) {
+		for (int b=0;b<2 && ok;++b) {
+			word_t t = WZERO;
+			for (word_t u=sub[s]; u; u &= u-1) t |= T[b][__builtin_ctzll(u)];
+			if (t == WZERO) {d[2*s+(size_t)b] = DEAD; continue;}
+			size_t j = (size_t)rt_hmix(t)&HMASK;
+			while (htab[j] != DEAD && sub[htab[j]] != t) j = (j+1)&HMASK;
+			if (htab[j] == DEAD) {
+				if (ns == maxstates) {ok = 0; break;}
+				sub[ns] = t;
+				htab[j] = ns++;
+			}
+			d[2*s+(size_t)b] = htab[j];
+		}
+	}
+	free(htab);
+	free(sub);
+	if (!ok) {
+		free(d);
+		return NAN;
+	}
+	if (ndfa != NULL) *ndfa = ns;
+
+	// Moore minimisation (all states accepting; dead state gets class DEAD)
+
+	size_t* const cls = calloc(ns,sizeof(size_t)); // zero-initialises: one class
+	TEST_ALLOC(cls);
+	rt_msig_t* const sig = malloc(ns*sizeof(rt_msig_t));
+	TEST_ALLOC(sig);
+	size_t nc = 1;
+	while (1) {
+		for (size_t s=0;s<ns;++s) {
+			sig[s].s = s;
+			sig[s].sig[0] = cls[s];
+			sig[s].sig[1] = d[2*s  ] == DEAD ? DEAD : cls[d[2*s  ]];
+			sig[s].sig[2] = d[2*s+1] == DEAD ? DEAD : cls[d[2*s+1]];
+		}
+		qsort(sig,ns,sizeof(rt_msig_t),rt_msig_comp);
+		size_t c = 0;
+		for (size_t i=0;i<ns;++i) {
+			if (i > 0 && rt_msig_comp(&sig[i],&sig[i-1]) != 0) ++c;
+			cls[sig[i].s] = c;
+		}
+		if (c+1 == nc) break; // stable
+		nc = c+1;
+	}
+	free(sig);
+	if (nmin != NULL) *nmin = nc;
+
+	// minimal DFA transitions (class representatives)
+
+	size_t* const dm = malloc(2*nc*sizeof(size_t));
+	TEST_ALLOC(dm);
+	for (size_t s=0;s<ns;++s) {
+		dm[2*cls[s]  ] = d[2*s  ] == DEAD ? DEAD : cls[d[2*s  ]];
+		dm[2*cls[s]+1] = d[2*s+1] == DEAD ? DEAD : cls[d[2*s+1]];
+	}
+	free(cls);
+	free(d);
+
+	// spectral radius by power iteration on A+I: x <- (A+I)^T x (same spectrum),
+	// with x normalised to unit sum, so that the sum after a step estimates the
+	// eigenvalue. Stop only when the normalised vector itself has converged:
+	// individual entries (e.g. the largest) may repeat long before then.
+
+	double* const x  = malloc(nc*sizeof(double));
+	TEST_ALLOC(x);
+	double* const x1 = malloc(nc*sizeof(double));
+	TEST_ALLOC(x1);
+	for (size_t c=0;c<nc;++c) x[c] = 1.0/(double)nc;
+	double lam = 0.0;
+	for (int it=0;it<1000000;++it) {
+		for (size_t c=0;c<nc;++c) x1[c] = x[c];
+		for (size_t c=0;c<nc;++c) {
+			if (dm[2*c  ] != DEAD) x1[dm[2*c  ]] += x[c];
+			if (dm[2*c+1] != DEAD) x1[dm[2*c+1]] += x[c];
+		}
+		lam = 0.0;
+		for (size_t c=0;c<nc;++c) lam += x1[c];
+		double dx = 0.0;
+		for (size_t c=0;c<nc;++c) {
+			const double xc = x1[c]/lam;
+			dx += fabs(xc-x[c]);
+			x[c] = xc;
+		}
+		if (dx < 1e-14) break;
+	}
+	free(x1);
+	free(x);
+	free(dm);
+
+	const double rho = lam-1.0;
+	return rho > 1.0 ? log2(rho) : 0.0; // rho < 1 (finite language) only for the empty language
+}
@@ -7,36 +7,54 @@
 /*              rule table (double-linked) list                      */
 /*********************************************************************/
 
+typedef enum {RT_TABLE = 0, RT_TOTAL, RT_OUTER} rtype_t; // rule type (see (outer-)totalistic rules below)
+
 typedef struct rtl_node {
 	int              size;
-	word_t*          tab;
+	word_t*          tab;   // NULL for table-free (outer-)totalistic rules (size > RT_TOTTABMAXB)
+	rtype_t          rtype; // rule type, classified once (see rtl_classify)
+	word_t           mask;  // (outer-)totalistic mask
 	struct rtl_node* prev;
 	struct rtl_node* next;
 	struct rtl_node* filt; // pointer to filter list
 } rtl_t;
 
-rtl_t*  rtl_add    (rtl_t* curr, const int size); // insert after
+rtl_t*  rtl_add    (rtl_t* curr, const int size); // insert after (as a lookup table rule)
+rtl_t*  rtl_add_tot(rtl_t* curr, const int size, const rtype_t rtype, const word_t mask); // insert after (table only up to RT_TOTTABMAXB)
+rtl_t*  rtl_add_id (rtl_t* curr, const char* const str, int* const size); // insert after, classified; curr and *size < 0 on failure (as rt_sread_id)
+void    rtl_classify(rtl_t* const r); // set type and mask from table (call after the table changes)
 rtl_t*  rtl_del    (rtl_t* curr);
 void    rtl_free   (rtl_t* curr);
 rtl_t*  rtl_find   (const rtl_t* const rule, const int size, const word_t* const tab);
+rtl_t*  rtl_find_tot(const rtl_t* const rule, const int size, const rtype_t rtype, const word_t mask);
+rtl_t*  rtl_equiv  (const rtl_t* const rule, const int size, const word_t* const tab);
 rtl_t*  rtl_init   (rtl_t* rule);
 int*    rtl_nitems (const rtl_t* const rule, int* const nrules, int* const nfilts);
 rtl_t*  rtl_fread  (FILE* rtfs);
 
+static inline const word_t* rtl_ktab(const rtl_t* const r)
+{
+	// stepping kernel argument: the table, or the mask for table-free rules (cf. tune_kernel)
+	return r->tab != NULL ? r->tab : &r->mask;
+}
+
 /*********************************************************************/
 /*                      rule table                                   */
 /*********************************************************************/
 
+static inline size_t rt_nwords(const int size)
+{
+	return size > 6 ? POW2(size-6) : 1;
+}
+
 static inline void rt_copy(const int size, word_t* const rtdest, const word_t* const rtsrc)
 {
-	memcpy(rtdest,rtsrc,POW2(size)*sizeof(word_t));
+	memcpy(rtdest,rtsrc,rt_nwords(size)*sizeof(word_t));
 }
 
 static inline size_t rt_nsetbits(const int size, const word_t* const tab)
 {
-	size_t b = 0;
-	for (size_t r=0;r<POW2(size);++r) if (tab[r]) ++b;
-	return b;
+	return (size_t)mw_nsetbits(rt_nwords(size),tab); // unused hi-bits are clear
 }
 
 static inline double rt_lambda(const int size, const word_t* const tab) // Langton's lambda
@@ -44,11 +62,6 @@ static inline double rt_lambda(const int size, const word_t* const tab) // Langt
 	return (double)rt_nsetbits(size,tab)/(double)POW2(size);
 }
 
-static inline size_t rt_nwords(const int size)
-{
-	return size > 6 ? POW2(size-6) : 1;
-}
-
 static inline size_t rt_hexchars(const int size)
 {
 	return size > 2 ? POW2(size-2) : 1;
@@ -66,23 +79,104 @@ static inline int rt_hexsize(const size_t len)
 
 static inline void rt_randomise(const int size, word_t* const tab, const double lam, mt_t* const prng)
 {
-	for (size_t r=0;r<POW2(size);++r) tab[r] = (mt_rand(prng) < lam ? WONE : WZERO);
+	memset(tab,0,rt_nwords(size)*sizeof(word_t));
+	for (size_t r=0;r<POW2(size);++r) if (mt_rand(prng) < lam) RTSET(tab,r,WONE);
+}
+
+static inline void rt_randomise_xr(const int size, word_t* const tab, const double lam, xr_t* const prng)
+{
+	// bulk version (lam rounded to WBPREC binary digits)
+	mw_randomiseb_xr(rt_nwords(size),tab,lam,prng);
+	if (size < 6) tab[0] &= WONES>>(WBITS-(int)POW2(size)); // keep unused hi-bits clear
 }
 
 static inline void rt_invert(const int size, word_t* const tab)
 {
-	for (size_t r=0;r<POW2(size);++r) tab[r] = WONE-tab[r];
+	const size_t nw = rt_nwords(size);
+	for (size_t k=0;k<nw;++k) tab[k] = ~tab[k];
+	if (size < 6) tab[0] &= WONES>>(WBITS-(int)POW2(size)); // keep unused hi-bits clear
+}
+
+static inline word_t rt_symval(const int size, const word_t* const tab, const int g, const size_t r)
+{
+	// entry r of the rule table transformed by symmetry g (bit 0: left-right reflection, bit 1: 0/1 complement)
+	const size_t S1 = POW2(size)-1;
+	const size_t rc = g&2 ? S1^r : r;
+	const size_t rr = g&1 ? (size_t)(wd_reverse(rc)>>(WBITS-size)) : rc;
+	return g&2 ? WONE-RTBIT(tab,rr) : RTBIT(tab,rr);
 }
 
 word_t* rt_alloc       (const int size);
 
+// (Outer-)totalistic rules (see mw_total/mw_outer in word.h) have compact ids
+// T<B>:<mask> and O<B>:<mask>, with the mask in hex; rt_sread_id accepts them
+// too, expanding them to a table (for sizes up to RT_TOTTABMAXB; rb_sread_id
+// in bdd.h builds larger ones as decision diagrams, without a table). Rule
+// lists carry the type and mask, and larger rules there have no table.
+
+#define RT_TOTTABMAXB 30 // largest (outer-)totalistic rule expanded to a table
+
+static inline int rt_tot_maxb(const rtype_t rtype)
+{
+	return rtype == RT_OUTER ? WOUTMAXB : WTOTMAXB;
+}
+
+static inline word_t rt_tot_bits(const int size, const rtype_t rtype)
+{
+	// mask of valid rule mask bits
+	const int nbits = rtype == RT_OUTER ? 2*size : size+1;
+	return nbits < WBITS ? POW2(nbits)-1 : WONES;
+}
+
+rtype_t rt_totalistic      (const int size, const word_t* const tab, word_t* const mask); // rule type (totalistic takes precedence) and mask
+void    rt_from_totalistic (const int size, word_t* const tab, const rtype_t rtype, const word_t mask);
+word_t  rt_tot_random      (const int size, const rtype_t rtype, const double lam, mt_t* const prng); // random mask (each bit set with probability lam)
+word_t  rt_tot_random_xr   (const int size, const rtype_t rtype, const double lam, xr_t* const prng);
+int     rt_tot_sread_id    (const char* const str, int* const size, rtype_t* const rtype, word_t* const mask); // 1 on success, 0 if not a T/O id, -1 bad size, -2 bad mask
+void    rt_tot_fprint_id   (const int size, const rtype_t rtype, const word_t mask, FILE* const fstream);
+void    rt_tot_print_id    (const int size, const rtype_t rtype, const word_t mask);
+double  rt_tot_lambda      (const int size, const rtype_t rtype, const word_t mask); // Langton's lambda
+mw_filter_t rt_tot_kernel  (const rtype_t rtype); // mask kernel
+
+static inline void rt_randomise_typed(const int size, word_t* const tab, const rtype_t rtype, const double lam, mt_t* const prng)
+{
+	// random rule of given type (for (outer-)totalistic rules, lam is the probability of a mask bit being set)
+	if (rtype == RT_TABLE) rt_randomise(size,tab,lam,prng);
+	else rt_from_totalistic(size,tab,rtype,rt_tot_random(size,rtype,lam,prng));
+}
+
+static inline void rt_randomise_typed_xr(const int size, word_t* const tab, const rtype_t rtype, const double lam, xr_t* const prng)
+{
+	if (rtype == RT_TABLE) rt_randomise_xr(size,tab,lam,prng);
+	else rt_from_totalistic(size,tab,rtype,rt_tot_random_xr(size,rtype,lam,prng));
+}
+
 void    rt_randomb     (const int size, word_t* const tab, const size_t b, mt_t* const prng);
 void    rt_from_mwords (const int size, word_t* const tab, const size_t nrtwords, const word_t* const rtwords);
 word_t* rt_fread_id    (FILE* const fstream, int* const size);   // allocates rule table on sucess - remember to free!
 word_t* rt_read_id     (int* const size);                        // allocates rule table on sucess - remember to free!
 word_t* rt_sread_id    (const char* const str, int* const size); // allocates rule table on sucess - remember to free!
 
-size_t  rt_uwords      (const int size, const word_t* const tab, const int m);
+int     rt_compose_k    (const int size, size_t cbytes);
+word_t* rt_compose      (const int size, const word_t* const tab, const int k, int* const csiz);                                                 // allocates - remember to free!
+word_t* rt_compose_filt (const int rsiz, const word_t* const rtab, const int k, const int fsiz, const word_t* const ftab, int* const csiz); // allocates - remember to free!
+void    rt_run          (const size_t I, const size_t n, word_t* const w, const int size, const word_t* const tab);
+
+void     rt_symmetry       (const int size, word_t* const dest, const word_t* const src, const int g);
+int      rt_canonical      (const int size, const word_t* const tab, word_t* const ctab);
+int      rt_canonical_pair (const int rsiz, const word_t* const rtab, const int fsiz, const word_t* const ftab, word_t* const crtab, word_t* const cftab);
+int      rt_equiv          (const int size, const word_t* const tab1, const word_t* const tab2);
+int      rt_equiv_pair     (const int rsiz, const word_t* const rtab1, const word_t* const rtab2, const int fsiz, const word_t* const ftab1, const word_t* const ftab2);
+uint64_t rt_hash           (const int size, const word_t* const tab); // symmetry-invariant
+uint64_t rt_hash_tab       (const int size, const word_t* const tab); // table only
+uint64_t rt_hash_pair      (const int rsiz, const word_t* const rtab, const int fsiz, const word_t* const ftab);
+size_t   rt_pair_dups      (const size_t n, const int* const rsiz, const word_t* const* const rtab, const int* const fsiz, const word_t* const* const ftab, size_t* const dup);
+
+size_t  rt_uwords      (const int size, const word_t* const tab, const int m, const int nthreads);
+int     rt_surjective  (const int size, const word_t* const tab);
+int     rt_injective   (const int size, const word_t* const tab);
+int     rt_ring_goe    (const int size, const word_t* const tab, const int m, const size_t maxstates, uint64_t* const ngoe);
+double  rt_topent      (const int size, const word_t* const tab, const size_t maxstates, size_t* const ndfa, size_t* const nmin);
 void    rt_to_mwords   (const int size, const word_t* const tab, const size_t nrtwords, word_t* const rtwords);
 void    rt_fprint      (const int size, const word_t* const tab, FILE* const fstream);
 void    rt_fprint_id   (const int size, const word_t* const tab, FILE* const fstream);
@@ -110,6 +204,79 @@ double rt_dd( // dynamical dependence for CA/filter rules on sequence of length
 	uint64_t*     const bin2
 );
 
+double rt_entro2( // as rt_entro, for second-order CA (over all 2^(2m) pairs of sequences; cf. ca_run2)
+	const int           size,
+	const word_t* const tab,
+	const int           m,
+	const int           iff,
+	uint64_t*     const bin
+);
+
+double rt_dd2( // as rt_dd, for second-order CA (over all 2^(2m) pairs of sequences; cf. ca_run2)
+	const int           rsiz,
+	const word_t* const rtab,
+	const int           fsiz,
+	const word_t* const ftab,
+	const int           m,
+	const int           iff,
+	const int           ilag,
+	uint64_t*     const bin,
+	uint64_t*     const bin2
+);
+
+int rt_entro_curve( // normalised entropy curve for sequence lengths mmin,...,mmax, with optional early stopping (returns final length)
+	const int           size,
+	const word_t* const tab,
+	const int           mmin,
+	const int           mmax,
+	const int           iff,
+	const int           order, // 1, or 2 for second-order CA
+	const double        ctol,
+	const double        tbud,
+	uint64_t*     const bin,
+	double*       const H
+);
+
+int rt_dd_curve( // normalised DD curve for sequence lengths mmin,...,mmax, with optional early stopping (returns final length)
+	const int           rsiz,
+	const word_t* const rtab,
+	const int           fsiz,
+	const word_t* const ftab,
+	const int           mmin,
+	const int           mmax,
+	const int           iff,
+	const int           ilag,
+	const int           order, // 1, or 2 for second-order CA
+	const double        ctol,
+	const double        tbud,
+	uint64_t*     const bin,
+	uint64_t*     const bin2,
+	double*       const DD
+);
+
+int rt_lumpable( // exact test for zero dynamical dependence of CA/filter rules on sequence of length m
+	const int           rsiz,
+	const word_t* const rtab,
+	const int           fsiz,
+	const word_t* const ftab,
+	const int           m,
+	const int           iff,
+	const int           ilag,
+	word_t*       const succ
+);
+
+int rt_lumpable_mmax( // first sequence length in [mmin,mmax] with nonzero DD (or 0 if none)
+	const int           rsiz,
+	const word_t* const rtab,
+	const int           fsiz,
+	const word_t* const ftab,
+	const int           mmin,
+	const int           mmax,
+	const int           iff,
+	const int           ilag,
+	word_t*       const succ
+);
+
 static const char hexchar[] = {'0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'};
 
 static inline word_t hex2word(const char c)
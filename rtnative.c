@@ -0,0 +1,247 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef HAVE_DLOPEN
+#include <dlfcn.h>
+#endif
+
+#include "rtnative.h"
+#include "rtab.h"
+
+/*********************************************************************/
+/*                     circuit generation                            */
+/*********************************************************************/
+
+// Node handles: RTN_ZERO/RTN_ONES for constant subtables, else k >= 0 for
+// emitted temporary t<k>. Subtables at each level are memoised (by content),
+// so equal subfunctions are computed once. A subtable is a run of entries of
+// the (bit-packed) rule table, identified by its entry offset.
+
+#define RTN_ZERO (-1)
+#define RTN_ONES (-2)
+
+typedef struct {
+	size_t off; // subtable entry offset into rule table
+	int    h;   // node handle
+} rtn_memo_t;
+
+typedef struct {
+	FILE*         fs;
+	const word_t* tab;
+	int           ntemps;
+	rtn_memo_t* memo[RT_NATIVE_MAXB]; // memo per level
+	size_t      nmemo[RT_NATIVE_MAXB];
+} rtn_gen_t;
+
+static void rtn_operand(FILE* const fs, const int h)
+{
+	if      (h == RTN_ZERO) fputs("Z",fs);
+	else if (h == RTN_ONES) fputs("O",fs);
+	else                    fprintf(fs,"t%d",h);
+}
+
+static inline word_t rtn_subword(const word_t* const tab, const size_t off, const size_t S)
+{
+	// subtable of S < WBITS entries at offset off (S is a power of 2, so it does not straddle words)
+	return (tab[off>>6]>>(off&63))&(WONES>>(WBITS-(int)S));
+}
+
+static int rtn_node(rtn_gen_t* const g, const int v, const size_t off)
+{
+	// handle for subtable at entry offset off of size 2^(v+1), split on variable v (cell offset v)
+	const word_t* const tab = g->tab;
+	const size_t S = POW2(v+1);
+	const size_t nset = S < WBITS ? (size_t)wd_nsetbits(rtn_subword(tab,off,S)) : (size_t)mw_nsetbits(S>>6,tab+(off>>6));
+	if (nset == 0) return RTN_ZERO;
+	if (nset == S) return RTN_ONES;
+	for (size_t i=0; i<g->nmemo[v]; ++i) {
+		const size_t moff = g->memo[v][i].off;
+		const int same = S < WBITS ? rtn_subword(tab,moff,S) == rtn_subword(tab,off,S) : mw_equal(S>>6,tab+(moff>>6),tab+(off>>6));
+		if (same) return g->memo[v][i].h;
+	}
+	const size_t H = S/2;
+	const int lo = v > 0 ? rtn_node(g,v-1,off)   : (RTBIT(tab,off)   ? RTN_ONES : RTN_ZERO);
+	const int hi = v > 0 ? rtn_node(g,v-1,off+H) : (RTBIT(tab,off+1) ? RTN_ONES : RTN_ZERO);
+	int h;
+	if (lo == hi) {
+		h = lo;
+	}
+	else {
+		h = g->ntemps++;
+		FILE* const fs = g->fs;
+		fprintf(fs,"\t\tconst word_t t%d = ",h);
+		if      (lo == RTN_ZERO && hi == RTN_ONES) fprintf(fs,"x%d",v);
+		else if (lo == RTN_ONES && hi == RTN_ZERO) fprintf(fs,"~x%d",v);
+		else if (lo == RTN_ZERO) {fprintf(fs,"x%d&",v);  rtn_operand(fs,hi);}
+		else if (hi == RTN_ZERO) {fprintf(fs,"~x%d&",v); rtn_operand(fs,lo);}
+		else if (lo == RTN_ONES) {fprintf(fs,"~x%d|",v); rtn_operand(fs,hi);}
+		else if (hi == RTN_ONES) {fprintf(fs,"x%d|",v);  rtn_operand(fs,lo);}
+		else { // lo ^ (x & (lo ^ hi))
+			rtn_operand(fs,lo); fprintf(fs,"^(x%d&(",v); rtn_operand(fs,lo); fputc('^',fs); rtn_operand(fs,hi); fputs("))",fs);
+		}
+		fputs(";\n",fs);
+	}
+	rtn_memo_t* const m = realloc(g->memo[v],(g->nmemo[v]+1)*sizeof(rtn_memo_t));
+	TEST_ALLOC(m);
+	g->memo[v] = m;
+	m[g->nmemo[v]].off = off;
+	m[g->nmemo[v]].h   = h;
+	++g->nmemo[v];
+	return h;
+}
+
+int rt_native_source(const int size, const word_t* const tab, FILE* const fstream)
+{
+	// C source for bit-sliced kernel (same signature as mw_filter); returns number of circuit nodes
+	ASSERT(size >= 1 && size <= RT_NATIVE_MAXB,"rule size out of range for native code");
+	FILE* const fs = fstream;
+	fputs("// generated by caxplor: do not edit\n\n#include <stddef.h>\n#include <stdint.h>\n\ntypedef uint64_t word_t;\n\n",fs);
+	fputs("const char rt_native_id[] = \"",fs);
+	rt_fprint_id(size,tab,fs);
+	fputs("\";\n\n",fs);
+	fputs("void rt_native_kernel(const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f)\n{\n",fs);
+	fputs("\tconst word_t Z = 0, O = ~(word_t)0;\n\t(void)B; (void)f; (void)Z; (void)O;\n",fs);
+	fputs("\tfor (size_t k=0; k<n; ++k) {\n\t\tconst word_t a = w[k], b = k < n-1 ? w[k+1] : w[0];\n\t\t(void)b;\n",fs);
+	fputs("\t\tconst word_t x0 = a;\n",fs);
+	for (int j=1; j<size; ++j) fprintf(fs,"\t\tconst word_t x%d = (a>>%d)|(b<<%d);\n",j,j,WBITS-j); // cells i+j, for each bit i
+	rtn_gen_t g;
+	g.fs = fs;
+	g.tab = tab;
+	g.ntemps = 0;
+	for (int v=0; v<RT_NATIVE_MAXB; ++v) {g.memo[v] = NULL; g.nmemo[v] = 0;}
+	const int h = rtn_node(&g,size-1,0);
+	for (int v=0; v<RT_NATIVE_MAXB; ++v) free(g.memo[v]);
+	fputs("\t\twnew[k] = ",fs);
+	rtn_operand(fs,h);
+	fputs(";\n\t}\n}\n",fs);
+	return g.ntemps;
+}
+
+/*********************************************************************/
+/*                compile, cache and load                            */
+/*********************************************************************/
+
+static int rtn_mkdirp(const char* const path)
+{
+	// mkdir -p
+	char buf[1024];
+	if (snprintf(buf,sizeof(buf),"%s",path) >= (int)sizeof(buf)) return 0;
+	for (char* p=buf+1; *p; ++p) {
+		if (*p != '/') continue;
+		*p = '\0';
+		if (mkdir(buf,0755) == -1 && errno != EEXIST) return 0;
+		*p = '/';
+	}
+	return mkdir(buf,0755) == 0 || errno == EEXIST;
+}
+
+const char* rt_native_dir(void)
+{
+	static char dir[1024];
+	const char* const xdg  = getenv("XDG_CACHE_HOME");
+	const char* const home = getenv("HOME");
+	if      (xdg  != NULL && xdg[0]  != '\0') snprintf(dir,sizeof(dir),"%s/caxplor",xdg);
+	else if (home != NULL && home[0] != '\0') snprintf(dir,sizeof(dir),"%s/.cache/caxplor",home);
+	else                                      snprintf(dir,sizeof(dir),"/tmp/caxplor-cache");
+	rtn_mkdirp(dir); // create if necessary (callers cope with failure)
+	return dir;
+}
+
+#ifdef HAVE_DLOPEN
+
+#define RTN_MAXCCARGS 32 // maximum words in $CC
+
+static int rtn_compile(const char* const cc, const char* const sofile, const char* const srcfile)
+{
+	// run the compiler directly, without a shell, so that neither the cache paths
+	// nor $CC are interpreted; $CC may be a command with options (split on
+	// whitespace). Returns 1 on success.
+	static const char* const opts[] = {"-std=c99","-O3","-march=native","-fPIC","-shared","-w","-o"};
+	const int nopts = (int)(sizeof(opts)/sizeof(opts[0]));
+	char ccbuf[strlen(cc)+1];
+	strcpy(ccbuf,cc);
+	char* argv[RTN_MAXCCARGS+nopts+3];
+	int argc = 0;
+	char* save = NULL;
+	for (char* tok = strtok_r(ccbuf," \t",&save); tok != NULL; tok = strtok_r(NULL," \t",&save)) {
+		if (argc == RTN_MAXCCARGS) return 0;
+		argv[argc++] = tok;
+	}
+	if (argc == 0) return 0;
+	for (int i=0;i<nopts;++i) argv[argc++] = (char*)opts[i];
+	argv[argc++] = (char*)sofile;
+	argv[argc++] = (char*)srcfile;
+	argv[argc]   = NULL;
+	fflush(NULL); // don't duplicate buffered output in the child
+	const pid_t pid = fork();
+	if (pid < 0) return 0;
+	if (pid == 0) { // child: compiler diagnostics discarded
+		const int fd = open("/dev/null",O_WRONLY);
+		if (fd >= 0) {dup2(fd,STDERR_FILENO); close(fd);}
+		execvp(argv[0],argv);
+		_exit(127); // no compiler
+	}
+	int status;
+	while (waitpid(pid,&status,0) < 0) if (errno != EINTR) return 0;
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static mw_filter_t rtn_load(const char* const sofile, const int size, const word_t* const tab)
+{
+	// load kernel from shared object, checking the embedded rule id (handle deliberately never closed)
+	void* const dl = dlopen(sofile,RTLD_NOW|RTLD_LOCAL);
+	if (dl == NULL) return NULL;
+	const char* const id = (const char*)dlsym(dl,"rt_native_id");
+	void* const sym = dlsym(dl,"rt_native_kernel");
+	if (id == NULL || sym == NULL) {dlclose(dl); return NULL;}
+	int idsiz;
+	word_t* const idtab = rt_sread_id(id,&idsiz);
+	const int same = idsiz == size && mw_equal(rt_nwords(size),idtab,tab);
+	free(idtab);
+	if (!same) {dlclose(dl); return NULL;} // hash collision (or stale file)
+	mw_filter_t kernel;
+	memcpy(&kernel,&sym,sizeof(kernel)); // object -> function pointer (POSIX)
+	return kernel;
+}
+
+#endif
+
+mw_filter_t rt_native(const int size, const word_t* const tab, const char* cdir)
+{
+#ifdef HAVE_DLOPEN
+	if (size < 1 || size > RT_NATIVE_MAXB) return NULL;
+	if (cdir == NULL || cdir[0] == '\0') cdir = rt_native_dir();
+	if (!rtn_mkdirp(cdir)) return NULL;
+
+	const size_t fnlen = strlen(cdir)+64;
+	char srcfile[fnlen], sofile[fnlen], tmpfile[fnlen];
+	const unsigned long long hash = (unsigned long long)rt_hash_tab(size,tab); // not rt_hash: equivalent rules have different kernels
+	snprintf(srcfile,fnlen,"%s/rt%02d_%016llx.c", cdir,size,hash);
+	snprintf(sofile, fnlen,"%s/rt%02d_%016llx.so",cdir,size,hash);
+	snprintf(tmpfile,fnlen,"%s/rt%02d_%016llx.so.%ld",cdir,size,hash,(long)getpid());
+
+	mw_filter_t kernel = rtn_load(sofile,size,tab); // cached?
+	if (kernel != NULL) return kernel;
+
+	// generate source and compile (to a temporary, renamed into place so concurrent runs are safe)
+
+	FILE* const fs = fopen(srcfile,"w");
+	if (fs == NULL) return NULL;
+	rt_native_source(size,tab,fs);
+	if (fclose(fs) != 0) return NULL;
+	const char* const cc = getenv("CC") != NULL && getenv("CC")[0] != '\0' ? getenv("CC") : "cc";
+	if (!rtn_compile(cc,tmpfile,srcfile)) {remove(tmpfile); return NULL;} // no compiler, or compile failed
+	if (rename(tmpfile,sofile) != 0) {remove(tmpfile); return NULL;}
+	return rtn_load(sofile,size,tab);
+#else
+	return NULL;
+#endif
+}
+
+mw_filter_t rt_native_sel(const int size, const word_t* const tab, const char* cdir)
+{
+	const mw_filter_t kernel = rt_native(size,tab,cdir);
+	return kernel != NULL ? kernel : mw_filter_sel(size);
+}
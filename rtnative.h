@@ -0,0 +1,26 @@
+#ifndef RTNATIVE_H
+#define RTNATIVE_H
+
+#include "word.h"
+
+/*********************************************************************/
+/*          native (compiled) rule kernels, loaded with dlopen       */
+/*********************************************************************/
+
+// A rule table is turned into a bit-sliced boolean circuit (a reduced
+// Shannon decomposition, i.e. the rule's BDD with shared subtables), emitted
+// as C source, compiled by the system C compiler into a shared object and
+// loaded with dlopen. Compiled rules are cached on disk, keyed by a hash of
+// the table (rules equivalent under symmetry have different kernels); the full
+// rule id is embedded in the object and checked on load. If there
+// is no compiler, or caxplor was built without dlopen support, rt_native
+// returns NULL and rt_native_sel falls back to the generic kernels.
+
+#define RT_NATIVE_MAXB 16 // largest rule size for which native code is generated
+
+const char* rt_native_dir    (void); // default cache directory (created if necessary)
+int         rt_native_source (const int size, const word_t* const tab, FILE* const fstream);
+mw_filter_t rt_native        (const int size, const word_t* const tab, const char* cdir);
+mw_filter_t rt_native_sel    (const int size, const word_t* const tab, const char* cdir);
+
+#endif // RTNATIVE_H
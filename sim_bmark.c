@@ -2,6 +2,8 @@
 
 #include "ca.h"
 #include "rtab.h"
+#include "tune.h"
+#include "bdd.h"
 #include "clap.h"
 
 int sim_bmark(int argc, char* argv[], int info)
@@ -17,6 +19,9 @@ int sim_bmark(int argc, char* argv[], int info)
 	CLAP_CARG(I,       size_t,  1000,         "number of iterations");
 	CLAP_CARG(S,       size_t,  1000,         "number of samples");
 	CLAP_CARG(maxrot,  int,     100,          "maximum rotation");
+	CLAP_CARG(kernel,  cstr,   "",            "also time kernel: auto, retune, generic, spec, native, total (or empty for none)");
+	CLAP_CARG(bdd,     int,     0,            "also time decision-diagram kernel (and for rtot, if set)?");
+	CLAP_CARG(rtot,    cstr,   "",            "also time (outer-)totalistic rule with id T<B>:<mask> or O<B>:<mask> (or empty for none)");
 	CLAP_CARG(seed,    ulong,   0,            "random seed (0 for unpredictable)");
 	puts("---------------------------------------------------------------------------------------\n");
 
@@ -69,10 +74,76 @@ int sim_bmark(int argc, char* argv[], int info)
 	// run CAs
 
 	ts = (double)clock()/(double)CLOCKS_PER_SEC;
-	for (size_t k=0; k<S; ++k) ca_run(I,n,ca[k],NULL,rsiz,rtab,0);
+	for (size_t k=0; k<S; ++k) ca_run(I,n,ca[k],rsiz,rtab,0);
 	te = (double)clock()/(double)CLOCKS_PER_SEC;
 	printf("CA run    time = %8.6f\n",te-ts);
 
+	// run CAs with selected (possibly autotuned) kernel
+
+	if (kernel[0] != '\0') {
+		const mw_filter_t kern = tune_kernel(rsiz,n,rtab,rt_totalistic(rsiz,rtab,NULL),kernel,1);
+		for (size_t k=0; k<S; ++k) mw_copy(n,ua[k],ca[k]);
+		ts = (double)clock()/(double)CLOCKS_PER_SEC;
+		for (size_t k=0; k<S; ++k) for (word_t* w=ua[k]+n; w<ua[k]+N; w+=n) kern(n,w,w-n,rsiz,rtab);
+		te = (double)clock()/(double)CLOCKS_PER_SEC;
+		printf("CA kernel run time = %8.6f (%s)\n",te-ts,mw_equal(T,uas,cas) ? "agrees" : "DISAGREES");
+	}
+
+	// run CAs with rule as decision diagram
+
+	if (bdd) {
+		rbdd_t* const rb = rb_from_table(rsiz,rtab); // no dead nodes
+		word_t* const wrk = mw_alloc(rb->nnodes);
+		printf("CA rule decision diagram: %zu nodes\n",rb_nnodes(rb));
+		for (size_t k=0; k<S; ++k) mw_copy(n,ua[k],ca[k]);
+		ts = (double)clock()/(double)CLOCKS_PER_SEC;
+		for (size_t k=0; k<S; ++k) for (word_t* w=ua[k]+n; w<ua[k]+N; w+=n) rb_filter(rb,n,w,w-n,wrk);
+		te = (double)clock()/(double)CLOCKS_PER_SEC;
+		printf("CA diagram run time = %8.6f (%s)\n",te-ts,mw_equal(T,uas,cas) ? "agrees" : "DISAGREES");
+		free(wrk);
+		rb_free(rb);
+	}
+
+	// run (outer-)totalistic CAs with adder-network kernel (and table kernel, if the table is not too big)
+
+	if (rtot[0] != '\0') {
+		int tsiz;
+		rtype_t ttype;
+		word_t tmask;
+		ASSERT(rt_tot_sread_id(rtot,&tsiz,&ttype,&tmask) == 1,"bad totalistic rule id '%s'",rtot);
+		const mw_filter_t tkern = rt_tot_kernel(ttype);
+		for (size_t k=0; k<S; ++k) mw_copy(n,ua[k],ca[k]);
+		ts = (double)clock()/(double)CLOCKS_PER_SEC;
+		for (size_t k=0; k<S; ++k) for (word_t* w=ua[k]+n; w<ua[k]+N; w+=n) tkern(n,w,w-n,tsiz,&tmask);
+		te = (double)clock()/(double)CLOCKS_PER_SEC;
+		printf("CA totalistic run time = %8.6f (",te-ts);
+		rt_tot_print_id(tsiz,ttype,tmask);
+		printf(")\n");
+		if (tsiz <= WFMAXB) {
+			word_t* const ttab = rt_alloc(tsiz);
+			rt_from_totalistic(tsiz,ttab,ttype,tmask);
+			const mw_filter_t filt = mw_filter_sel(tsiz);
+			for (size_t k=0; k<S; ++k) mw_copy(n,fa[k],ca[k]);
+			ts = (double)clock()/(double)CLOCKS_PER_SEC;
+			for (size_t k=0; k<S; ++k) for (word_t* w=fa[k]+n; w<fa[k]+N; w+=n) filt(n,w,w-n,tsiz,ttab);
+			te = (double)clock()/(double)CLOCKS_PER_SEC;
+			printf("CA totalistic table run time = %8.6f (%s)\n",te-ts,mw_equal(T,fas,uas) ? "agrees" : "DISAGREES");
+			free(ttab);
+		}
+		if (bdd) { // built from the mask: no table, so any size
+			rbdd_t* const rb = rb_from_totalistic(tsiz,ttype,tmask);
+			word_t* const wrk = mw_alloc(rb->nnodes);
+			printf("CA totalistic decision diagram: %zu nodes\n",rb_nnodes(rb));
+			for (size_t k=0; k<S; ++k) mw_copy(n,fa[k],ca[k]);
+			ts = (double)clock()/(double)CLOCKS_PER_SEC;
+			for (size_t k=0; k<S; ++k) for (word_t* w=fa[k]+n; w<fa[k]+N; w+=n) rb_filter(rb,n,w,w-n,wrk);
+			te = (double)clock()/(double)CLOCKS_PER_SEC;
+			printf("CA totalistic diagram run time = %8.6f (%s)\n",te-ts,mw_equal(T,fas,uas) ? "agrees" : "DISAGREES");
+			free(wrk);
+			rb_free(rb);
+		}
+	}
+
 	// rotate CAs
 
 	ts = (double)clock()/(double)CLOCKS_PER_SEC;
@@ -80,6 +151,14 @@ int sim_bmark(int argc, char* argv[], int info)
 	te = (double)clock()/(double)CLOCKS_PER_SEC;
 	printf("CA rotate time = %8.6f\n",te-ts);
 
+	// run and untwist CAs in place
+
+	for (size_t k=0; k<S; ++k) mw_copy(n,ua[k],ca[k]);
+	ts = (double)clock()/(double)CLOCKS_PER_SEC;
+	for (size_t k=0; k<S; ++k) ca_run(I,n,ua[k],rsiz,rtab,b[k]);
+	te = (double)clock()/(double)CLOCKS_PER_SEC;
+	printf("CA untwisted run time = %8.6f\n",te-ts);
+
 	// filter CAs
 
 	ts = (double)clock()/(double)CLOCKS_PER_SEC;
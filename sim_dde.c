@@ -0,0 +1,346 @@
+#include <pthread.h>
+#include <stdio.h>
+
+#include "clap.h"
+#include "rtab.h"
+
+// Exhaustive enumeration of all filters of a given size for a CA rule.
+//
+// Filters are represented by their packed table ("code"), bit r of the
+// code being the filter output for window r. Filters related by output
+// complement (and, if the CA rule has the corresponding symmetry, by
+// reflection and/or input complement) have identical filtered entropy and
+// DD, so only the orbit-minimal ("canonical") code of each orbit is
+// computed.
+
+typedef struct {
+	int             fsize;
+	int             m;
+	int             rrefl;  // CA rule is reflection-symmetric
+	int             rdual;  // CA rule is self-dual (commutes with complement)
+	size_t          ncodes;
+	size_t          chunk;
+	const word_t*   y;      // CA state at filtering time, per configuration
+	const word_t*   z;      // CA state after lag, per configuration
+	float*          Hf;     // normalised filtered entropy per code
+	float*          DD;     // normalised DD per code
+	uchar*          orb;    // orbit size per code (0 if not canonical)
+	uchar*          ind;    // exactly independent (DD = 0) per code
+	size_t          next;   // next code to hand out
+	pthread_mutex_t mutex;
+} ectx_t;
+
+typedef struct {
+	size_t  tnum;
+	size_t  ncomp; // number of canonical filters computed
+	ectx_t* ctx;
+} targ_t;
+
+static void* compfun(void* arg);
+
+static inline word_t code_refl(const int fsize, const word_t c)
+{
+	// reflect filter windows: bit r -> bit reverse(r)
+	const size_t F = POW2(fsize);
+	word_t d = WZERO;
+	for (size_t r=0; r<F; ++r) if (BITON(c,r)) SETBIT(d,wd_reverse(r)>>(WBITS-fsize));
+	return d;
+}
+
+static inline word_t code_dual(const int fsize, const word_t c)
+{
+	// complement filter windows: bit r -> bit ~r
+	const size_t F = POW2(fsize);
+	word_t d = WZERO;
+	for (size_t r=0; r<F; ++r) if (BITON(c,r)) SETBIT(d,(F-1)^r);
+	return d;
+}
+
+static inline int code_orbit(const int fsize, const word_t c, const int rrefl, const int rdual, word_t* const cmin)
+{
+	// orbit of code c under the DD-preserving symmetries; returns orbit size and orbit-minimal code
+	const word_t cmask = WONES>>(WBITS-(int)POW2(fsize));
+	word_t orb[8];
+	int norb = 0;
+	const word_t r0 = c;
+	const word_t r1 = rrefl ? code_refl(fsize,c) : c;
+	const word_t gen[4] = {r0,r1,rdual?code_dual(fsize,r0):r0,rdual?code_dual(fsize,r1):r1};
+	for (int g=0; g<4; ++g) {
+		for (int o=0; o<2; ++o) {
+			const word_t d = o ? gen[g]^cmask : gen[g]; // output complement
+			int k = 0;
+			while (k < norb && orb[k] != d) ++k;
+			if (k == norb) orb[norb++] = d;
+		}
+	}
+	*cmin = orb[0];
+	for (int k=1; k<norb; ++k) if (orb[k] < *cmin) *cmin = orb[k];
+	return norb;
+}
+
+static inline int qsort_word_comp(const void* const x1, const void* const x2)
+{
+	const word_t w1 = *(const word_t*)x1;
+	const word_t w2 = *(const word_t*)x2;
+	return (w1 > w2) - (w1 < w2);
+}
+
+int sim_dde(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name      type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(rtid,     cstr,   "",             "CA rule id (or empty for random)");
+	CLAP_CARG(rsize,    int,     5,             "CA rule size (random rule)");
+	CLAP_CARG(rlam,     double,  0.6,           "CA rule lambda (random rule)");
+	CLAP_CARG(rseed,    ulong,   0,             "CA rule random seed (or 0 for unpredictable)");
+	CLAP_CARG(fsize,    int,     4,             "filter rule size (at most 4)");
+	CLAP_CARG(m,        int,     12,            "sequence length for entropy/DD calculation");
+	CLAP_CARG(tiff,     int,     0,             "advance before DD calculation");
+	CLAP_CARG(tlag,     int,     1,             "lag for DD calculation");
+	CLAP_CARG(nthreads, size_t,  4,             "number of threads");
+	CLAP_CARG(chunk,    size_t,  256,           "number of filters per work chunk");
+	CLAP_CARG(odir,     cstr,   "/tmp",         "output file directory");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	ASSERT(fsize >= 1 && fsize <= 4,"filter size must be in range 1 - 4");
+	ASSERT(2*m <= WBITS,"sequence too long");
+
+	const size_t S = POW2(m);
+	const size_t ncodes = POW2(POW2(fsize));
+	const unsigned long minmem = 2*S*sizeof(word_t)+nthreads*S*sizeof(word_t)+ncodes*(2*sizeof(float)+2*sizeof(uchar));
+	TEST_RAM(minmem);
+	const double mmMb = (double)minmem/1000.0/1000.0;
+	printf("*** Dynamic memory > %.0fMb = %.2fGb\n\n",mmMb,mmMb/1000.0);
+
+	if (info) return EXIT_SUCCESS; // display some info and return
+
+	// CA rule: user-supplied or random
+
+	int rsiz = rsize;
+	word_t* rtab;
+	if (rtid[0] == '\0') {
+		mt_t rrng;
+		mt_seed(&rrng,rseed);
+		rtab = rt_alloc(rsiz);
+		rt_randomise(rsiz,rtab,rlam,&rrng);
+	}
+	else {
+		rtab = rt_sread_id(rtid,&rsiz);
+		ASSERT(rsiz != -1,"CA rule id is bad size");
+		ASSERT(rsiz != -2,"CA rule id contains non-hex characters");
+	}
+	ASSERT(rsiz <= m && fsize <= m,"sequence shorter than rule");
+
+	// CA rule symmetries determine which filter symmetries preserve DD
+
+	const size_t R = POW2(rsiz);
+	int rrefl = 1, rdual = 1;
+	for (size_t r=0; r<R; ++r) {
+		if (rt_symval(rsiz,rtab,1,r) != RTBIT(rtab,r)) rrefl = 0;
+		if (rt_symval(rsiz,rtab,2,r) != RTBIT(rtab,r)) rdual = 0;
+	}
+	printf("*** CA rule id = ");
+	rt_print_id(rsiz,rtab);
+	printf(" (size = %d, lambda = %6.4f) : reflection-symmetric = %s, self-dual = %s\n\n",rsiz,rt_lambda(rsiz,rtab),rrefl?"yes":"no",rdual?"yes":"no");
+
+	// CA states at filtering time and after lag are the same for every filter
+
+	word_t* const y = mw_alloc(S);
+	word_t* const z = mw_alloc(S);
+	for (word_t x=WZERO; x<S; ++x) {
+		word_t w = x;
+		for (int i=0; i<tiff; ++i) w = wd_filter(m,w,rsiz,rtab); // advance CA (may be zero)
+		y[x] = w;
+		for (int i=0; i<tlag; ++i) w = wd_filter(m,w,rsiz,rtab); // advance CA (at least 1)
+		z[x] = w;
+	}
+
+	// shared context
+
+	ectx_t ctx;
+	ctx.fsize  = fsize;
+	ctx.m      = m;
+	ctx.rrefl  = rrefl;
+	ctx.rdual  = rdual;
+	ctx.ncodes = ncodes;
+	ctx.chunk  = chunk;
+	ctx.y      = y;
+	ctx.z      = z;
+	ctx.Hf     = malloc(ncodes*sizeof(float));
+	TEST_ALLOC(ctx.Hf);
+	ctx.DD     = malloc(ncodes*sizeof(float));
+	TEST_ALLOC(ctx.DD);
+	ctx.orb    = calloc(ncodes,sizeof(uchar)); // zero-initialises
+	TEST_ALLOC(ctx.orb);
+	ctx.ind    = calloc(ncodes,sizeof(uchar)); // zero-initialises
+	TEST_ALLOC(ctx.ind);
+	ctx.next   = 0;
+	pthread_mutex_init(&ctx.mutex,NULL);
+
+	// create threads
+
+	printf("*** Creating %zu threads for %zu filters (chunk size = %zu)\n\n",nthreads,ncodes,chunk);
+
+	targ_t targs[nthreads];
+	pthread_t threads[nthreads]; // NOTE: joinable by default (otherwise use pthread_attr_setdetachstate())
+	for (size_t i=0; i<nthreads; ++i) {
+		targs[i].tnum = i;
+		targs[i].ctx  = &ctx;
+		const int tres = pthread_create(&threads[i],NULL,compfun,(void*)&targs[i]);
+		PASSERT(tres == 0,"unable to create thread %zu",i+1)
+	}
+
+	// wait for computational threads to complete
+
+	for (size_t i=0; i<nthreads; ++i) {
+		const int tres = pthread_join(threads[i],NULL);
+		PASSERT(tres == 0,"unable to join thread %zu",i+1);
+	}
+	pthread_mutex_destroy(&ctx.mutex);
+
+	// summary
+
+	size_t ncanon = 0, nind = 0, nindc = 0;
+	for (size_t c=0; c<ncodes; ++c) {
+		if (ctx.orb[c] == 0) continue;
+		++ncanon;
+		if (ctx.ind[c]) {++nindc; nind += ctx.orb[c];}
+	}
+	printf("\n*** %zu canonical filters computed (of %zu); %zu independent (DD = 0) filters in %zu orbits",ncanon,ncodes,nind,nindc);
+	if (nindc > 0) {
+		printf(":\n");
+		word_t ftab[1]; // fsize <= 4, so filter table is a single (packed) word
+		for (size_t c=0; c<ncodes; ++c) {
+			if (ctx.orb[c] == 0 || !ctx.ind[c]) continue;
+			rt_from_mwords(fsize,ftab,1,&c);
+			printf("\tfilter id = ");
+			rt_print_id(fsize,ftab);
+			printf(" : orbit size = %d, filter entropy = %8.6f\n",ctx.orb[c],(double)ctx.Hf[c]);
+		}
+	}
+	else {
+		putchar('\n');
+	}
+
+	// stream canonical results to binary file
+	//
+	// Format (native byte order): magic "CADDE001", then int32 rsize, fsize, m, tiff, tlag,
+	// then the packed CA rule table (rt_nwords(rsize) 64-bit words), uint64 record count,
+	// then per canonical filter: uint32 packed filter table, uint8 orbit size, uint8
+	// independence flag, float normalised filtered entropy, float normalised DD.
+
+	const size_t ofnlen = strlen(odir)+12;
+	char ofname[ofnlen];
+	snprintf(ofname,ofnlen,"%s/cadde.bin",odir);
+	printf("\n*** Writing results to \"%s\"... ",ofname);
+	fflush(stdout);
+	FILE* const dfs = fopen(ofname,"wb");
+	PASSERT(dfs != NULL,"Failed to open output file \"%s\"\n",ofname);
+	const int32_t hdr[5] = {rsiz,fsize,m,tiff,tlag};
+	const size_t nrw = rt_nwords(rsiz);
+	word_t rwords[nrw];
+	rt_to_mwords(rsiz,rtab,nrw,rwords);
+	const uint64_t nrec = ncanon;
+	int ok = fwrite("CADDE001",1,8,dfs) == 8;
+	ok = ok && fwrite(hdr,sizeof(int32_t),5,dfs) == 5;
+	ok = ok && fwrite(rwords,sizeof(word_t),nrw,dfs) == nrw;
+	ok = ok && fwrite(&nrec,sizeof(uint64_t),1,dfs) == 1;
+	for (size_t c=0; ok && c<ncodes; ++c) {
+		if (ctx.orb[c] == 0) continue;
+		const uint32_t code = (uint32_t)c;
+		ok = ok && fwrite(&code,sizeof(uint32_t),1,dfs) == 1;
+		ok = ok && fwrite(&ctx.orb[c],sizeof(uchar),1,dfs) == 1;
+		ok = ok && fwrite(&ctx.ind[c],sizeof(uchar),1,dfs) == 1;
+		ok = ok && fwrite(&ctx.Hf[c],sizeof(float),1,dfs) == 1;
+		ok = ok && fwrite(&ctx.DD[c],sizeof(float),1,dfs) == 1;
+	}
+	PASSERT(ok,"Failed to write output file \"%s\"\n",ofname);
+	if (fclose(dfs) == -1) PEEXIT("Failed to close output file \"%s\"\n",ofname);
+	puts("done");
+
+	// clean up
+
+	free(ctx.ind);
+	free(ctx.orb);
+	free(ctx.DD);
+	free(ctx.Hf);
+	free(z);
+	free(y);
+	free(rtab);
+
+	return EXIT_SUCCESS;
+}
+
+void* compfun(void* arg)
+{
+	const double wts = get_wall_time();
+	const double cts = get_thread_cpu_time ();
+
+	const pthread_t tpid = pthread_self();
+	targ_t* const targ   = (targ_t*)arg;
+	ectx_t* const ctx    = targ->ctx;
+	const size_t tnum    = targ->tnum;
+	const int    fsize   = ctx->fsize;
+	const int    m       = ctx->m;
+	const size_t S       = POW2(m);
+	const double fac     = 1.0/(double)S;
+	const double oom     = 1.0/(double)m;
+
+	printf("thread %2zu (%zu) : STARTED\n",tnum+1,tpid);
+	fflush(stdout);
+
+	word_t* const key = mw_alloc(S); // (filtered state, filtered successor) pairs
+	word_t ftab[1]; // fsize <= 4, so filter table is a single (packed) word
+	targ->ncomp = 0;
+
+	while (1) {
+
+		// grab next chunk of filter codes
+
+		pthread_mutex_lock(&ctx->mutex);
+		const size_t cbeg = ctx->next;
+		const size_t cend = cbeg+ctx->chunk < ctx->ncodes ? cbeg+ctx->chunk : ctx->ncodes;
+		ctx->next = cend;
+		pthread_mutex_unlock(&ctx->mutex);
+		if (cbeg >= cend) break; // all done
+
+		for (size_t c=cbeg; c<cend; ++c) {
+			word_t cmin;
+			const int norb = code_orbit(fsize,c,ctx->rrefl,ctx->rdual,&cmin);
+			if (cmin != c) continue; // not canonical
+
+			// sort (u,v) pairs with u major: filtered entropy from u-runs, joint entropy from (u,v)-runs
+
+			rt_from_mwords(fsize,ftab,1,&c);
+			for (size_t x=0; x<S; ++x) key[x] = (wd_filter(m,ctx->y[x],fsize,ftab)<<m)|wd_filter(m,ctx->z[x],fsize,ftab);
+			qsort(key,S,sizeof(word_t),qsort_word_comp);
+			double A1 = 0.0, A2 = 0.0;
+			size_t n1 = 1, n2 = 1;
+			int ind = 1;
+			for (size_t x=1; x<=S; ++x) {
+				const int newu  = x == S || (key[x]>>m) != (key[x-1]>>m);
+				const int newuv = x == S || key[x] != key[x-1];
+				if (newuv) {A2 += xlog2x((double)n2); n2 = 1;} else ++n2;
+				if (newu)  {A1 += xlog2x((double)n1); n1 = 1;} else {++n1; if (newuv) ind = 0;} // same u, different v
+			}
+			ctx->Hf[c]  = (float)(oom*((double)m-fac*A1));
+			ctx->DD[c]  = ind ? 0.0f : (float)(oom*fac*(A1-A2));
+			ctx->ind[c] = (uchar)ind;
+			ctx->orb[c] = (uchar)norb;
+			++targ->ncomp;
+		}
+	}
+
+	free(key);
+
+	const double cte = get_thread_cpu_time() - cts;
+	const double wte = get_wall_time() - wts;
+
+	printf("thread %2zu : FINISHED : %zu filters (cpu time = %.4f, wall time = %.4f)\n",tnum+1,targ->ncomp,cte,wte);
+	fflush(stdout);
+
+	pthread_exit(NULL);
+}
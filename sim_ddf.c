@@ -1,28 +1,36 @@
-#include <pthread.h>
-
 #include "clap.h"
 #include "rtab.h"
+#include "pool.h"
 
-typedef struct {
+typedef struct tfarg {
 	rtl_t*  rule;
 	rtl_t*  filt;
+	const struct tfarg* orig; // equivalent rule/filter pair computed elsewhere (or NULL)
 	double* Hr;
 	double* Hf;
 	double* DD;
+	int     mHr; // sequence lengths reached
+	int     mHf;
+	int     mDD;
 } tfarg_t;
 
 typedef struct {
-	int tnum;
-	int nfint;
+	size_t npairs;
 	int emmax;
 	int eiff;
 	int tmmax;
 	int tiff;
 	int tlag;
-	tfarg_t* tfargs;
+	double ctol;
+	double tbud;
+	size_t S;         // per-thread work buffer sizes
+	size_t S2;
+	uint64_t* bin;    // per-thread work buffers
+	uint64_t* bin2;
+	tfarg_t* tfargs;  // all rule/filter pairs
 } targ_t;
 
-static void* compfun(void* arg);
+static void comptask(void* const arg, const size_t k, const size_t tnum);
 
 int sim_ddf(int argc, char* argv[], int info)
 {
@@ -37,12 +45,18 @@ int sim_ddf(int argc, char* argv[], int info)
 	CLAP_CARG(tmmax,    int,     14,           "maximum sequence length for DD calculation");
 	CLAP_CARG(tiff,     int,     0,            "advance before DD calculation");
 	CLAP_CARG(tlag,     int,     1,            "lag for DD calculation");
+	CLAP_CARG(ctol,     double,  0.0,          "convergence tolerance for entropy/DD sequence lengths (or 0 for none)");
+	CLAP_CARG(tbud,     double,  0.0,          "time budget (secs) per entropy/DD curve (or 0 for none)");
 	CLAP_CARG(nthreads, int,     4,            "number of threads");
+	CLAP_CARG(chunk,    size_t,  1,            "rules/filters claimed by a thread at a time");
 	CLAP_CARG(odir,     cstr,   "/tmp",        "output file directory");
 	puts("---------------------------------------------------------------------------------------\n");
 
 	if (info) return EXIT_SUCCESS; // display switches and return
 
+	ASSERT(nthreads > 0,"need at least one thread");
+	ASSERT(chunk > 0,"chunk size must be positive");
+
 	// Read in rule/filter rtids
 
 	ASSERT(irtfile[0] != '\0',"Must supply an input rtid file");
@@ -51,6 +65,7 @@ int sim_ddf(int argc, char* argv[], int info)
 	PASSERT(irtfs != NULL,"failed to open input rtids file");
 	rtl_t* rule = rtl_fread(irtfs);
 	ASSERT(rule != NULL,"No valid rtids found in input file!");
+	for (const rtl_t* r = rule; r != NULL; r = r->next) ASSERT(r->tab != NULL,"CA rule too big for a table (size %d): DD needs the table",r->size);
 	const int fres = fclose(irtfs);
 	PASSERT(fres == 0,"failed to close input rtids file");
 
@@ -62,74 +77,98 @@ int sim_ddf(int argc, char* argv[], int info)
 	printf("filters = %d :",nfilts);
 	for (int k=0;k<nrules;++k) printf(" %d",nfperr[k]);
 	putchar('\n');
-	const int nfpert  = nfilts/nthreads + (nfilts%nthreads ? 1 : 0);
-	const int nfpertl = nfilts-nfpert*(nthreads-1);
-	printf("threads = %d\nfilters per thread = %d (last = %d)\n\n",nthreads,nfpert,nfpertl);
+	printf("threads = %d\n\n",nthreads);
 	fflush(stdout);
-	ASSERT(nfpertl > 0,"Too many threads!?");
 	free(nfperr);
 
-	// thread-independent parameters
-
-	targ_t targs[nthreads];
-	for (int tnum=0; tnum<nthreads; ++tnum) {
-		targs[tnum].emmax  = emmax;
-		targs[tnum].eiff   = eiff;
-		targs[tnum].tmmax  = tmmax;
-		targs[tnum].tiff   = tiff;
-		targs[tnum].tlag   = tlag;
-		targs[tnum].tfargs = malloc((size_t)nfpert*sizeof(tfarg_t));
-		TEST_ALLOC(targs[tnum].tfargs);
-	}
-
-	// loop through rules/filters, setting up thread-dependent parameters
+	// thread-independent parameters and per-thread work buffers
+
+	const size_t nt = (size_t)nthreads;
+	const size_t np = (size_t)nfilts;
+	targ_t targ;
+	targ.npairs = np;
+	targ.emmax  = emmax;
+	targ.eiff   = eiff;
+	targ.tmmax  = tmmax;
+	targ.tiff   = tiff;
+	targ.tlag   = tlag;
+	targ.ctol   = ctol;
+	targ.tbud   = tbud;
+	targ.S      = POW2(emmax);
+	targ.S2     = POW2(2*tmmax);
+	TEST_RAM(nt*(targ.S+targ.S2)*sizeof(uint64_t));
+	targ.bin    = malloc(nt*targ.S*sizeof(uint64_t));
+	TEST_ALLOC(targ.bin);
+	targ.bin2   = malloc(nt*targ.S2*sizeof(uint64_t));
+	TEST_ALLOC(targ.bin2);
+	targ.tfargs = malloc(np*sizeof(tfarg_t));
+	TEST_ALLOC(targ.tfargs);
+
+	// loop through rules/filters, setting up pair-dependent parameters
 
 	const int hlen = (emmax > tmmax ? emmax : tmmax)+1;
-	int tnum  = 0;
-	int nfint = 0;
+	size_t k = 0;
 	for (rtl_t* r = rtl_init(rule); r != NULL; r = r->next) {
-		for (rtl_t* f = r->filt; f != NULL; f = f->next) {
-			targ_t*  const targ  = &targs[tnum];
-			tfarg_t* const tfarg = &targ->tfargs[nfint];
+		for (rtl_t* f = r->filt; f != NULL; f = f->next, ++k) {
+			tfarg_t* const tfarg = &targ.tfargs[k];
 			tfarg->rule = r;
 			tfarg->filt = f;
 			tfarg->Hr = malloc((size_t)hlen*sizeof(double));
 			tfarg->Hf = malloc((size_t)hlen*sizeof(double));
 			tfarg->DD = malloc((size_t)hlen*sizeof(double));
-			if (++nfint == nfpert) {
-				targ->tnum  = tnum;
-				targ->nfint = nfint;
-				++tnum;
-				nfint = 0;
-			}
 		}
 	}
-	if (nfint > 0) {
-		targ_t* const targ = &targs[tnum];
-		targ->tnum  = tnum;
-		targ->nfint = nfint;
-	}
 
-	// set up computational threads as joinable
-
-	pthread_t threads[nthreads];
-	pthread_attr_t attr;
-	pthread_attr_init(&attr);
-	pthread_attr_setdetachstate(&attr,PTHREAD_CREATE_JOINABLE);
-
-	// create threads
-
-	for (int tnum=0; tnum<nthreads; ++tnum) {
-		const int tres = pthread_create(&threads[tnum],&attr,compfun,(void*)&targs[tnum]);
-		PASSERT(tres == 0,"unable to create thread %d",tnum+1)
+	// find rule/filter pairs equivalent under reflection/complement symmetries: these are not recomputed
+
+	{
+		const size_t n = np;
+		int*            const rsizs = malloc(n*sizeof(int));
+		TEST_ALLOC(rsizs);
+		int*            const fsizs = malloc(n*sizeof(int));
+		TEST_ALLOC(fsizs);
+		const word_t**  const rtabs = malloc(n*sizeof(word_t*));
+		TEST_ALLOC(rtabs);
+		const word_t**  const ftabs = malloc(n*sizeof(word_t*));
+		TEST_ALLOC(ftabs);
+		size_t*         const dup   = malloc(n*sizeof(size_t));
+		TEST_ALLOC(dup);
+		for (k=0; k<n; ++k) {
+			const tfarg_t* const tfarg = &targ.tfargs[k];
+			rsizs[k] = tfarg->rule->size;
+			fsizs[k] = tfarg->filt->size;
+			rtabs[k] = tfarg->rule->tab;
+			ftabs[k] = tfarg->filt->tab;
+		}
+		const size_t ndups = rt_pair_dups(n,rsizs,rtabs,fsizs,ftabs,dup);
+		for (k=0; k<n; ++k) targ.tfargs[k].orig = dup[k] == k ? NULL : &targ.tfargs[dup[k]];
+		printf("%zu of %zu rule/filter pairs equivalent to an earlier pair (results reused)\n\n",ndups,n);
+		free(dup);
+		free(ftabs);
+		free(rtabs);
+		free(fsizs);
+		free(rsizs);
 	}
 
-	// free attribute and wait for computational threads to complete
+	// compute: threads claim rule/filter pairs from a shared pool as they finish
 
-	pthread_attr_destroy(&attr);
-	for (int tnum=0; tnum<nthreads; ++tnum) {
-		const int tres = pthread_join(threads[tnum],NULL);
-		PASSERT(tres == 0,"unable to join thread %d",tnum+1);
+	pool_stat_t stat[nt];
+	pool_run(np,chunk,nt,comptask,&targ,stat);
+	putchar('\n');
+	pool_print_stat(nt,stat);
+
+	// copy results for equivalent rule/filter pairs
+
+	for (k=0; k<np; ++k) {
+		tfarg_t* const tfarg = &targ.tfargs[k];
+		const tfarg_t* const orig = tfarg->orig;
+		if (orig == NULL) continue;
+		memcpy(tfarg->Hr,orig->Hr,(size_t)hlen*sizeof(double));
+		memcpy(tfarg->Hf,orig->Hf,(size_t)hlen*sizeof(double));
+		memcpy(tfarg->DD,orig->DD,(size_t)hlen*sizeof(double));
+		tfarg->mHr = orig->mHr;
+		tfarg->mHf = orig->mHf;
+		tfarg->mDD = orig->mDD;
 	}
 
 	// write out results
@@ -141,103 +180,81 @@ int sim_ddf(int argc, char* argv[], int info)
 	fflush(stdout);
 	FILE* const dfs = fopen(ofname,"w");
 	PASSERT(dfs != NULL,"Failed to open output file \"%s\"\n",ofname);
-	for (int tnum=0; tnum<nthreads; ++tnum) {
-		targ_t* const targ = &targs[tnum];
-		for (int i=0; i<targ->nfint; ++i) {
-			tfarg_t* const tfarg = &targ->tfargs[i];
-			fprintf(dfs,"# rule id = ");
-			rt_fprint_id(tfarg->rule->size,tfarg->rule->tab,dfs);
-			fprintf(dfs,", filter id = ");
-			rt_fprint_id(tfarg->filt->size,tfarg->filt->tab,dfs);
-			fputc('\n',dfs);
-			for (int m=0; m<hlen; ++m) fprintf(dfs,"%4d\t%8.6f\t%8.6f\t%8.6f\n",m,tfarg->Hr[m],tfarg->Hf[m],tfarg->DD[m]);
-			fputs("\n",dfs);
-		}
+	for (k=0; k<np; ++k) {
+		const tfarg_t* const tfarg = &targ.tfargs[k];
+		fprintf(dfs,"# rule id = ");
+		rt_fprint_id(tfarg->rule->size,tfarg->rule->tab,dfs);
+		fprintf(dfs,", filter id = ");
+		rt_fprint_id(tfarg->filt->size,tfarg->filt->tab,dfs);
+		fprintf(dfs,", lengths reached = %d %d %d",tfarg->mHr,tfarg->mHf,tfarg->mDD);
+		fputs(tfarg->orig != NULL ? " (equivalent pair)\n" : "\n",dfs);
+		for (int m=0; m<hlen; ++m) fprintf(dfs,"%4d\t%8.6f\t%8.6f\t%8.6f\n",m,tfarg->Hr[m],tfarg->Hf[m],tfarg->DD[m]);
+		fputs("\n",dfs);
 	}
 	if (fclose(dfs) == -1) PEEXIT("Failed to close output file \"%s\"\n",ofname);
 	puts("done");
 
 	// clean up
 
-	for (int tnum=0; tnum<nthreads; ++tnum) {
-		targ_t* const targ = &targs[tnum];
-		for (int i=0; i<targ->nfint; ++i) {
-			tfarg_t* const tfarg = &targ->tfargs[i];
-			free(tfarg->DD);
-			free(tfarg->Hf);
-			free(tfarg->Hr);
-		}
-		free(targ->tfargs);
+	for (k=0; k<np; ++k) {
+		tfarg_t* const tfarg = &targ.tfargs[k];
+		free(tfarg->DD);
+		free(tfarg->Hf);
+		free(tfarg->Hr);
 	}
+	free(targ.tfargs);
+	free(targ.bin2);
+	free(targ.bin);
 
 	rtl_free(rule);
 
 	return EXIT_SUCCESS;
 }
 
-void* compfun(void* arg)
+void comptask(void* const arg, const size_t k, const size_t tnum)
 {
-	const pthread_t tpid = pthread_self();
-	const targ_t* const targs = (targ_t*)arg;
-	const int tnum  = targs->tnum;
-	const int nfint = targs->nfint;
+	const targ_t* const targ = (targ_t*)arg;
+
+	const int emmax = targ->emmax;
+	const int eiff  = targ->eiff;
+	const int tmmax = targ->tmmax;
+	const int tiff  = targ->tiff;
+	const int tlag  = targ->tlag;
+	const double ctol = targ->ctol;
+	const double tbud = targ->tbud;
+	const int hlen  = (emmax > tmmax ? emmax : tmmax)+1;
 
-	printf("thread %2d (%zu) : %d filters : STARTED\n",tnum+1,tpid,nfint);
-	fflush(stdout);
+	uint64_t* const bin  = targ->bin +tnum*targ->S;
+	uint64_t* const bin2 = targ->bin2+tnum*targ->S2;
 
-	const int emmax = targs->emmax;
-	const int eiff  = targs->eiff;
-	const int tmmax = targs->tmmax;
-	const int tiff  = targs->tiff;
-	const int tlag  = targs->tlag;
-	const int hlen  = (emmax > tmmax ? emmax : tmmax)+1;
+	tfarg_t* const tfarg = &targ->tfargs[k];
 
-	const size_t S = POW2(emmax);
-	TEST_RAM(S*sizeof(uint64_t));
-	uint64_t* const bin = malloc(S*sizeof(uint64_t));
-	TEST_ALLOC(bin);
-
-	const size_t S2 = POW2(2*tmmax);
-	TEST_RAM(S2*sizeof(uint64_t));
-	uint64_t* const bin2 = malloc(S2*sizeof(uint64_t));
-	TEST_ALLOC(bin2);
-
-	const tfarg_t* const tfargs = targs->tfargs;
-
-	for (int i=0; i<nfint; ++i) {
-
-		const int           rsize = tfargs[i].rule->size;
-		const int           fsize = tfargs[i].filt->size;
-		const word_t* const rtab  = tfargs[i].rule->tab;
-		const word_t* const ftab  = tfargs[i].filt->tab;
-		double*       const Hr    = tfargs[i].Hr;
-		double*       const Hf    = tfargs[i].Hf;
-		double*       const DD    = tfargs[i].DD;
-
-		const int rfsize = rsize > fsize ? rsize : fsize;
-
-		for (int m=0; m<hlen; ++m) Hr[m] = NAN;
-		for (int m=0; m<hlen; ++m) Hf[m] = NAN;
-		for (int m=0; m<hlen; ++m) DD[m] = NAN;
-		for (int m=rsize;  m<=emmax; ++m) Hr[m] = rt_entro(rsize,rtab,m,eiff,bin)/(double)m;
-		for (int m=fsize;  m<=emmax; ++m) Hf[m] = rt_entro(fsize,ftab,m,eiff,bin)/(double)m;
-		for (int m=rfsize; m<=tmmax; ++m) DD[m] = rt_dd   (rsize,rtab,fsize,ftab,m,tiff,tlag,bin,bin2)/(double)m;
-
-		flockfile(stdout); // prevent another thread butting in!
-		printf("\tthread %2d : filter %2d of %2d : rule id = ",tnum+1,i+1,nfint);
-		rt_print_id(rsize,rtab);
-		printf(", filter id = ");
-		rt_print_id(fsize,ftab);
-		printf(" : rule entropy ≈ %8.6f, filter entropy ≈ %8.6f, DD ≈ %8.6f\n",Hr[emmax],Hf[emmax],DD[tmmax]);
-		fflush(stdout);
-		funlockfile(stdout);
-	}
+	const int           rsize = tfarg->rule->size;
+	const int           fsize = tfarg->filt->size;
+	const word_t* const rtab  = tfarg->rule->tab;
+	const word_t* const ftab  = tfarg->filt->tab;
+	double*       const Hr    = tfarg->Hr;
+	double*       const Hf    = tfarg->Hf;
+	double*       const DD    = tfarg->DD;
 
-	printf("thread %2d : FINISHED\n",tnum+1);
-	fflush(stdout);
+	const int rfsize = rsize > fsize ? rsize : fsize;
+
+	for (int m=0; m<hlen; ++m) Hr[m] = NAN;
+	for (int m=0; m<hlen; ++m) Hf[m] = NAN;
+	for (int m=0; m<hlen; ++m) DD[m] = NAN;
 
-	free(bin2);
-	free(bin);
+	if (tfarg->orig != NULL) return; // equivalent to another pair - results copied later
 
-	pthread_exit(NULL);
+	const int mHr = tfarg->mHr = rt_entro_curve(rsize,rtab,rsize,emmax,eiff,1,ctol,tbud,bin,Hr);
+	const int mHf = tfarg->mHf = rt_entro_curve(fsize,ftab,fsize,emmax,eiff,1,ctol,tbud,bin,Hf);
+	const int mDD = tfarg->mDD = rt_dd_curve(rsize,rtab,fsize,ftab,rfsize,tmmax,tiff,tlag,1,ctol,tbud,bin,bin2,DD);
+
+	flockfile(stdout); // prevent another thread butting in!
+	printf("\tthread %2zu : filter %3zu of %3zu : rule id = ",tnum+1,k+1,targ->npairs);
+	rt_print_id(rsize,rtab);
+	printf(", filter id = ");
+	rt_print_id(fsize,ftab);
+	printf(" : rule entropy ≈ %8.6f (%d), filter entropy ≈ %8.6f (%d), DD ≈ %8.6f (%d)\n",Hr[mHr],mHr,Hf[mHf],mHf,DD[mDD],mDD);
+	fflush(stdout);
+	funlockfile(stdout);
 }
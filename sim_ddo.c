@@ -0,0 +1,240 @@
+#include <pthread.h>
+#include <stdio.h>
+
+#include "clap.h"
+#include "rtab.h"
+#include "ddinc.h"
+
+typedef struct {
+	size_t        tnum;
+	int           rsize;
+	const word_t* rtab;
+	int           fsize;
+	double        flam;
+	ulong         fseed;
+	int           m;
+	int           tiff;
+	int           tlag;
+	double        hmin;
+	double        hmax;
+	size_t        niters;
+	double        temp;
+	word_t*       ftab; // best filter found
+	double        DD;   // best (normalised) DD
+	double        Hf;   // normalised filter entropy for best filter
+} targ_t;
+
+static void* compfun(void* arg);
+
+int sim_ddo(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name      type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(rtid,     cstr,   "",             "CA rule id (or empty for random)");
+	CLAP_CARG(rsize,    int,     5,             "CA rule size (random rule)");
+	CLAP_CARG(rlam,     double,  0.6,           "CA rule lambda (random rule)");
+	CLAP_CARG(rseed,    ulong,   0,             "CA rule random seed (or 0 for unpredictable)");
+	CLAP_CARG(fsize,    int,     4,             "filter rule size");
+	CLAP_CARG(flam,     double,  0.5,           "initial filter rule lambda");
+	CLAP_CARG(fseed,    ulong,   0,             "filter rule random seed (0 for unpredictable)");
+	CLAP_CARG(m,        int,     10,            "sequence length for DD calculation");
+	CLAP_CARG(tiff,     int,     0,             "advance before DD calculation");
+	CLAP_CARG(tlag,     int,     1,             "lag for DD calculation");
+	CLAP_CARG(hmin,     double,  0.1,           "minimum normalised filter entropy");
+	CLAP_CARG(hmax,     double,  0.9,           "maximum normalised filter entropy");
+	CLAP_CARG(niters,   size_t,  100000,        "number of annealing iterations (filter flips) per thread");
+	CLAP_CARG(temp,     double,  0.01,          "initial annealing temperature (cools linearly to zero)");
+	CLAP_CARG(nthreads, size_t,  4,             "number of threads (independent annealing runs)");
+	CLAP_CARG(odir,     cstr,   "/tmp",         "output file directory");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	const size_t S = POW2(m);
+	const unsigned long minmem = nthreads*(S*S*sizeof(uint64_t)+S*(4*sizeof(word_t)+sizeof(uint64_t)+sizeof(double)));
+	TEST_RAM(minmem);
+	const double mmMb = (double)minmem/1000.0/1000.0;
+	printf("*** Dynamic memory > %.0fMb = %.2fGb\n\n",mmMb,mmMb/1000.0);
+
+	if (info) return EXIT_SUCCESS; // display some info and return
+
+	// CA rule: user-supplied or random
+
+	int rsiz = rsize;
+	word_t* rtab;
+	if (rtid[0] == '\0') {
+		mt_t rrng;
+		mt_seed(&rrng,rseed);
+		rtab = rt_alloc(rsiz);
+		rt_randomise(rsiz,rtab,rlam,&rrng);
+	}
+	else {
+		rtab = rt_sread_id(rtid,&rsiz);
+		ASSERT(rsiz != -1,"CA rule id is bad size");
+		ASSERT(rsiz != -2,"CA rule id contains non-hex characters");
+	}
+	printf("*** CA rule id = ");
+	rt_print_id(rsiz,rtab);
+	printf(" (size = %d, lambda = %6.4f)\n\n",rsiz,rt_lambda(rsiz,rtab));
+
+	// set up thread arguments
+
+	targ_t targs[nthreads];
+	for (size_t i=0; i<nthreads; ++i) {
+		targ_t* const targ = &targs[i];
+		targ->tnum   = i;
+		targ->rsize  = rsiz;
+		targ->rtab   = rtab;
+		targ->fsize  = fsize;
+		targ->flam   = flam;
+		targ->fseed  = fseed == 0 ? 0 : fseed+i; // independent filter streams per thread
+		targ->m      = m;
+		targ->tiff   = tiff;
+		targ->tlag   = tlag;
+		targ->hmin   = hmin;
+		targ->hmax   = hmax;
+		targ->niters = niters;
+		targ->temp   = temp;
+		targ->ftab   = rt_alloc(fsize);
+	}
+
+	// create threads
+
+	printf("*** Creating %zu threads with %zu iterations per thread\n\n",nthreads,niters);
+
+	pthread_t threads[nthreads]; // NOTE: joinable by default (otherwise use pthread_attr_setdetachstate())
+	for (size_t i=0; i<nthreads; ++i) {
+		const int tres = pthread_create(&threads[i],NULL,compfun,(void*)&targs[i]);
+		PASSERT(tres == 0,"unable to create thread %zu",i+1)
+	}
+
+	// wait for computational threads to complete
+
+	for (size_t i=0; i<nthreads; ++i) {
+		const int tres = pthread_join(threads[i],NULL);
+		PASSERT(tres == 0,"unable to join thread %zu",i+1);
+	}
+
+	// write out results as an rtids file (best filter per thread)
+
+	const size_t ofnlen = strlen(odir)+11;
+	char ofname[ofnlen];
+	snprintf(ofname,ofnlen,"%s/caddo.rt",odir);
+	printf("\n*** Writing results to \"%s\"... ",ofname);
+	fflush(stdout);
+	FILE* const dfs = fopen(ofname,"w");
+	PASSERT(dfs != NULL,"Failed to open output file \"%s\"\n",ofname);
+	fprintf(dfs,"# filter  size    = %2d\n"
+	            "# dynind  seqlen  = %2d (advance = %d, lag = %d)\n"
+	            "# entropy range   = %g - %g\n\n"
+	            ,fsize,m,tiff,tlag,hmin,hmax);
+	for (size_t i=0; i<nthreads; ++i) {
+		const targ_t* const targ = &targs[i];
+		fprintf(dfs,"# thread %2zu : filter entropy = %8.6f, DD = %8.6f\n",i+1,targ->Hf,targ->DD);
+		if (isnan(targ->DD)) continue; // no feasible filter found
+		rt_fprint_id(rsiz,rtab,dfs);
+		fputc(' ',dfs);
+		rt_fprint_id(fsize,targ->ftab,dfs);
+		fputc('\n',dfs);
+	}
+	if (fclose(dfs) == -1) PEEXIT("Failed to close output file \"%s\"\n",ofname);
+	puts("done");
+
+	// clean up
+
+	for (size_t i=0; i<nthreads; ++i) free(targs[i].ftab);
+	free(rtab);
+
+	return EXIT_SUCCESS;
+}
+
+static inline double objfun(const ddi_t* const ddi, const double hmin, const double hmax, double* const dd, double* const h)
+{
+	// normalised DD, penalised by distance of normalised filter entropy from feasible range
+	const double fac = 1.0/(double)ddi->m;
+	*dd = fac*ddi_dd(ddi);
+	*h  = fac*ddi_entro(ddi);
+	return *dd + (*h < hmin ? hmin-*h : 0.0) + (*h > hmax ? *h-hmax : 0.0);
+}
+
+void* compfun(void* arg)
+{
+	const double wts = get_wall_time();
+	const double cts = get_thread_cpu_time ();
+
+	const pthread_t tpid = pthread_self();
+	targ_t* const targ   = (targ_t*)arg;
+	const size_t tnum    = targ->tnum;
+	const size_t niters  = targ->niters;
+	const int    fsize   = targ->fsize;
+	const double hmin    = targ->hmin;
+	const double hmax    = targ->hmax;
+	const size_t F       = POW2(fsize);
+
+	printf("thread %2zu (%zu) : %zu iterations : STARTED\n",tnum+1,tpid,niters);
+	fflush(stdout);
+
+	mt_t frng;
+	mt_seed(&frng,targ->fseed);
+
+	// random initial filter
+
+	word_t* const ftab = rt_alloc(fsize);
+	rt_randomise(fsize,ftab,targ->flam,&frng);
+	ddi_t* const ddi = ddi_alloc(targ->rsize,targ->rtab,fsize,ftab,targ->m,targ->tiff,targ->tlag);
+	free(ftab);
+
+	// simulated annealing over single-entry filter flips
+
+	double dd, h;
+	double obj = objfun(ddi,hmin,hmax,&dd,&h);
+	targ->DD = NAN;
+	targ->Hf = NAN;
+	size_t naccept = 0;
+	for (size_t k=0; k<niters; ++k) {
+		if (h >= hmin && h <= hmax && !(dd >= targ->DD)) { // new best feasible filter (note: NaN comparison false)
+			targ->DD = dd;
+			targ->Hf = h;
+			rt_copy(fsize,targ->ftab,ddi->ftab);
+		}
+		const double T = targ->temp*(1.0-(double)k/(double)niters); // linear cooling
+		const size_t r = RANDI(size_t,F,&frng);
+		ddi_flip_filt(ddi,r);
+		double ddnew, hnew;
+		const double objnew = objfun(ddi,hmin,hmax,&ddnew,&hnew);
+		const double dobj = objnew-obj;
+		if (dobj <= 0.0 || (T > 0.0 && mt_rand(&frng) < exp(-dobj/T))) { // accept
+			obj = objnew;
+			dd  = ddnew;
+			h   = hnew;
+			++naccept;
+		}
+		else { // reject: flip back
+			ddi_flip_filt(ddi,r);
+		}
+	}
+	if (h >= hmin && h <= hmax && !(dd >= targ->DD)) {
+		targ->DD = dd;
+		targ->Hf = h;
+		rt_copy(fsize,targ->ftab,ddi->ftab);
+	}
+
+	ddi_free(ddi);
+
+	flockfile(stdout); // prevent another thread butting in!
+	printf("\tthread %2zu : best filter id = ",tnum+1);
+	if (isnan(targ->DD)) printf("(none feasible)");
+	else rt_print_id(fsize,targ->ftab);
+	printf(" : filter entropy ≈ %8.6f, DD ≈ %8.6f (acceptance rate = %5.3f)\n",targ->Hf,targ->DD,(double)naccept/(double)niters);
+	fflush(stdout);
+	funlockfile(stdout);
+
+	const double cte = get_thread_cpu_time() - cts;
+	const double wte = get_wall_time() - wts;
+
+	printf("thread %2zu : FINISHED (cpu time = %.4f, wall time = %.4f)\n",tnum+1,cte,wte);
+	fflush(stdout);
+
+	pthread_exit(NULL);
+}
@@ -1,33 +1,53 @@
-#include <pthread.h>
 #include <stdio.h>
 
 #include "clap.h"
 #include "rtab.h"
+#include "pool.h"
 
-typedef struct {
+typedef struct tfarg {
 	word_t* rtab;
 	word_t* ftab;
+	word_t  rmask; // (outer-)totalistic rule mask (rule type not RT_TABLE)
+	const struct tfarg* orig; // equivalent rule/filter pair computed elsewhere (or NULL)
 	double* Hr;
 	double* Hf;
 	double* DD;
+	int     lmf; // first length with nonzero DD (lumpability pre-screen)
+	int     mHr; // sequence lengths reached
+	int     mHf;
+	int     mDD;
 } tfarg_t;
 
 typedef struct {
-	size_t    tnum;
-	size_t    nfpert;
+	size_t    npairs;
 	int       rsize;
 	int       fsize;
+	int       rtype;
+	double    rlam;
+	double    flam;
+	uint64_t  rkey;
+	uint64_t  fkey;
+	size_t    jnum;
 	int       emmax;
 	int       eiff;
 	int       tmmax;
 	int       tiff;
 	int       tlag;
-	uint64_t* ebuf;
+	int       lmax;
+	double    ctol;
+	double    tbud;
+	size_t    eblen;
+	size_t    tblen;
+	size_t    lblen;
+	uint64_t* ebuf;   // per-thread work buffers
 	uint64_t* tbuf;
-	tfarg_t*  tfargs;
+	word_t*   lbuf;
+	tfarg_t*  tfargs; // all rule/filter pairs
 } targ_t;
 
-static void* compfun(void* arg);
+static void rule_fprint_id(const int rsize, const int rtype, const tfarg_t* const tfarg, FILE* const fstream);
+static void gentask (void* const arg, const size_t k, const size_t tnum);
+static void comptask(void* const arg, const size_t k, const size_t tnum);
 
 int sim_ddr(int argc, char* argv[], int info)
 {
@@ -37,8 +57,9 @@ int sim_ddr(int argc, char* argv[], int info)
 	// Arg:   name      type     default       description
 	puts("\n---------------------------------------------------------------------------------------");
 	CLAP_CARG(rsize,    int,     5,             "CA rule size");
-	CLAP_CARG(rlam,     double,  0.6,           "CA rule lambda");
+	CLAP_CARG(rlam,     double,  0.6,           "CA rule lambda (mask bit probability for totalistic rules)");
 	CLAP_CARG(rseed,    ulong,   0,             "CA rule random seed (or 0 for unpredictable)");
+	CLAP_CARG(rtype,    int,     0,             "CA rule type: 0 = lookup table, 1 = totalistic, 2 = outer-totalistic");
 	CLAP_CARG(fsize,    int,     5,             "filter rule size");
 	CLAP_CARG(flammin,  double,  0.6,           "filter rule lambda range minimum");
 	CLAP_CARG(flammax,  double,  0.9,           "filter rule lambda range maximum");
@@ -49,8 +70,13 @@ int sim_ddr(int argc, char* argv[], int info)
 	CLAP_CARG(tmmax,    int,     14,            "maximum sequence length for DD calculation");
 	CLAP_CARG(tiff,     int,     0,             "advance before DD calculation");
 	CLAP_CARG(tlag,     int,     1,             "lag for DD calculation");
+	CLAP_CARG(ctol,     double,  0.0,           "convergence tolerance for entropy/DD sequence lengths (or 0 for none)");
+	CLAP_CARG(tbud,     double,  0.0,           "time budget (secs) per entropy/DD curve (or 0 for none)");
+	CLAP_CARG(lmax,     int,     0,             "maximum sequence length for exact DD = 0 pre-screen (or 0 for none)");
+	CLAP_CARG(rngmt,    int,     0,             "Mersenne Twister for random rules/filters (reproduces earlier runs; else keyed by pair index)?");
 	CLAP_CARG(nthreads, size_t,  4,             "number of threads");
-	CLAP_CARG(nfpert,   size_t,  10,            "number of rules/filters per thread");
+	CLAP_CARG(nfpert,   size_t,  10,            "number of rules/filters per thread (sample size = nthreads x nfpert)");
+	CLAP_CARG(chunk,    size_t,  1,             "rules/filters claimed by a thread at a time");
 	CLAP_CARG(odir,     cstr,   "/tmp",         "output file directory");
 	CLAP_CARG(jobidx,   cstr,   "LSB_JOBINDEX", "job index");
 	puts("---------------------------------------------------------------------------------------\n");
@@ -72,19 +98,25 @@ int sim_ddr(int argc, char* argv[], int info)
 	const double flam = flammin+(double)(jnum-1)*((flammax-flammin)/((double)(flamres-1)));
 	printf("filter lambda = %g\n\n",flam);
 
+	ASSERT(rtype >= RT_TABLE && rtype <= RT_OUTER,"Bad rule type (%d)",rtype);
+	ASSERT(rtype != RT_OUTER || rsize <= WOUTMAXB,"Outer-totalistic rule too big");
+	ASSERT(rsize <= RT_TOTTABMAXB,"CA rule too big (entropy and DD need the rule table)");
+
 	// buffer sizes for heap memory allocation
 
-	const size_t rlen  = POW2(rsize);
-	const size_t flen  = POW2(fsize);
+	const size_t rlen  = rt_nwords(rsize); // bit-packed rule tables
+	const size_t flen  = rt_nwords(fsize);
 	const size_t hlen  = (size_t)(emmax > tmmax ? emmax : tmmax)+1;
 	const size_t eblen = POW2(emmax);
 	const size_t tblen = POW2(2*tmmax);
+	const size_t lblen = lmax > 0 ? POW2(lmax) : 0;
 
 	const unsigned long minmem =
 		nthreads*nfpert*(rlen+flen)*sizeof(word_t) +
 		nthreads*nfpert*3*hlen*sizeof(double) +
 		nthreads*nfpert*sizeof(tfarg_t) +
-		nthreads*(eblen+tblen)*sizeof(uint64_t);
+		nthreads*(eblen+tblen)*sizeof(uint64_t) +
+		nthreads*lblen*sizeof(word_t);
 
 	TEST_RAM(minmem);
 
@@ -94,11 +126,27 @@ int sim_ddr(int argc, char* argv[], int info)
 
 	if (info) return EXIT_SUCCESS; // display some info and return
 
-	// pseudo-random number generators
+	ASSERT(chunk > 0,"chunk size must be positive");
+	const size_t npairs = nthreads*nfpert;
+
+	// pseudo-random number generators: by default rule/filter pair k is generated
+	// (in parallel) from keys (rule seed, k) and (filter seed,
+	// job, k), so the sample does not depend on the number of threads or on
+	// generation order; the same rules are drawn for every job, as before. With
+	// rngmt, the serial Mersenne Twister streams of earlier runs are reproduced.
 
 	mt_t rrng, frng;
-	mt_seed(&rrng,rseed);
-	mt_seed(&frng,fseed);
+	uint64_t rkey = 0, fkey = 0;
+	if (rngmt) {
+		mt_seed(&rrng,rseed);
+		mt_seed(&frng,fseed);
+	}
+	else {
+		xr_t xrng;
+		rkey = xr_seed(&xrng,rseed); // unpredictable key if seed is 0
+		fkey = xr_seed(&xrng,fseed);
+		printf("*** Rule key = %"PRIu64", filter key = %"PRIu64" (job %zu)\n\n",rkey,fkey,jnum);
+	}
 
 	// allocate buffers for random rules and filters
 
@@ -118,6 +166,12 @@ int sim_ddr(int argc, char* argv[], int info)
 	uint64_t* const tbuf = malloc(nthreads*tblen*sizeof(uint64_t));
 	TEST_ALLOC(tbuf);
 
+	word_t* lbuf = NULL; // only needed for DD = 0 pre-screen
+	if (lmax > 0) {
+		lbuf = malloc(nthreads*lblen*sizeof(word_t));
+		TEST_ALLOC(lbuf);
+	}
+
 	// allocate storage buffers for entropy and DD results
 
 	double* const  Hrbuf = malloc(nthreads*nfpert*hlen*sizeof(double));
@@ -136,60 +190,102 @@ int sim_ddr(int argc, char* argv[], int info)
 
 	// set up thread arguments
 
-	targ_t targs[nthreads];
-	for (size_t i=0; i<nthreads; ++i) {
-		targ_t* const targ = &targs[i];
-
-		// thread-independent
-
-		targ->nfpert = nfpert;
-		targ->rsize  = rsize;
-		targ->fsize  = fsize;
-		targ->emmax  = emmax;
-		targ->eiff   = eiff;
-		targ->tmmax  = tmmax;
-		targ->tiff   = tiff;
-		targ->tlag   = tlag;
-
-		// thread-dependent
-
-		targ->tnum   = i;
-		targ->ebuf   = ebuf  + i*eblen;
-		targ->tbuf   = tbuf  + i*tblen;
-		targ->tfargs = tfbuf + i*nfpert;
-
-		// thread/filter-dependent
-
-		word_t* const rbufi  = rbuf  + i*nfpert*rlen;
-		word_t* const fbufi  = fbuf  + i*nfpert*flen;
-		double* const Hrbufi = Hrbuf + i*nfpert*hlen;
-		double* const Hfbufi = Hfbuf + i*nfpert*hlen;
-		double* const DDbufi = DDbuf + i*nfpert*hlen;
-		for (size_t j=0; j<nfpert; ++j) {
-			tfarg_t* const tfarg = &targ->tfargs[j];
-			rt_randomise(rsize,tfarg->rtab = rbufi+j*rlen,rlam,&rrng);
-			rt_randomise(fsize,tfarg->ftab = fbufi+j*flen,flam,&frng);
-			tfarg->Hr = Hrbufi+j*hlen;
-			tfarg->Hf = Hfbufi+j*hlen;
-			tfarg->DD = DDbufi+j*hlen;
+	targ_t targ;
+	targ.npairs = npairs;
+	targ.rsize  = rsize;
+	targ.fsize  = fsize;
+	targ.rtype  = rtype;
+	targ.rlam   = rlam;
+	targ.flam   = flam;
+	targ.rkey   = rkey;
+	targ.fkey   = fkey;
+	targ.jnum   = jnum;
+	targ.emmax  = emmax;
+	targ.eiff   = eiff;
+	targ.tmmax  = tmmax;
+	targ.tiff   = tiff;
+	targ.tlag   = tlag;
+	targ.lmax   = lmax;
+	targ.ctol   = ctol;
+	targ.tbud   = tbud;
+	targ.eblen  = eblen;
+	targ.tblen  = tblen;
+	targ.lblen  = lblen;
+	targ.ebuf   = ebuf;
+	targ.tbuf   = tbuf;
+	targ.lbuf   = lbuf;
+	targ.tfargs = tfbuf;
+
+	for (size_t k=0; k<npairs; ++k) {
+		tfarg_t* const tfarg = &tfbuf[k];
+		tfarg->rtab = rbuf+k*rlen;
+		tfarg->ftab = fbuf+k*flen;
+		if (rngmt) {
+			if (rtype == RT_TABLE) rt_randomise(rsize,tfarg->rtab,rlam,&rrng);
+			else rt_from_totalistic(rsize,tfarg->rtab,(rtype_t)rtype,tfarg->rmask = rt_tot_random(rsize,(rtype_t)rtype,rlam,&rrng));
+			rt_randomise(fsize,tfarg->ftab,flam,&frng);
+		}
+		tfarg->Hr = Hrbuf+k*hlen;
+		tfarg->Hf = Hfbuf+k*hlen;
+		tfarg->DD = DDbuf+k*hlen;
+	}
+
+	// generate keyed rule/filter pairs in parallel
+
+	if (!rngmt) pool_run(npairs,chunk,nthreads,gentask,&targ,NULL);
+
+	// find rule/filter pairs equivalent under reflection/complement symmetries: these are not recomputed
+
+	{
+		const size_t n = npairs;
+		int*           const rsizs = malloc(n*sizeof(int));
+		TEST_ALLOC(rsizs);
+		int*           const fsizs = malloc(n*sizeof(int));
+		TEST_ALLOC(fsizs);
+		const word_t** const rtabs = malloc(n*sizeof(word_t*));
+		TEST_ALLOC(rtabs);
+		const word_t** const ftabs = malloc(n*sizeof(word_t*));
+		TEST_ALLOC(ftabs);
+		size_t*        const dup   = malloc(n*sizeof(size_t));
+		TEST_ALLOC(dup);
+		for (size_t k=0; k<n; ++k) {
+			rsizs[k] = rsize;
+			fsizs[k] = fsize;
+			rtabs[k] = tfbuf[k].rtab;
+			ftabs[k] = tfbuf[k].ftab;
 		}
+		const size_t ndups = rt_pair_dups(n,rsizs,rtabs,fsizs,ftabs,dup);
+		for (size_t k=0; k<n; ++k) tfbuf[k].orig = dup[k] == k ? NULL : &tfbuf[dup[k]];
+		printf("*** %zu of %zu rule/filter pairs equivalent to an earlier pair (results reused)\n\n",ndups,n);
+		free(dup);
+		free(ftabs);
+		free(rtabs);
+		free(fsizs);
+		free(rsizs);
 	}
 
-	// create threads
+	// compute: threads claim rule/filter pairs from a shared pool as they finish
 
-	printf("*** Creating %zu threads with %zu simulations per thread\n\n",nthreads,nfpert);
+	printf("*** Running %zu simulations on %zu threads\n\n",npairs,nthreads);
 
-	pthread_t threads[nthreads]; // NOTE: joinable by default (otherwise use pthread_attr_setdetachstate())
-	for (size_t i=0; i<nthreads; ++i) {
-		const int tres = pthread_create(&threads[i],NULL,compfun,(void*)&targs[i]);
-		PASSERT(tres == 0,"unable to create thread %zu",i+1)
-	}
+	pool_stat_t stat[nthreads];
+	pool_run(npairs,chunk,nthreads,comptask,&targ,stat);
+	putchar('\n');
+	pool_print_stat(nthreads,stat);
 
-	// wait for computational threads to complete
+	// copy results for equivalent rule/filter pairs
 
-	for (size_t i=0; i<nthreads; ++i) {
-		const int tres = pthread_join(threads[i],NULL);
-		PASSERT(tres == 0,"unable to join thread %zu",i+1);
+	for (size_t k=0; k<npairs; ++k) {
+		tfarg_t* const tfarg = &tfbuf[k];
+		const tfarg_t* const orig = tfarg->orig;
+		if (orig == NULL) continue;
+		memcpy(tfarg->Hr,orig->Hr,hlen*sizeof(double));
+		memcpy(tfarg->Hf,orig->Hf,hlen*sizeof(double));
+		memcpy(tfarg->DD,orig->DD,hlen*sizeof(double));
+		tfarg->lmf = orig->lmf;
+		tfarg->mHr = orig->mHr;
+		tfarg->mHf = orig->mHf;
+		tfarg->mDD = orig->mDD;
 	}
 
 	// write out results
@@ -201,24 +297,27 @@ int sim_ddr(int argc, char* argv[], int info)
 	fflush(stdout);
 	FILE* const dfs = fopen(ofname,"w");
 	PASSERT(dfs != NULL,"Failed to open output file \"%s\"\n",ofname);
-	fprintf(dfs,"# rule    size    = %2d (lambda  = %8.6f)\n"
+	fprintf(dfs,"# rule    size    = %2d (lambda  = %8.6f, type = %d)\n"
 	            "# filter  size    = %2d (lambda  = %8.6f)\n"
 	            "# entropy seqlen  = %2d (advance = %d)\n"
 	            "# dynind  seqlen  = %2d (advance = %d, lag = %d)\n"
-	            "# sample  size    = %zu\n\n"
-	            ,rsize,rlam,fsize,flam,emmax,eiff,tmmax,tiff,tlag,nthreads*nfpert);
-	for (size_t i=0; i<nthreads; ++i) {
-		const targ_t* const targ = &targs[i];
-		for (size_t j=0; j<targ->nfpert; ++j) {
-			const tfarg_t* const tfarg = &targ->tfargs[j];
-			fprintf(dfs,"# rule id = ");
-			rt_fprint_id(rsize,tfarg->rtab,dfs);
-			fprintf(dfs,", filter id = ");
-			rt_fprint_id(fsize,tfarg->ftab,dfs);
-			fputc('\n',dfs);
-			for (int m=0; m<(int)hlen; ++m) fprintf(dfs,"%4d\t%8.6f\t%8.6f\t%8.6f\n",m,tfarg->Hr[m],tfarg->Hf[m],tfarg->DD[m]);
-			fputs("\n",dfs);
-		}
+	            "# lump    seqlen  = %2d\n"
+	            "# converge tol    = %g (time budget = %g)\n"
+	            "# sample  size    = %zu\n"
+	            ,rsize,rlam,rtype,fsize,flam,emmax,eiff,tmmax,tiff,tlag,lmax,ctol,tbud,npairs);
+	if (rngmt) fprintf(dfs,"# random  seeds   = %lu %lu (Mersenne Twister)\n\n",rseed,fseed);
+	else       fprintf(dfs,"# random  keys    = %"PRIu64" %"PRIu64" (job %zu)\n\n",rkey,fkey,jnum);
+	for (size_t k=0; k<npairs; ++k) {
+		const tfarg_t* const tfarg = &tfbuf[k];
+		fprintf(dfs,"# rule id = ");
+		rule_fprint_id(rsize,rtype,tfarg,dfs);
+		fprintf(dfs,", filter id = ");
+		rt_fprint_id(fsize,tfarg->ftab,dfs);
+		if (tfarg->lmf > 0) fprintf(dfs,", dependent at length %d",tfarg->lmf);
+		else fprintf(dfs,", lengths reached = %d %d %d",tfarg->mHr,tfarg->mHf,tfarg->mDD);
+		fputs(tfarg->orig != NULL ? " (equivalent pair)\n" : "\n",dfs);
+		for (int m=0; m<(int)hlen; ++m) fprintf(dfs,"%4d\t%8.6f\t%8.6f\t%8.6f\n",m,tfarg->Hr[m],tfarg->Hf[m],tfarg->DD[m]);
+		fputs("\n",dfs);
 	}
 	if (fclose(dfs) == -1) PEEXIT("Failed to close output file \"%s\"\n",ofname);
 	puts("done\n");
@@ -231,6 +330,7 @@ int sim_ddr(int argc, char* argv[], int info)
 	free(DDbuf);
 	free(Hfbuf);
 	free(Hrbuf);
+	free(lbuf);
 	free(tbuf);
 	free(ebuf);
 	free(fbuf);
@@ -239,18 +339,24 @@ int sim_ddr(int argc, char* argv[], int info)
 	return EXIT_SUCCESS;
 }
 
-void* compfun(void* arg)
+void gentask(void* const arg, const size_t k, const size_t tnum)
 {
-	const double wts = get_wall_time();
-	const double cts = get_thread_cpu_time ();
+	// rule/filter pair k, from its index alone
 
-	const pthread_t tpid     = pthread_self();
 	const targ_t* const targ = (targ_t*)arg;
-	const size_t tnum        = targ->tnum;
-	const size_t nfpert      = targ->nfpert;
+	tfarg_t* const tfarg = &targ->tfargs[k];
+	xr_t rng;
+	xr_seed_key(&rng,targ->rkey,0,k);
+	if (targ->rtype == RT_TABLE) rt_randomise_xr(targ->rsize,tfarg->rtab,targ->rlam,&rng);
+	else rt_from_totalistic(targ->rsize,tfarg->rtab,(rtype_t)targ->rtype,tfarg->rmask = rt_tot_random_xr(targ->rsize,(rtype_t)targ->rtype,targ->rlam,&rng));
+	xr_seed_key(&rng,targ->fkey,targ->jnum,k);
+	rt_randomise_xr(targ->fsize,tfarg->ftab,targ->flam,&rng);
+}
 
-	printf("thread %2zu (%zu) : %zu filters : STARTED\n",tnum+1,tpid,nfpert);
-	fflush(stdout);
+void comptask(void* const arg, const size_t k, const size_t tnum)
+{
+	const targ_t* const targ = (targ_t*)arg;
+	const size_t npairs      = targ->npairs;
 
 	const int rsize = targ->rsize;
 	const int fsize = targ->fsize;
@@ -259,45 +365,63 @@ void* compfun(void* arg)
 	const int tmmax = targ->tmmax;
 	const int tiff  = targ->tiff;
 	const int tlag  = targ->tlag;
+	const int lmax  = targ->lmax;
+	const double ctol = targ->ctol;
+	const double tbud = targ->tbud;
 
-	uint64_t* const ebuf = targ->ebuf;
-	uint64_t* const tbuf = targ->tbuf;
+	uint64_t* const ebuf = targ->ebuf + tnum*targ->eblen;
+	uint64_t* const tbuf = targ->tbuf + tnum*targ->tblen;
+	word_t*   const lbuf = lmax > 0 ? targ->lbuf + tnum*targ->lblen : NULL;
 
 	const int hlen   = (emmax > tmmax ? emmax : tmmax)+1;
 	const int rfsize = rsize > fsize ? rsize : fsize;
 
-	for (size_t j=0; j<nfpert; ++j) {
+	tfarg_t* const tfarg = &targ->tfargs[k];
+
+	const word_t* const rtab = tfarg->rtab;
+	const word_t* const ftab = tfarg->ftab;
+	double*       const Hr   = tfarg->Hr;
+	double*       const Hf   = tfarg->Hf;
+	double*       const DD   = tfarg->DD;
 
-		const tfarg_t* const tfarg = &targ->tfargs[j];
+	for (int m=0; m<hlen; ++m) Hr[m] = NAN;
+	for (int m=0; m<hlen; ++m) Hf[m] = NAN;
+	for (int m=0; m<hlen; ++m) DD[m] = NAN;
 
-		const word_t* const rtab = tfarg->rtab;
-		const word_t* const ftab = tfarg->ftab;
-		double*       const Hr   = tfarg->Hr;
-		double*       const Hf   = tfarg->Hf;
-		double*       const DD   = tfarg->DD;
+	if (tfarg->orig != NULL) return; // equivalent to another pair - results copied later
 
-		for (int m=0; m<hlen; ++m) Hr[m] = NAN;
-		for (int m=0; m<hlen; ++m) Hf[m] = NAN;
-		for (int m=0; m<hlen; ++m) DD[m] = NAN;
-		for (int m=rsize;  m<=emmax; ++m) Hr[m] = rt_entro(rsize,rtab,m,eiff,ebuf)/(double)m;
-		for (int m=fsize;  m<=emmax; ++m) Hf[m] = rt_entro(fsize,ftab,m,eiff,ebuf)/(double)m;
-		for (int m=rfsize; m<=tmmax; ++m) DD[m] = rt_dd   (rsize,rtab,fsize,ftab,m,tiff,tlag,ebuf,tbuf)/(double)m;
+	// exact pre-screen: reject filters which are already dependent at short sequence lengths
 
+	tfarg->lmf = lmax > 0 ? rt_lumpable_mmax(rsize,rtab,fsize,ftab,rfsize,lmax,tiff,tlag,lbuf) : 0;
+	if (tfarg->lmf > 0) {
 		flockfile(stdout); // prevent another thread butting in!
-		printf("\tthread %2zu : filter %2zu of %2zu : rule id = ",tnum+1,j+1,nfpert);
-		rt_print_id(rsize,rtab);
+		printf("\tthread %2zu : filter %3zu of %3zu : rule id = ",tnum+1,k+1,npairs);
+		rule_fprint_id(rsize,targ->rtype,tfarg,stdout);
 		printf(", filter id = ");
 		rt_print_id(fsize,ftab);
-		printf(" : rule entropy ≈ %8.6f, filter entropy ≈ %8.6f, DD ≈ %8.6f\n",Hr[emmax],Hf[emmax],DD[tmmax]);
+		printf(" : dependent at length %d (skipped)\n",tfarg->lmf);
 		fflush(stdout);
 		funlockfile(stdout);
+		return;
 	}
 
-	const double cte = get_thread_cpu_time() - cts;
-	const double wte = get_wall_time() - wts;
+	const int mHr = tfarg->mHr = rt_entro_curve(rsize,rtab,rsize,emmax,eiff,1,ctol,tbud,ebuf,Hr);
+	const int mHf = tfarg->mHf = rt_entro_curve(fsize,ftab,fsize,emmax,eiff,1,ctol,tbud,ebuf,Hf);
+	const int mDD = tfarg->mDD = rt_dd_curve(rsize,rtab,fsize,ftab,rfsize,tmmax,tiff,tlag,1,ctol,tbud,ebuf,tbuf,DD);
 
-	printf("thread %2zu : FINISHED (cpu time = %.4f, wall time = %.4f)\n",tnum+1,cte,wte);
+	flockfile(stdout); // prevent another thread butting in!
+	printf("\tthread %2zu : filter %3zu of %3zu : rule id = ",tnum+1,k+1,npairs);
+	rule_fprint_id(rsize,targ->rtype,tfarg,stdout);
+	printf(", filter id = ");
+	rt_print_id(fsize,ftab);
+	printf(" : rule entropy ≈ %8.6f (%d), filter entropy ≈ %8.6f (%d), DD ≈ %8.6f (%d)\n",Hr[mHr],mHr,Hf[mHf],mHf,DD[mDD],mDD);
 	fflush(stdout);
+	funlockfile(stdout);
+}
 
-	pthread_exit(NULL);
+void rule_fprint_id(const int rsize, const int rtype, const tfarg_t* const tfarg, FILE* const fstream)
+{
+	// compact id for (outer-)totalistic rules, from the mask they were made with
+	if (rtype == RT_TABLE) rt_fprint_id(rsize,tfarg->rtab,fstream);
+	else rt_tot_fprint_id(rsize,(rtype_t)rtype,tfarg->rmask,fstream);
 }
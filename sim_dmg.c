@@ -0,0 +1,86 @@
+#include "dmg.h"
+#include "rtab.h"
+#include "clap.h"
+
+// Damage spreading and maximum Lyapunov exponent for the CA rules in an
+// rtids file (filters are ignored): a cheap chaos classifier for rule
+// libraries.
+
+int sim_dmg(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name      type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(irtfile,  cstr,   "saved.rt",    "input rtids file");
+	CLAP_CARG(nwords,   size_t,  4,            "row length in words");
+	CLAP_CARG(ngens,    size_t,  100,          "number of generations");
+	CLAP_CARG(nruns,    size_t,  100,          "number of runs (seeds) per rule");
+	CLAP_CARG(pflip,    double,  0.0,          "damage cell flip probability (or 0 for single cell)");
+	CLAP_CARG(iseed,    ulong,   0,            "initialisation random seed (or 0 for unpredictable)");
+	CLAP_CARG(odir,     cstr,   "/tmp",        "output file directory");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	ASSERT(nwords > 0,"row length must be positive");
+	ASSERT(pflip >= 0.0 && pflip <= 1.0,"flip probability must lie in [0,1]");
+
+	// Read in rule rtids
+
+	ASSERT(irtfile[0] != '\0',"Must supply an input rtid file");
+	printf("Reading rules from '%s' ...\n",irtfile);
+	FILE* const irtfs = fopen(irtfile,"r");
+	PASSERT(irtfs != NULL,"failed to open input rtids file");
+	rtl_t* const rule = rtl_fread(irtfs);
+	ASSERT(rule != NULL,"No valid rtids found in input file!");
+	const int fres = fclose(irtfs);
+	PASSERT(fres == 0,"failed to close input rtids file");
+	putchar('\n');
+
+	// damage spreading
+
+	const size_t ofnlen = strlen(odir)+11;
+	char ofname[ofnlen];
+	snprintf(ofname,ofnlen,"%s/cadmg.dat",odir);
+	FILE* const dfs = fopen(ofname,"w");
+	PASSERT(dfs != NULL,"Failed to open output file \"%s\"\n",ofname);
+	fprintf(dfs,"# row length = %zu, generations = %zu, runs = %zu, flip probability = %g\n",nwords*WBITS,ngens,nruns,pflip);
+	fprintf(dfs,"# rule id\tsize\tlambda\tLyapunov\tpLyap\tvleft\tvright\tdamage\tsurvival\n");
+
+	size_t nrules = 0, nskip = 0;
+	for (const rtl_t* r = rule; r != NULL; r = r->next, ++nrules) {
+		const int size = r->size;
+		if (r->tab == NULL) { // table-free (outer-)totalistic rule: the Boolean derivatives need the table
+			const double lam = rt_tot_lambda(size,r->rtype,r->mask);
+			printf("rule id = ");
+			rt_tot_print_id(size,r->rtype,r->mask);
+			printf(" : size = %2d, lambda = %6.4f : too big for a rule table, skipped\n",size,lam);
+			rt_tot_fprint_id(size,r->rtype,r->mask,dfs);
+			fprintf(dfs,"\t%d\t%8.6f\tNaN\tNaN\tNaN\tNaN\tNaN\tNaN\n",size,lam);
+			++nskip;
+			continue;
+		}
+		dmg_t* const dmg = dmg_run(nwords,size,r->tab,NULL,ngens,nruns,pflip,iseed);
+
+		printf("rule id = ");
+		rt_print_id(size,r->tab);
+		printf(" : size = %2d, lambda = %6.4f : ",size,rt_lambda(size,r->tab));
+		dmg_print(dmg);
+
+		rt_fprint_id(size,r->tab,dfs);
+		fprintf(dfs,"\t%d\t%8.6f\t%8.6f\t%5.3f\t%6.4f\t%6.4f\t%8.6f\t%5.3f\n",size,rt_lambda(size,r->tab),dmg->lyap,dmg->plyap,dmg->vleft,dmg->vright,dmg->ham[ngens],dmg->psurv);
+		dmg_free(dmg);
+	}
+	if (fclose(dfs) == -1) PEEXIT("Failed to close output file \"%s\"\n",ofname);
+
+	printf("\n%zu rules",nrules);
+	if (nskip > 0) printf(" (table-free rules skipped: %zu)",nskip);
+	putchar('\n');
+	printf("\nResults written to \"%s\"\n",ofname);
+
+	rtl_free(rule);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#include "ens.h"
+#include "rtab.h"
+#include "tune.h"
+#include "clap.h"
+
+// Ensemble statistics for a CA rule: many random initial rows are advanced
+// together, and per-generation means and variances of density, block
+// frequencies and Hamming distance between member pairs are streamed (no
+// spacetime is stored).
+
+int sim_ens(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name      type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(rtid,     cstr,   "",             "CA rule id (or empty for random)");
+	CLAP_CARG(rsize,    int,     5,             "CA rule size (random rule)");
+	CLAP_CARG(rlam,     double,  0.6,           "CA rule lambda (random rule)");
+	CLAP_CARG(rseed,    ulong,   0,             "CA rule random seed (or 0 for unpredictable)");
+	CLAP_CARG(nwords,   size_t,  2,             "row length in words");
+	CLAP_CARG(esize,    size_t,  10000,         "ensemble size");
+	CLAP_CARG(ngens,    size_t,  1000,          "number of generations");
+	CLAP_CARG(iden,     double,  0.5,           "initial density");
+	CLAP_CARG(odens,    int,     1,             "density observable?");
+	CLAP_CARG(oblen,    int,     0,             "block frequency observable block length (or 0 for none)");
+	CLAP_CARG(ohamm,    int,     1,             "pairwise Hamming distance observable?");
+	CLAP_CARG(iseed,    ulong,   0,             "initialisation random seed (or 0 for unpredictable)");
+	CLAP_CARG(nthreads, int,     4,             "number of threads");
+	CLAP_CARG(chunk,    size_t,  64,            "ensemble members per work unit");
+	CLAP_CARG(kernel,   cstr,   "auto",         "stepping kernel: auto, retune, generic, spec, native or total");
+	CLAP_CARG(pstride,  size_t,  100,           "generations between printed rows");
+	CLAP_CARG(odir,     cstr,   "/tmp",         "output file directory");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	ASSERT(nwords > 0,"row length must be positive");
+	ASSERT(iden >= 0.0 && iden <= 1.0,"initial density must lie in [0,1]");
+	ASSERT(pstride > 0,"print stride must be positive");
+
+	const int obs = (odens ? ENS_DENS : 0)|(oblen > 0 ? ENS_BLOCK : 0)|(ohamm ? ENS_HAMM : 0);
+
+	// CA rule: user-supplied or random
+
+	int rsiz = rsize;
+	word_t* rtab;
+	if (rtid[0] == '\0') {
+		mt_t rrng;
+		mt_seed(&rrng,rseed);
+		rtab = rt_alloc(rsiz);
+		rt_randomise(rsiz,rtab,rlam,&rrng);
+	}
+	else {
+		rtab = rt_sread_id(rtid,&rsiz);
+		ASSERT(rsiz != -1,"CA rule id is bad size");
+		ASSERT(rsiz != -2,"CA rule id contains non-hex characters");
+	}
+	printf("*** CA rule id = ");
+	rt_print_id(rsiz,rtab);
+	printf(" (size = %d, lambda = %6.4f), row length = %zu bits, ensemble size = %zu\n\n",rsiz,rt_lambda(rsiz,rtab),nwords*WBITS,esize);
+
+	// stepping kernel (autotuned unless forced)
+
+	const mw_filter_t kern = tune_kernel(rsiz,nwords,rtab,rt_totalistic(rsiz,rtab,NULL),kernel,1);
+	putchar('\n');
+
+	// run ensemble
+
+	double ts = timer();
+	ens_t* const ens = ens_run(esize,ngens,nwords,rsiz,rtab,kern,obs,oblen,iden,iseed,nthreads,chunk);
+	ts = timer()-ts;
+	ens_print(ens,pstride);
+	printf("\n%zu members x %zu generations in %.2f seconds (%.3f ns/word)\n",esize,ngens,ts,1e9*ts/((double)esize*(double)ngens*(double)nwords));
+
+	const size_t ofnlen = strlen(odir)+11;
+	char ofname[ofnlen];
+	snprintf(ofname,ofnlen,"%s/caens.dat",odir);
+	if (!ens_write(ens,ofname)) PEEXIT("Failed to write output file \"%s\"\n",ofname);
+	printf("\nResults written to \"%s\"\n",ofname);
+
+	ens_free(ens);
+	free(rtab);
+
+	return EXIT_SUCCESS;
+}
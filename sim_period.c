@@ -0,0 +1,80 @@
+#include "analyse.h"
+#include "tune.h"
+#include "clap.h"
+
+// Period census for a CA rule on wide rows: many random initial conditions
+// are run to their attractors (bounded-memory cycle detection), and the
+// distributions of transient length, period and twist are reported.
+
+int sim_period(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name      type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(rtid,     cstr,   "",             "CA rule id (or empty for random)");
+	CLAP_CARG(rsize,    int,     5,             "CA rule size (random rule)");
+	CLAP_CARG(rlam,     double,  0.6,           "CA rule lambda (random rule)");
+	CLAP_CARG(rseed,    ulong,   0,             "CA rule random seed (or 0 for unpredictable)");
+	CLAP_CARG(order,    int,     1,             "CA order (1, or 2 for second-order reversible CA)");
+	CLAP_CARG(nwords,   size_t,  2,             "row length in words");
+	CLAP_CARG(nics,     size_t,  1000,          "(maximum) number of initial conditions");
+	CLAP_CARG(pmax,     size_t,  1000000,       "maximum transient + period");
+	CLAP_CARG(iseed,    ulong,   0,             "initialisation random seed (or 0 for unpredictable)");
+	CLAP_CARG(nthreads, int,     4,             "number of threads");
+	CLAP_CARG(nchk,     size_t,  100,           "initial conditions between convergence checks (or 0 for none)");
+	CLAP_CARG(ptol,     double,  0.01,          "convergence tolerance (total variation distance)");
+	CLAP_CARG(kernel,   cstr,   "auto",         "stepping kernel: auto, retune, generic, spec, native or total");
+	CLAP_CARG(odir,     cstr,   "/tmp",         "output file directory");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	ASSERT(nwords > 0,"row length must be positive");
+	ASSERT(order == 1 || order == 2,"CA order must be 1 or 2");
+	ASSERT(nics > 0,"number of initial conditions must be positive");
+
+	// CA rule: user-supplied or random
+
+	int rsiz = rsize;
+	word_t* rtab;
+	if (rtid[0] == '\0') {
+		mt_t rrng;
+		mt_seed(&rrng,rseed);
+		rtab = rt_alloc(rsiz);
+		rt_randomise(rsiz,rtab,rlam,&rrng);
+	}
+	else {
+		rtab = rt_sread_id(rtid,&rsiz);
+		ASSERT(rsiz != -1,"CA rule id is bad size");
+		ASSERT(rsiz != -2,"CA rule id contains non-hex characters");
+	}
+	printf("*** CA rule id = ");
+	rt_print_id(rsiz,rtab);
+	printf(" (size = %d, lambda = %6.4f), row length = %zu bits, order = %d\n\n",rsiz,rt_lambda(rsiz,rtab),nwords*WBITS,order);
+
+	// stepping kernel (autotuned unless forced)
+
+	const mw_filter_t kern = tune_kernel(rsiz,nwords,rtab,rt_totalistic(rsiz,rtab,NULL),kernel,1);
+	putchar('\n');
+
+	// period census
+
+	double ts = timer();
+	pcen_t* const pcen = caana_period_census(nwords,rsiz,rtab,nics,pmax,iseed,nthreads,nchk,ptol,kern,order);
+	ts = timer()-ts;
+	caana_pcen_print(pcen,10);
+	printf("\n%zu initial conditions in %.2f seconds\n",pcen->nics,ts);
+
+	const size_t ofnlen = strlen(odir)+14;
+	char ofname[ofnlen];
+	snprintf(ofname,ofnlen,"%s/caperiod.dat",odir);
+	if (!caana_pcen_write(pcen,ofname)) PEEXIT("Failed to write output file \"%s\"\n",ofname);
+	printf("\nResults written to \"%s\"\n",ofname);
+
+	caana_pcen_free(pcen);
+	free(rtab);
+
+	return EXIT_SUCCESS;
+}
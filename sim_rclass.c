@@ -0,0 +1,102 @@
+#include "rtab.h"
+#include "clap.h"
+
+// Classify CA rules (surjective, injective, Garden-of-Eden count on rings,
+// topological entropy of image language)
+// read from an rtids file (filters are ignored).
+
+int sim_rclass(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name      type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(irtfile,  cstr,   "saved.rt",    "input rtids file");
+	CLAP_CARG(m,        int,     16,           "ring length for Garden-of-Eden count");
+	CLAP_CARG(maxstates,size_t,  1<<16,        "maximum relation-matrix automaton states (Garden-of-Eden count)");
+	CLAP_CARG(dfamax,   size_t,  1<<20,        "maximum automaton states for topological entropy");
+	CLAP_CARG(uwords,   int,     0,            "also count images on rings by enumeration (check)?");
+	CLAP_CARG(nthreads, int,     4,            "number of threads for enumeration");
+	CLAP_CARG(odir,     cstr,   "/tmp",        "output file directory");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	ASSERT(m > 0 && m < WBITS,"ring length must be in range 1 - 63");
+
+	// Read in rule rtids
+
+	ASSERT(irtfile[0] != '\0',"Must supply an input rtid file");
+	printf("Reading rules from '%s' ...\n",irtfile);
+	FILE* const irtfs = fopen(irtfile,"r");
+	PASSERT(irtfs != NULL,"failed to open input rtids file");
+	rtl_t* const rule = rtl_fread(irtfs);
+	ASSERT(rule != NULL,"No valid rtids found in input file!");
+	const int fres = fclose(irtfs);
+	PASSERT(fres == 0,"failed to close input rtids file");
+	putchar('\n');
+
+	// classify
+
+	const size_t ofnlen = strlen(odir)+14;
+	char ofname[ofnlen];
+	snprintf(ofname,ofnlen,"%s/carclass.dat",odir);
+	FILE* const dfs = fopen(ofname,"w");
+	PASSERT(dfs != NULL,"Failed to open output file \"%s\"\n",ofname);
+	fprintf(dfs,"# ring length = %d\n# rule id\tsize\tlambda\tsurj\tinj\tGoE\ttopent\n",m);
+
+	size_t nrules = 0, nsurj = 0, ninj = 0, nskip = 0;
+	for (const rtl_t* r = rule; r != NULL; r = r->next, ++nrules) {
+		const int size = r->size;
+		if (r->tab == NULL) { // table-free (outer-)totalistic rule: classification needs the table
+			const double lam = rt_tot_lambda(size,r->rtype,r->mask);
+			printf("rule id = ");
+			rt_tot_print_id(size,r->rtype,r->mask);
+			printf(" : size = %2d, lambda = %6.4f : too big for a rule table, skipped\n",size,lam);
+			rt_tot_fprint_id(size,r->rtype,r->mask,dfs);
+			fprintf(dfs,"\t%d\t%8.6f\t%d\t%d\tNaN\tNaN\n",size,lam,-1,-1);
+			++nskip;
+			continue;
+		}
+		const int surj = size <= 13 ? rt_surjective(size,r->tab) : -1;
+		const int inj  = size <= 13 ? rt_injective (size,r->tab) : -1;
+		nsurj += surj == 1;
+		ninj  += inj  == 1;
+
+		// topological entropy of image language
+
+		const double Ht = size <= 7 ? rt_topent(size,r->tab,dfamax,NULL,NULL) : NAN;
+
+		// Garden-of-Eden count: relation-matrix automaton, else enumeration
+
+		uint64_t ngoe = 0;
+		int goeok = size <= 7 && size <= m && rt_ring_goe(size,r->tab,m,maxstates,&ngoe);
+		if (!goeok && size <= m && 2*m <= WBITS) {
+			ngoe  = POW2(m)-rt_uwords(size,r->tab,m,nthreads);
+			goeok = 1;
+		}
+
+		printf("rule id = ");
+		rt_print_id(size,r->tab);
+		printf(" : size = %2d, lambda = %6.4f : surjective = %2d, injective = %2d, GoE = ",size,rt_lambda(size,r->tab),surj,inj);
+		if (goeok) printf("%"PRIu64,ngoe); else printf("(too many states)");
+		if (uwords && size <= m && 2*m <= WBITS) printf(" (enumerated: %zu)",(size_t)POW2(m)-rt_uwords(size,r->tab,m,nthreads));
+		printf(", topent = %8.6f\n",Ht);
+
+		rt_fprint_id(size,r->tab,dfs);
+		fprintf(dfs,"\t%d\t%8.6f\t%d\t%d\t",size,rt_lambda(size,r->tab),surj,inj);
+		if (goeok) fprintf(dfs,"%"PRIu64,ngoe); else fprintf(dfs,"NaN");
+		fprintf(dfs,"\t%8.6f\n",Ht);
+	}
+	if (fclose(dfs) == -1) PEEXIT("Failed to close output file \"%s\"\n",ofname);
+
+	printf("\n%zu rules : %zu surjective, %zu injective",nrules,nsurj,ninj);
+	if (nskip > 0) printf(" (table-free rules skipped: %zu)",nskip);
+	putchar('\n');
+	printf("\nResults written to \"%s\"\n",ofname);
+
+	rtl_free(rule);
+
+	return EXIT_SUCCESS;
+}
@@ -11,8 +11,13 @@
 #include "rtab.h"
 #include "strman.h"
 #include "analyse.h"
+#include "census.h"
+#include "tune.h"
+#include "dmg.h"
 
 void print_id(const rtl_t* const rule, const int filtering);
+static rtl_t* random_rule(rtl_t* rule, const int size, const rtype_t rtype, const double lam, mt_t* const prng);
+static int table_free(const rtl_t* const rule);
 
 // Main "CA Explorer" simulation
 
@@ -26,12 +31,16 @@ int sim_xplor(int argc, char* argv[], int info)
 	CLAP_CARG(nwords,  size_t,  0,            "number of words (or 0 for automatic)");
 	CLAP_VARG(nrows,   size_t,  0,            "number of rows (or 0 for automatic)");
 	CLAP_VARG(rsiz,    int,     5,            "CA rule size");
-	CLAP_VARG(rlam,    double,  0.6,          "CA rule lambda");
+	CLAP_VARG(rlam,    double,  0.6,          "CA rule lambda (mask bit probability for totalistic rules)");
+	CLAP_CARG(rtype,   int,     0,            "random CA rule type: 0 = lookup table, 1 = totalistic, 2 = outer-totalistic");
 	CLAP_CARG(rseed,   ulong,   0,            "CA rule random seed (or 0 for unpredictable)");
 	CLAP_VARG(fsiz,    int,     0,            "filter rule size (or 0 for same as rule size)");
 	CLAP_VARG(flam,    double,  0.8,          "filter rule lambda");
 	CLAP_CARG(fseed,   ulong,   0,            "filter rule random seed (0 for unpredictable)");
 	CLAP_CARG(iseed,   ulong,   0,            "initialisation random seed (0 for unpredictable)");
+	CLAP_CARG(kernel,  cstr,   "auto",        "stepping kernel: auto, retune, generic, spec, native or total");
+	CLAP_VARG(order,   int,     1,            "CA order (1, or 2 for second-order reversible CA)");
+	CLAP_VARG(noise,   double,  0.0,          "probabilistic CA: rule output flip probability per cell");
 	CLAP_CARG(untwist, int,     1,            "untwist?");
 	CLAP_CARG(irtfile, cstr,   "",            "input rtids file (empty to start with random rtid)");
 	CLAP_CARG(ortfile, cstr,   "saved.rt",    "saved rtids file name");
@@ -43,6 +52,16 @@ int sim_xplor(int argc, char* argv[], int info)
 	CLAP_CARG(tmmax,   int,     14,           "maximum sequence length for DD calculation");
 	CLAP_CARG(tiff,    int,     0,            "advance before DD calculation");
 	CLAP_CARG(tlag,    int,     1,            "lag for DD calculation");
+	CLAP_CARG(ctol,    double,  0.0,          "convergence tolerance for entropy/DD sequence lengths (or 0 for none)");
+	CLAP_CARG(tbud,    double,  0.0,          "time budget (secs) per entropy/DD curve (or 0 for none)");
+	CLAP_CARG(lmmax,   int,     20,           "maximum sequence length for exact DD = 0 test");
+	CLAP_CARG(dfamax,  size_t,  1<<20,        "maximum automaton states for topological entropy");
+	CLAP_CARG(pcics,   size_t,  256,          "number of initial conditions for period census");
+	CLAP_CARG(pcthr,   int,     4,            "number of threads for period census");
+	CLAP_CARG(cenm,    int,     16,           "ring length for attractor/basin census");
+	CLAP_CARG(centhr,  int,     4,            "number of threads for attractor/basin census");
+	CLAP_CARG(dmruns,  size_t,  100,          "number of runs for damage spreading");
+	CLAP_CARG(dmpflip, double,  0.0,          "damage cell flip probability (or 0 for single cell)");
 	CLAP_CARG(amice,   int,     0,            "auto-conditional entropy rather than auto-MI?");
 	CLAP_CARG(ppc,     int,     1,            "cell display size in pixels");
 	CLAP_CARG(gpx,     int,     32,           "horizontal gap in pixels");
@@ -58,6 +77,12 @@ int sim_xplor(int argc, char* argv[], int info)
 
 	if (info) return EXIT_SUCCESS; // display switches and return
 
+	ASSERT(rtype >= RT_TABLE && rtype <= RT_OUTER,"Bad rule type (%d)",rtype);
+	ASSERT(rtype != RT_OUTER || rsiz <= WOUTMAXB,"Outer-totalistic rule too big");
+	ASSERT(rtype != RT_TABLE || rsiz <= RT_TOTTABMAXB,"CA rule table too big (totalistic rules may be larger)");
+	ASSERT(order == 1 || order == 2,"CA order must be 1 or 2");
+	ASSERT(noise >= 0.0 && noise <= 1.0,"CA noise must lie in [0,1]");
+
 	// get number of CA rows/cols/words to fit screen
 
 	size_t nr, ncols, nrwords;
@@ -75,6 +100,8 @@ int sim_xplor(int argc, char* argv[], int info)
 	mt_seed(&rrng,rseed);
 	mt_seed(&irng,iseed);
 	mt_seed(&frng,fseed);
+	mt_t nrng; // CA noise
+	mt_seed(&nrng,iseed == 0 ? 0 : iseed+1);
 
 	const int uto = untwist ? utoff == 0 ? rsiz/2 : utoff : 0;
 
@@ -82,7 +109,6 @@ int sim_xplor(int argc, char* argv[], int info)
 	const size_t ncawords = I*n;
 	word_t* const ca  = mw_alloc(ncawords); // the CA
 	word_t* const fca = mw_alloc(ncawords); // the filtered CA
-	word_t* const wca = mw_alloc(ncawords); // working CA
 
 	// window drawing constants
 	const int  imx    = ppc*(int)n*WBITS; // pixels per row
@@ -146,10 +172,18 @@ int sim_xplor(int argc, char* argv[], int info)
 		"c : change CA/filter size\n"
 		"v : invert CA/filter\n"
 		"f : forward CA one screen\n"
+		"o : toggle first/second-order CA\n"
+		"b : reverse time (second-order CA)\n"
 		"i : re-initialise CA\n"
+		"z : set CA noise (output flip probability)\n"
 		"E : calculate entropy of CA rule\n"
 		"D : calculate dynamical dependence of CA/filter rules\n"
+		"L : exact test for zero dynamical dependence of CA/filter rules\n"
+		"T : calculate topological entropy of CA/filter rule images\n"
 		"p : calculate CA period\n"
+		"P : period census over random initial conditions\n"
+		"C : attractor/basin census of CA on rings\n"
+		"y : damage spreading and Lyapunov exponent of CA\n"
 		"s : save CA/filter id to file\n"
 #ifdef HAVE_GD
 		"w : write CA image to file\n"
@@ -164,8 +198,7 @@ int sim_xplor(int argc, char* argv[], int info)
 
 	rtl_t* rule;
 	if (irtfile[0] == '\0') { // no input rtid file
-		rule = rtl_add(NULL,rsiz); // current CA rule: this should never be NULL!
-		rt_randomise(rule->size,rule->tab,rlam,&rrng);
+		rule = random_rule(NULL,rsiz,(rtype_t)rtype,rlam,&rrng); // current CA rule: this should never be NULL!
 	}
 	else { // have input rtid file
 		printf("Reading rules and filters from '%s' ...\n",irtfile);
@@ -176,11 +209,10 @@ int sim_xplor(int argc, char* argv[], int info)
 		if (fclose(irtfs) == -1) PEEXIT("failed to close input rtids file '%s'",irtfile);
 		printf("Done\n\n");
 	}
-	printf("exploring : random CA : id = "); rt_print_id(rule->size,rule->tab);
-	printf(", lambda = %6.4f\n",rt_lambda(rule->size,rule->tab));
-	mw_randomise(n,ca,&irng);
-	ca_run(I,n,ca,wca,rule->size,rule->tab,uto);
-	ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
+	tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,1); // report stepping kernel (autotuning if necessary)
+	printf("exploring : random "); print_id(rule,filtering);
+	mw_randomise((size_t)order*n,ca,&irng);
+	ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 	printf("%s : ",modestr);
 	fflush(stdout);
 
@@ -232,8 +264,7 @@ int sim_xplor(int argc, char* argv[], int info)
 			printf("switching mode : ");
 			filtering = 1-filtering;
 			if (filtering && rule->filt != NULL) {
-				ca_filter(I,n,fca,ca,rule->filt->size,rule->filt->tab);
-				ca_zpixmap_create(I,n,fca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,fca,0,NULL,NULL,rule->filt->size,rule->filt->tab,0,1,0.0,NULL,imdata,ppc,imx,filtering);
 			}
 			else {
 				ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
@@ -249,16 +280,13 @@ int sim_xplor(int argc, char* argv[], int info)
 				printf("random filter : ");
 				rule->filt = rtl_add(rule->filt,fsiz);
 				rt_randomise(rule->filt->size,rule->filt->tab,flam,&frng);
-				ca_filter(I,n,fca,ca,rule->filt->size,rule->filt->tab);
-				ca_zpixmap_create(I,n,fca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,fca,0,NULL,NULL,rule->filt->size,rule->filt->tab,0,1,0.0,NULL,imdata,ppc,imx,filtering);
 			}
 			else {
 				printf("random CA : ");
-				rule = rtl_add(rule,rsiz);
-				rt_randomise(rule->size,rule->tab,rlam,&rrng);
-				mw_randomise(n,ca,&irng);
-				ca_run(I,n,ca,wca,rule->size,rule->tab,uto);
-				ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
+				rule = random_rule(rule,rsiz,(rtype_t)rtype,rlam,&rrng);
+				mw_randomise((size_t)order*n,ca,&irng);
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 			}
 			print_id(rule,filtering);
 			XPutImage(dis,win,gc,im,0,0,1,1,uimx,uimy);
@@ -282,34 +310,38 @@ int sim_xplor(int argc, char* argv[], int info)
 				}
 				printf("filter rule size = %d\n",fsiz);
 				rule->filt = rtl_add(rule->filt,fsiz);
-				rt_copy(rule->size,rule->filt->tab,ftab);
+				rt_copy(rule->filt->size,rule->filt->tab,ftab);
 				free(ftab);
-				ca_filter(I,n,fca,ca,rule->filt->size,rule->filt->tab);
-				ca_zpixmap_create(I,n,fca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,fca,0,NULL,NULL,rule->filt->size,rule->filt->tab,0,1,0.0,NULL,imdata,ppc,imx,filtering);
 				printf("filtering : ");
 				fflush(stdout);
 			}
 			else {
-				printf("enter CA id: "); // prompt for rtid
+				printf("enter CA id: "); // prompt for rtid (or T<B>:<mask>, O<B>:<mask>)
 				fflush(stdout);
-				word_t* const rtab = rt_read_id(&rsiz);
+				char* rtid = NULL;
+				size_t rtidlen = 0;
+				const ssize_t ilen = getline(&rtid,&rtidlen,stdin);
+				ASSERT(ilen != -1,"Read failed.");
+				rtid[ilen-1] = '\0'; // strip trailing newline
+				int newsiz;
+				rtl_t* const rnew = rtl_add_id(rule,rtid,&newsiz);
+				free(rtid);
 				printf("exploring : ");
 				fflush(stdout);
-				if (rsiz == -1) {
+				if (newsiz == -1) {
 					printf("input is wrong length\n");
 					break;
 				}
-				if (rsiz == -2) {
+				if (newsiz == -2) {
 					printf("input contains non-hex characters\n");
 					break;
 				}
+				rsiz = newsiz;
 				printf("CA rule size = %d\n",rsiz);
-				rule = rtl_add(rule,rsiz);
-				rt_copy(rule->size,rule->tab,rtab);
-				free(rtab);
-				mw_randomise(n,ca,&irng);
-				ca_run(I,n,ca,wca,rule->size,rule->tab,uto);
-				ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
+				rule = rnew;
+				mw_randomise((size_t)order*n,ca,&irng);
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 				printf("exploring : ");
 				fflush(stdout);
 			}
@@ -330,8 +362,7 @@ int sim_xplor(int argc, char* argv[], int info)
 					ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
 				}
 				else {
-					ca_filter(I,n,fca,ca,rule->filt->size,rule->filt->tab);
-					ca_zpixmap_create(I,n,fca,imdata,ppc,imx,imy,filtering);
+					ca_run_zpixmap(I,n,ca,fca,0,NULL,NULL,rule->filt->size,rule->filt->tab,0,1,0.0,NULL,imdata,ppc,imx,filtering);
 				}
 			}
 			else {
@@ -341,9 +372,8 @@ int sim_xplor(int argc, char* argv[], int info)
 				}
 				printf("deleting CA : ");
 				rule = rtl_del(rule);
-				mw_randomise(n,ca,&irng);
-				ca_run(I,n,ca,wca,rule->size,rule->tab,uto);
-				ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
+				mw_randomise((size_t)order*n,ca,&irng);
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 			}
 			print_id(rule,filtering);
 			XPutImage(dis,win,gc,im,0,0,1,1,uimx,uimy);
@@ -362,8 +392,7 @@ int sim_xplor(int argc, char* argv[], int info)
 				}
 				printf("previous filter : ");
 				rule->filt = rule->filt->prev;
-				ca_filter(I,n,fca,ca,rule->filt->size,rule->filt->tab);
-				ca_zpixmap_create(I,n,fca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,fca,0,NULL,NULL,rule->filt->size,rule->filt->tab,0,1,0.0,NULL,imdata,ppc,imx,filtering);
 			}
 			else {
 				if (rule->prev == NULL) {
@@ -372,9 +401,8 @@ int sim_xplor(int argc, char* argv[], int info)
 				}
 				printf("previous CA : ");
 				rule = rule->prev;
-				mw_randomise(n,ca,&irng);
-				ca_run(I,n,ca,wca,rule->size,rule->tab,uto);
-				ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
+				mw_randomise((size_t)order*n,ca,&irng);
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 			}
 			print_id(rule,filtering);
 			XPutImage(dis,win,gc,im,0,0,1,1,uimx,uimy);
@@ -393,8 +421,7 @@ int sim_xplor(int argc, char* argv[], int info)
 				}
 				printf("next filter : ");
 				rule->filt = rule->filt->next;
-				ca_filter(I,n,fca,ca,rule->filt->size,rule->filt->tab);
-				ca_zpixmap_create(I,n,fca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,fca,0,NULL,NULL,rule->filt->size,rule->filt->tab,0,1,0.0,NULL,imdata,ppc,imx,filtering);
 			}
 			else {
 				if (rule->next == NULL) {
@@ -403,9 +430,8 @@ int sim_xplor(int argc, char* argv[], int info)
 				}
 				printf("next CA : ");
 				rule = rule->next;
-				mw_randomise(n,ca,&irng);
-				ca_run(I,n,ca,wca,rule->size,rule->tab,uto);
-				ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
+				mw_randomise((size_t)order*n,ca,&irng);
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 			}
 			print_id(rule,filtering);
 			XPutImage(dis,win,gc,im,0,0,1,1,uimx,uimy);
@@ -424,8 +450,7 @@ int sim_xplor(int argc, char* argv[], int info)
 				}
 				printf("first filter : ");
 				while (rule->filt->prev != NULL) rule->filt = rule->filt->prev; // go to beginning of list
-				ca_filter(I,n,fca,ca,rule->filt->size,rule->filt->tab);
-				ca_zpixmap_create(I,n,fca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,fca,0,NULL,NULL,rule->filt->size,rule->filt->tab,0,1,0.0,NULL,imdata,ppc,imx,filtering);
 			}
 			else {
 				if (rule->prev == NULL) {
@@ -434,9 +459,8 @@ int sim_xplor(int argc, char* argv[], int info)
 				}
 				printf("first CA : ");
 				while (rule->prev != NULL) rule = rule->prev; // go to beginning of list
-				mw_randomise(n,ca,&irng);
-				ca_run(I,n,ca,wca,rule->size,rule->tab,uto);
-				ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
+				mw_randomise((size_t)order*n,ca,&irng);
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 			}
 			print_id(rule,filtering);
 			XPutImage(dis,win,gc,im,0,0,1,1,uimx,uimy);
@@ -455,8 +479,7 @@ int sim_xplor(int argc, char* argv[], int info)
 				}
 				printf("last filter : ");
 				while (rule->filt->next != NULL) rule->filt = rule->filt->next; // go to end of list
-				ca_filter(I,n,fca,ca,rule->filt->size,rule->filt->tab);
-				ca_zpixmap_create(I,n,fca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,fca,0,NULL,NULL,rule->filt->size,rule->filt->tab,0,1,0.0,NULL,imdata,ppc,imx,filtering);
 			}
 			else {
 				if (rule->next == NULL) {
@@ -465,9 +488,8 @@ int sim_xplor(int argc, char* argv[], int info)
 				}
 				printf("last CA : ");
 				while (rule->next != NULL) rule = rule->next; // go to end of list
-				mw_randomise(n,ca,&irng);
-				ca_run(I,n,ca,wca,rule->size,rule->tab,uto);
-				ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
+				mw_randomise((size_t)order*n,ca,&irng);
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 			}
 			print_id(rule,filtering);
 			XPutImage(dis,win,gc,im,0,0,1,1,uimx,uimy);
@@ -513,15 +535,19 @@ int sim_xplor(int argc, char* argv[], int info)
 				}
 				printf("inverting filter : ");
 				rt_invert(rule->filt->size,rule->filt->tab);
-				ca_filter(I,n,fca,ca,rule->filt->size,rule->filt->tab);
-				ca_zpixmap_create(I,n,fca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,fca,0,NULL,NULL,rule->filt->size,rule->filt->tab,0,1,0.0,NULL,imdata,ppc,imx,filtering);
 				flam = 1.0-flam;
 			}
 			else {
 				printf("inverting CA : ");
-				rt_invert(rule->size,rule->tab);
-				ca_run(I,n,ca,wca,rule->size,rule->tab,uto);
-				ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
+				if (rule->tab != NULL) {
+					rt_invert(rule->size,rule->tab);
+					rtl_classify(rule); // mask changes
+				}
+				else {
+					rule->mask ^= rt_tot_bits(rule->size,rule->rtype); // complement output
+				}
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 				rlam = 1.0-rlam;
 			}
 			print_id(rule,filtering);
@@ -532,28 +558,81 @@ int sim_xplor(int argc, char* argv[], int info)
 
 			printf("fast-forward CA\n");
 			fflush(stdout);
-			mw_copy(n,ca,ca+(I-1)*n);
-			ca_run(I,n,ca,wca,rule->size,rule->tab,uto);
+			mw_copy((size_t)order*n,ca,ca+(I-(size_t)order)*n); // last row (rows) as initial state
+
 			if (filtering && rule->filt != NULL) {
-				ca_filter(I,n,fca,ca,rule->filt->size,rule->filt->tab);
-				ca_zpixmap_create(I,n,fca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,fca,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),rule->filt->size,rule->filt->tab,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 			}
 			else {
-				ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
+			}
+			XPutImage(dis,win,gc,im,0,0,1,1,uimx,uimy);
+			break;
+
+		case 'o': // toggle first/second-order CA
+
+			order = 3-order;
+			printf("%s-order CA : re-initialise CA\n",order == 2 ? "second" : "first");
+			mw_randomise((size_t)order*n,ca,&irng);
+			if (filtering && rule->filt != NULL) {
+				ca_run_zpixmap(I,n,ca,fca,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),rule->filt->size,rule->filt->tab,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
+			}
+			else {
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
+			}
+			XPutImage(dis,win,gc,im,0,0,1,1,uimx,uimy);
+			break;
+
+		case 'b': // reverse time (second-order CA)
+
+			if (order != 2) {
+				printf("reverse time : not a second-order CA!\n");
+				break;
+			}
+			printf("reverse time\n");
+			fflush(stdout);
+			ca_rewind2(I,n,ca,rule->size,uto); // last two rows, reversed, as initial state
+			if (filtering && rule->filt != NULL) {
+				ca_run_zpixmap(I,n,ca,fca,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),rule->filt->size,rule->filt->tab,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
+			}
+			else {
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
+			}
+			XPutImage(dis,win,gc,im,0,0,1,1,uimx,uimy);
+			break;
+
+		case 'z': // set CA noise and rerun
+
+			{
+				printf("enter CA noise (output flip probability) : "); // prompt for noise
+				fflush(stdout);
+				double newnoise;
+				const int ret = scanf("%lf",&newnoise);
+				printf("%s : ",modestr);
+				if (ret != 1 || newnoise < 0.0 || newnoise > 1.0) {
+					printf("bad noise level\n");
+					break;
+				}
+				noise = newnoise;
+				printf("CA noise = %g\n",noise);
+			}
+			if (filtering && rule->filt != NULL) {
+				ca_run_zpixmap(I,n,ca,fca,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),rule->filt->size,rule->filt->tab,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
+			}
+			else {
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 			}
 			XPutImage(dis,win,gc,im,0,0,1,1,uimx,uimy);
 			break;
 
 		case 'i': // re-initialise and rerun
 			printf("re-initialise CA\n");
-			mw_randomise(n,ca,&irng);
-			ca_run(I,n,ca,wca,rule->size,rule->tab,uto);
+			mw_randomise((size_t)order*n,ca,&irng);
 			if (filtering && rule->filt != NULL) {
-				ca_filter(I,n,fca,ca,rule->filt->size,rule->filt->tab);
-				ca_zpixmap_create(I,n,fca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,fca,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),rule->filt->size,rule->filt->tab,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 			}
 			else {
-				ca_zpixmap_create(I,n,ca,imdata,ppc,imx,imy,filtering);
+				ca_run_zpixmap(I,n,ca,NULL,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),0,NULL,uto,order,noise,&nrng,imdata,ppc,imx,filtering);
 			}
 			XPutImage(dis,win,gc,im,0,0,1,1,uimx,uimy);
 			break;
@@ -561,7 +640,8 @@ int sim_xplor(int argc, char* argv[], int info)
 		case 's': // save CA/filter rule id to file
 
 			printf("saving CA ");
-			rt_fprint_id(rule->size,rule->tab,ortfs);
+			if (rule->tab != NULL) rt_fprint_id(rule->size,rule->tab,ortfs);
+			else rt_tot_fprint_id(rule->size,rule->rtype,rule->mask,ortfs);
 			if (filtering && rule->filt != NULL) {
 				printf("and filter rule ids\n");
 				fputc(' ',ortfs);
@@ -596,31 +676,90 @@ int sim_xplor(int argc, char* argv[], int info)
 
 		case 'p': // calculate CA period
 
-			caana_period(n,I,ca,rule,prff,pmax);
+			if (table_free(rule)) break;
+			caana_period(n,I,ca,rule,prff,pmax,order,uto);
+			break;
+
+		case 'P': // period census over random initial conditions
+
+			printf("period census (%zu initial conditions) ...",pcics);
+			fflush(stdout);
+			if (table_free(rule)) break;
+			putchar('\n');
+			pcen_t* const pcen = caana_period_census(n,rule->size,rule->tab,pcics,pmax,iseed,pcthr,pcics/8,0.01,NULL,order);
+			caana_pcen_print(pcen,10);
+			caana_pcen_free(pcen);
+			break;
+
+		case 'C': // attractor/basin census of CA on rings
+
+			printf("attractor/basin census (ring length = %d) ...",cenm);
+			fflush(stdout);
+			if (table_free(rule)) break;
+			putchar('\n');
+			if (order == 2) {
+				printf("first-order CA only!\n");
+				break;
+			}
+			if (rule->size > cenm || 2*cenm > WBITS) {
+				printf("bad ring length (must be at least CA rule size and at most %d)\n",WBITS/2);
+				break;
+			}
+			if (rule->size > CENSUS_MAXB) {
+				printf("CA rule too big (maximum size %d)\n",CENSUS_MAXB);
+				break;
+			}
+			census_t* const cen = census_run(cenm,rule->size,rule->tab,centhr);
+			census_print(cen,10);
+			{
+				const size_t cfnlen = strlen(gpdir)+14;
+				char cfname[cfnlen];
+				snprintf(cfname,cfnlen,"%s/cacensus.bin",gpdir);
+				if (census_write(cen,rule->size,rule->tab,cfname)) printf("census written to '%s'\n",cfname);
+				else printf("failed to write census file '%s'\n",cfname);
+			}
+			census_free(cen);
+			break;
+
+		case 'y': // damage spreading and Lyapunov exponent of CA
+
+			printf("damage spreading (%zu runs, %zu generations) ... ",dmruns,I);
+			fflush(stdout);
+			if (order == 2) {
+				printf("first-order CA only!\n");
+				break;
+			}
+			{
+				dmg_t* const dmg = dmg_run(n,rule->size,rtl_ktab(rule),tune_kernel(rule->size,n,rule->tab,rule->rtype,kernel,0),I,dmruns,dmpflip,iseed);
+				dmg_print(dmg);
+				dmg_free(dmg);
+			}
 			break;
 
 		case 'E': // calculate entropy of CA rule
 
 			printf("calculating CA/filter entropy");
+			if (table_free(rule)) break;
 			const size_t Se = POW2(emmax);
 			TEST_RAM(Se*sizeof(uint64_t));
 			uint64_t* const bine = malloc(Se*sizeof(uint64_t));
 			TEST_ALLOC(bine);
 			for (int m=0; m<hlen; ++m) H[m] = NAN;
-			for (int m=rule->size; m<=emmax; ++m) H[m] = rt_entro(rule->size,rule->tab,m,eiff,bine)/(double)m;
+			const int mHe = rt_entro_curve(rule->size,rule->tab,rule->size,emmax/order,eiff,order,ctol,tbud,bine,H); // second-order: same number of states
+			int mHfe = 0;
 			if (filtering && rule->filt != NULL) {
 				for (int m=0; m<hlen; ++m) Hf[m] = NAN;
-				for (int m=rule->filt->size; m<=emmax; ++m) Hf[m] = rt_entro(rule->filt->size,rule->filt->tab,m,eiff,bine)/(double)m;
+				mHfe = rt_entro_curve(rule->filt->size,rule->filt->tab,rule->filt->size,emmax,eiff,1,ctol,tbud,bine,Hf);
 			}
 			free(bine);
 			char gpename[] = "caentro";
 			FILE* const gped = gp_dopen(gpename,gpdir);
 			if (filtering && rule->filt != NULL) {
-				printf(" rule entropy = %8.6f, filter entropy = %8.6f\n",H[emmax],Hf[emmax]);
+				printf(" rule entropy = %8.6f (m = %d), filter entropy = %8.6f (m = %d)\n",H[mHe],mHe,Hf[mHfe],mHfe);
 				for (int m=0; m<hlen; ++m) fprintf(gped,"%d\t%g\t%g\n",m,H[m],Hf[m]);
 			}
 			else {
-				printf(" rule entropy = %8.6f\n",H[emmax]);
+				printf(" rule entropy = %8.6f (m = %d)\n",H[mHe],mHe);
 				for (int m=0; m<hlen; ++m) fprintf(gped,"%d\t%g\n",m,H[m]);
 			}
 			if (fclose(gped) == -1) PEEXIT("failed to close Gnuplot data file\n");
@@ -661,6 +800,7 @@ int sim_xplor(int argc, char* argv[], int info)
 				break;
 			}
 			printf("calculating CA/filter dynamical dependence");
+			if (table_free(rule)) break;
 			const size_t St = POW2(emmax);
 			TEST_RAM(St*sizeof(uint64_t));
 			uint64_t* const bint = malloc(St*sizeof(uint64_t));
@@ -670,15 +810,15 @@ int sim_xplor(int argc, char* argv[], int info)
 			uint64_t* const bin2t = malloc(S2t*sizeof(uint64_t));
 			TEST_ALLOC(bin2t);
 			for (int m=0; m<hlen; ++m) H[m] = NAN;
-			for (int m=rule->size; m<=emmax; ++m) H[m] = rt_entro(rule->size,rule->tab,m,eiff,bint)/(double)m;
+			const int mHt = rt_entro_curve(rule->size,rule->tab,rule->size,emmax/order,eiff,order,ctol,tbud,bint,H); // second-order: same number of states
 			for (int m=0; m<hlen; ++m) Hf[m] = NAN;
-			for (int m=rule->filt->size; m<=emmax; ++m) Hf[m] = rt_entro(rule->filt->size,rule->filt->tab,m,eiff,bint)/(double)m;
+			const int mHft = rt_entro_curve(rule->filt->size,rule->filt->tab,rule->filt->size,emmax,eiff,1,ctol,tbud,bint,Hf);
 			const int mmin = rule->size > rule->filt->size ? rule->size : rule->filt->size;
 			for (int m=0; m<hlen; ++m) Tf[m] = NAN;
-			for (int m=mmin; m<=tmmax; ++m) Tf[m] = rt_dd(rule->size,rule->tab,rule->filt->size,rule->filt->tab,m,tiff,tlag,bint,bin2t)/(double)m;
+			const int mTf = rt_dd_curve(rule->size,rule->tab,rule->filt->size,rule->filt->tab,mmin,tmmax/order,tiff,tlag,order,ctol,tbud,bint,bin2t,Tf); // likewise
 			free(bin2t);
 			free(bint);
-			printf(" rule entropy = %8.6f, filter entropy = %8.6f, DD = %8.6f\n",H[emmax],Hf[emmax],Tf[tmmax]);
+			printf(" rule entropy = %8.6f (m = %d), filter entropy = %8.6f (m = %d), DD = %8.6f (m = %d)\n",H[mHt],mHt,Hf[mHft],mHft,Tf[mTf],mTf);
 			char gptname[] = "cadd";
 			FILE* const gptd = gp_dopen(gptname,gpdir);
 			for (int m=0; m<hlen; ++m) fprintf(gptd,"%d\t%g\t%g\t%g\n",m,H[m],Hf[m],Tf[m]);
@@ -699,6 +839,53 @@ int sim_xplor(int argc, char* argv[], int info)
 			gp_fplot(gptname,gpdir);
 			break;
 
+		case 'L': // exact test for zero dynamical dependence of CA/filter rules
+
+			if (!filtering) {
+				printf("not in filtering mode!\n");
+				break;
+			}
+			if (rule->filt == NULL) {
+				printf("no filter!\n");
+				break;
+			}
+			printf("testing CA/filter lumpability ...");
+			fflush(stdout);
+			if (table_free(rule)) break;
+			putchar(' ');
+			if (order == 2) {
+				printf("first-order CA only!\n");
+				break;
+			}
+			const size_t Sl = POW2(lmmax);
+			TEST_RAM(Sl*sizeof(word_t));
+			word_t* const succ = malloc(Sl*sizeof(word_t));
+			TEST_ALLOC(succ);
+			const int lmin = rule->size > rule->filt->size ? rule->size : rule->filt->size;
+			const int lmf = rt_lumpable_mmax(rule->size,rule->tab,rule->filt->size,rule->filt->tab,lmin,lmmax,tiff,tlag,succ);
+			free(succ);
+			if (lmf > 0) printf("dependent (DD > 0) at length %d\n",lmf);
+			else printf("independent (DD = 0) at all lengths %d - %d\n",lmin,lmmax);
+			break;
+
+		case 'T': // calculate topological entropy of CA/filter rule images
+
+			printf("calculating CA/filter topological entropy ...");
+			fflush(stdout);
+			if (rule->size > 7) {
+				printf(" CA rule too large (size must be at most 7)\n");
+				break;
+			}
+			size_t ndfa, nmin;
+			const double Ht = rt_topent(rule->size,rule->tab,dfamax,&ndfa,&nmin);
+			if (isnan(Ht)) printf(" rule: too many automaton states"); else printf(" rule = %8.6f (DFA states = %zu, minimal = %zu)",Ht,ndfa,nmin);
+			if (filtering && rule->filt != NULL && rule->filt->size <= 7) {
+				const double Htf = rt_topent(rule->filt->size,rule->filt->tab,dfamax,&ndfa,&nmin);
+				if (isnan(Htf)) printf(", filter: too many automaton states"); else printf(", filter = %8.6f (DFA states = %zu, minimal = %zu)",Htf,ndfa,nmin);
+			}
+			putchar('\n');
+			break;
+
 		case 'S': // calculate CA spatial discrete power spectrum
 
 			caana_dps(n,I,ca,fca,filtering,costab,gpipw);
@@ -743,7 +930,6 @@ int sim_xplor(int argc, char* argv[], int info)
 
 	rtl_free(rule);
 
-	free(wca);
 	free(fca);
 	free(ca);
 
@@ -753,8 +939,24 @@ int sim_xplor(int argc, char* argv[], int info)
 void print_id(const rtl_t* const rule, const int filtering)
 {
 	printf("CA id = ");
-	rt_print_id(rule->size,rule->tab);
-	printf(", lambda = %6.4f",rt_lambda(rule->size,rule->tab));
+	if (rule->tab == NULL) {
+		rt_tot_print_id(rule->size,rule->rtype,rule->mask);
+		printf(", lambda = %6.4f",rt_tot_lambda(rule->size,rule->rtype,rule->mask));
+	}
+	else {
+		rt_print_id(rule->size,rule->tab);
+		if (rule->rtype != RT_TABLE) {
+			printf(" = ");
+			rt_tot_print_id(rule->size,rule->rtype,rule->mask);
+		}
+		printf(", lambda = %6.4f",rt_lambda(rule->size,rule->tab));
+	}
+	const rtl_t* const req = rule->tab != NULL ? rtl_equiv(rule,rule->size,rule->tab) : rule; // first equivalent rule in list
+	if (req != rule) {
+		int k = 1;
+		for (const rtl_t* r = req; r->prev != NULL; r = r->prev) ++k;
+		printf(" (equivalent to CA %d in list)",k);
+	}
 	if (rule->filt != NULL && filtering) {
 		printf(" : filter id = ");
 		rt_print_id(rule->filt->size,rule->filt->tab);
@@ -762,3 +964,20 @@ void print_id(const rtl_t* const rule, const int filtering)
 	}
 	putchar('\n');
 }
+
+static rtl_t* random_rule(rtl_t* rule, const int size, const rtype_t rtype, const double lam, mt_t* const prng)
+{
+	// add random CA rule of given type, classified (table-free if too big for a table)
+	if (rtype != RT_TABLE) return rtl_add_tot(rule,size,rtype,rt_tot_random(size,rtype,lam,prng));
+	rule = rtl_add(rule,size);
+	rt_randomise(size,rule->tab,lam,prng);
+	rtl_classify(rule);
+	return rule;
+}
+
+static int table_free(const rtl_t* const rule)
+{
+	if (rule->tab != NULL) return 0;
+	printf(" table-free CA rule (size > %d) : not available\n",RT_TOTTABMAXB);
+	return 1;
+}
@@ -0,0 +1,113 @@
+#include "bdd.h"
+#include "rtab.h"
+#include "clap.h"
+
+// Rule decision diagrams against rule tables: round trip, lambda, symmetries
+// and stepping for random rules; diagrams built from (outer-)totalistic masks
+// against the expanded tables and, beyond table sizes, the adder kernels.
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(maxB,    int,     12,           "largest table size");
+	CLAP_CARG(nrules,  int,     5,            "random rules per size");
+	CLAP_CARG(n,       size_t,  4,            "ring length (words)");
+	CLAP_CARG(rseed,   ulong,   1,            "CA rule random seed");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	mt_t rng;
+	mt_seed(&rng,rseed);
+	int nfail = 0;
+	word_t* const w  = mw_alloc(n);
+	word_t* const w1 = mw_alloc(n);
+	word_t* const w2 = mw_alloc(n);
+
+	// random (and biased, for constant subtables) tables
+
+	for (int B=1;B<=maxB;++B) for (int k=0;k<nrules;++k) {
+		word_t* const tab  = rt_alloc(B);
+		word_t* const stab = rt_alloc(B);
+		rt_randomise(B,tab,k == 0 ? 0.05 : 0.5,&rng);
+		rbdd_t* const rb = rb_from_table(B,tab);
+		word_t* const tab1 = rb_to_table(rb);
+		if (!mw_equal(rt_nwords(B),tab,tab1))                {printf("B = %2d : round trip : FAIL\n",B); ++nfail;}
+		size_t nbad = 0;
+		for (word_t r=0;r<POW2(B);++r) if (rb_eval(rb,r) != RTBIT(tab,r)) ++nbad;
+		if (nbad > 0)                                        {printf("B = %2d : rb_eval : FAIL\n",B); ++nfail;}
+		if (fabs(rb_lambda(rb)-rt_lambda(B,tab)) > 1e-15)    {printf("B = %2d : rb_lambda : FAIL\n",B); ++nfail;}
+		for (int g=1;g<4;++g) {
+			rbdd_t* const rbs = rb_symmetry(rb,g);
+			word_t* const tabs = rb_to_table(rbs);
+			rt_symmetry(B,stab,tab,g);
+			if (!mw_equal(rt_nwords(B),stab,tabs))           {printf("B = %2d : rb_symmetry %d : FAIL\n",B,g); ++nfail;}
+			free(tabs);
+			rb_free(rbs);
+		}
+		rbdd_t* crb;
+		const int g = rb_canonical(rb,&crb);
+		word_t* const ctab = rb_to_table(crb);
+		if (g != rt_canonical(B,tab,stab) || !mw_equal(rt_nwords(B),stab,ctab)) {printf("B = %2d : rb_canonical : FAIL\n",B); ++nfail;}
+		free(ctab);
+		rb_free(crb);
+		mw_randomise(n,w,&rng);
+		mw_copy(n,w1,w);
+		mw_copy(n,w2,w);
+		mw_run(7,n,w1,B,tab);
+		rb_run(7,n,w2,rb);
+		if (!mw_equal(n,w1,w2))                              {printf("B = %2d : rb_run : FAIL\n",B); ++nfail;}
+		free(tab1);
+		rb_free(rb);
+		free(stab);
+		free(tab);
+	}
+
+	// (outer-)totalistic rules without a table: against the table where there is one,
+	// else against the adder kernels (bit-sliced and streamed evaluation both exercised)
+
+	for (int t=0;t<2;++t) {
+		const rtype_t rtype = t == 0 ? RT_TOTAL : RT_OUTER;
+		const int maxtB = t == 0 ? WTOTMAXB : WOUTMAXB;
+		for (int B=1;B<=maxtB;++B) for (int k=0;k<nrules;++k) {
+			const word_t mask = rt_tot_random(B,rtype,0.5,&rng);
+			rbdd_t* const rb = rb_from_totalistic(B,rtype,mask);
+			if (B <= maxB) {
+				word_t* const tab = rt_alloc(B);
+				rt_from_totalistic(B,tab,rtype,mask);
+				word_t* const tab1 = rb_to_table(rb);
+				if (!mw_equal(rt_nwords(B),tab,tab1)) {printf("%c%d : table : FAIL\n",t == 0 ? 'T' : 'O',B); ++nfail;}
+				free(tab1);
+				free(tab);
+			}
+			mw_randomise(n,w,&rng);
+			mw_copy(n,w1,w);
+			mw_copy(n,w2,w);
+			const mw_filter_t tkern = rt_tot_kernel(rtype);
+			for (int i=0;i<3;++i) {tkern(n,w,w1,B,&mask); mw_copy(n,w1,w);}
+			rb_run(3,n,w2,rb);
+			if (!mw_equal(n,w1,w2)) {printf("%c%d : rb_run : FAIL\n",t == 0 ? 'T' : 'O',B); ++nfail;}
+			rb_free(rb);
+		}
+	}
+
+	// ids beyond the table limit
+
+	int size;
+	rbdd_t* const rb = rb_sread_id("T40:1234567890",&size);
+	if (rb == NULL || size != 40 || rb_eval(rb,POW2(40)-1) != 0 || rb_eval(rb,POW2(4)-1) != 1) {puts("rb_sread_id T40 : FAIL"); ++nfail;}
+	rb_free(rb);
+	if (rb_sread_id("T64:1",&size) != NULL || size != -1) {puts("rb_sread_id T64 : FAIL"); ++nfail;}
+	if (rb_sread_id("O3:FFF",&size) != NULL || size != -2) {puts("rb_sread_id O3 : FAIL"); ++nfail;}
+
+	free(w2);
+	free(w1);
+	free(w);
+
+	printf("bdd: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,115 @@
+#include "census.h"
+#include "rtab.h"
+#include "clap.h"
+
+// Attractor/basin census (census_run) against a brute-force walk of the
+// functional graph on all 2^m ring configurations, for random rules and for
+// elementary rules with many long cycles (shift, rule 150), on 1, nthreads
+// and 8 threads.
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(m,       int,     13,           "ring length");
+	CLAP_CARG(nrules,  int,     20,           "number of random rules");
+	CLAP_CARG(nthreads,int,     3,            "number of threads");
+	CLAP_CARG(rseed,   ulong,   1,            "CA rule random seed");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	const size_t S = POW2(m);
+	word_t*   const f     = malloc(S*sizeof(word_t));
+	TEST_ALLOC(f);
+	uint64_t* const depth = malloc(S*sizeof(uint64_t));
+	TEST_ALLOC(depth);
+	word_t*   const rep   = malloc(S*sizeof(word_t));
+	TEST_ALLOC(rep);
+	uint64_t* const indeg = malloc(S*sizeof(uint64_t));
+	TEST_ALLOC(indeg);
+	uint64_t* const basin = malloc(S*sizeof(uint64_t));
+	TEST_ALLOC(basin);
+
+	mt_t rng;
+	mt_seed(&rng,rseed);
+	int nfail = 0;
+	const word_t ELEM[] = {170,150}; // shift, rule 150
+	const int nelem = (int)(sizeof(ELEM)/sizeof(ELEM[0]));
+	for (int k=0;k<nrules+nelem;++k) {
+		const int B = k < nrules ? 3+k%4 : 3;
+		word_t* const tab = rt_alloc(B);
+		if (k < nrules) rt_randomise(B,tab,k%2 ? 0.5 : 0.3,&rng);
+		else tab[0] = ELEM[k-nrules];
+
+		// brute force: in-degrees, then for each configuration the cycle it
+		// falls into (smallest configuration on it) and its transient length
+
+		memset(indeg,0,S*sizeof(uint64_t));
+		memset(basin,0,S*sizeof(uint64_t));
+		for (word_t x=0;x<S;++x) ++indeg[f[x] = wd_filter(m,x,B,tab)];
+		uint64_t ngoe = 0, maxd = 0;
+		for (word_t x=0;x<S;++x) {
+			if (indeg[x] == 0) ++ngoe;
+			word_t y = x, z = x; // Floyd: find a configuration on the cycle
+			do {y = f[y]; z = f[f[z]];} while (y != z);
+			word_t r = y;
+			uint64_t len = 0;
+			do {if (z < r) r = z; z = f[z]; ++len;} while (z != y);
+			uint64_t d = 0; // transient length: first configuration on the cycle
+			for (y = x;;y = f[y], ++d) {
+				word_t c = f[y];
+				int on = y == r;
+				for (uint64_t i=0;i<len && !on;++i, c = f[c]) on = c == y;
+				if (on) break;
+			}
+			rep[x] = r;
+			depth[x] = d;
+			++basin[r];
+			if (d > maxd) maxd = d;
+		}
+
+		size_t ncycles = 0;
+		for (word_t x=0;x<S;++x) if (rep[x] == x) ++ncycles;
+		const int NT[] = {1,nthreads,8};
+		for (int j=0;j<3;++j) {
+			census_t* const cen = census_run(m,B,tab,NT[j]);
+			int ok = cen->ngoe == ngoe && cen->ncycles == ncycles && cen->ndepths == maxd+1;
+			uint64_t tot = 0;
+			for (size_t c=0;c<cen->ncycles && ok;++c) {
+				const cycle_t* const cy = &cen->cycles[c];
+				ok = rep[cy->rep] == cy->rep && basin[cy->rep] == cy->basin;
+				uint64_t cd = 0;
+				for (word_t x=0;x<S;++x) if (rep[x] == cy->rep && depth[x] > cd) cd = depth[x];
+				ok = ok && cd == cy->depth;
+				tot += cy->basin;
+			}
+			ok = ok && tot == S;
+			for (size_t d=0;d<cen->ndepths && ok;++d) {
+				uint64_t nd = 0;
+				for (word_t x=0;x<S;++x) if (depth[x] == d) ++nd;
+				ok = nd == cen->dhist[d];
+			}
+			if (!ok) {
+				printf("rule id = ");
+				rt_print_id(B,tab);
+				printf(" (size %d), %d threads : FAIL\n",B,NT[j]);
+				++nfail;
+			}
+			census_free(cen);
+		}
+		free(tab);
+	}
+
+	free(basin);
+	free(indeg);
+	free(rep);
+	free(depth);
+	free(f);
+
+	printf("census: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,81 @@
+#include "ddinc.h"
+#include "rtab.h"
+#include "clap.h"
+
+// Incremental dynamical dependence (ddi_t) against rt_dd/rt_entro recomputed
+// from scratch, over long random sequences of filter and rule entry flips: on
+// the incremental rule path (iff = 0, ilag = 1, where rule flips are applied
+// through entry lists and mark the filter lists stale) and the rebuild path
+// (advance or lag, where rule flips rebuild everything).
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(m,       int,     10,           "sequence length");
+	CLAP_CARG(rsiz,    int,     5,            "CA rule size");
+	CLAP_CARG(fsiz,    int,     3,            "filter rule size");
+	CLAP_CARG(nflips,  int,     100,          "number of flips per case");
+	CLAP_CARG(rseed,   ulong,   1,            "random seed");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	mt_t rng;
+	mt_seed(&rng,rseed);
+	int nfail = 0;
+	const double tol = 1e-10;
+	const size_t S = POW2(m);
+	uint64_t* const bin  = malloc(S*sizeof(uint64_t));
+	TEST_ALLOC(bin);
+	uint64_t* const bin2 = malloc(S*S*sizeof(uint64_t));
+	TEST_ALLOC(bin2);
+	word_t* const rtab = rt_alloc(rsiz);
+	word_t* const ftab = rt_alloc(fsiz);
+
+	const struct {int iff; int ilag;} C[] = {{0,1},{1,1},{0,2}}; // incremental, then rebuild path
+	for (size_t c=0;c<sizeof(C)/sizeof(C[0]);++c) {
+		const int iff = C[c].iff, ilag = C[c].ilag;
+		ASSERT(iff*(rsiz-1)+fsiz <= m,"sequence too short for composed filter");
+		rt_randomise(rsiz,rtab,0.5,&rng);
+		rt_randomise(fsiz,ftab,0.5,&rng);
+		ddi_t* const ddi = ddi_alloc(rsiz,rtab,fsiz,ftab,m,iff,ilag);
+		int nbad = 0;
+		for (int k=0;k<=nflips;++k) {
+			if (k > 0) { // flip a random filter or rule entry (first check is after construction)
+				if (mt_rand(&rng) < 0.5) {
+					const size_t r = RANDI(size_t,POW2(fsiz),&rng);
+					RTFLIP(ftab,r);
+					ddi_flip_filt(ddi,r);
+				}
+				else {
+					const size_t r = RANDI(size_t,POW2(rsiz),&rng);
+					RTFLIP(rtab,r);
+					ddi_flip_rule(ddi,r);
+				}
+			}
+			const double dd = rt_dd(rsiz,rtab,fsiz,ftab,m,iff,ilag,bin,bin2);
+			int usiz; // filtered state U = filter(CA^iff(x)) as a single rule
+			word_t* const utab = rt_compose_filt(rsiz,rtab,iff,fsiz,ftab,&usiz);
+			const double H = rt_entro(usiz,utab,m,1,bin);
+			free(utab);
+			if (fabs(ddi_dd(ddi)-dd) > tol || fabs(ddi_entro(ddi)-H) > tol) {
+				if (nbad == 0) printf("iff = %d, ilag = %d, flip %d : DD = %.15f (%.15f), H = %.15f (%.15f) : FAIL\n",iff,ilag,k,ddi_dd(ddi),dd,ddi_entro(ddi),H);
+				++nbad;
+			}
+		}
+		if (nbad > 0) ++nfail;
+		ddi_free(ddi);
+	}
+
+	free(ftab);
+	free(rtab);
+	free(bin2);
+	free(bin);
+
+	printf("ddinc: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,63 @@
+#include "dmg.h"
+#include "rtab.h"
+#include "clap.h"
+
+// Damage spreading on rules with known answers: the linear elementary rules 90
+// and 150 (Lyapunov exponents ln 2 and ln 3, fronts at light speed), the
+// identity (exponent 0, damage frozen) and the null rule (damage dies at once).
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(n,       size_t,  4,            "row length (words)");
+	CLAP_CARG(T,       size_t,  100,          "generations (< half the row length)");
+	CLAP_CARG(nruns,   size_t,  5,            "runs");
+	CLAP_CARG(iseed,   ulong,   1,            "initial rows random seed");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	int nfail = 0;
+	const double N = (double)(n*WBITS);
+	const double tol = 1e-12;
+
+	// elementary rules (B = 3) as tables: output for window r = (left,centre,right) bits 0,1,2
+	const struct {const char* name; word_t rule; double lyap; double v; double psurv;} R[] = {
+		{"rule 90",  90,  log(2.0), 1.0, 1.0},
+		{"rule 150", 150, log(3.0), 1.0, 1.0},
+		{"identity", 204, 0.0,      0.0, 1.0},
+		{"null",     0,   -INFINITY,NAN, 0.0},
+	};
+	for (size_t k=0;k<sizeof(R)/sizeof(R[0]);++k) {
+		word_t tab[1] = {R[k].rule};
+		dmg_t* const dmg = dmg_run(n,3,tab,NULL,T,nruns,0.0,iseed);
+		const int dead = R[k].psurv == 0.0;
+		if (dead ? dmg->lyap != -INFINITY || dmg->plyap != 0.0 : fabs(dmg->lyap-R[k].lyap) > tol || dmg->plyap != 1.0) {printf("%s : lambda = %g : FAIL\n",R[k].name,dmg->lyap); ++nfail;}
+		if (dmg->psurv != R[k].psurv || dmg->alive[T] != R[k].psurv || dmg->alive[0] != 1.0) {printf("%s : survival : FAIL\n",R[k].name); ++nfail;}
+		if (dead ? !isnan(dmg->vleft) || !isnan(dmg->vright) : fabs(dmg->vleft-R[k].v) > tol || fabs(dmg->vright-R[k].v) > tol) {printf("%s : velocities %g, %g : FAIL\n",R[k].name,dmg->vleft,dmg->vright); ++nfail;}
+		if (fabs(dmg->ham[0]-1.0/N) > tol) {printf("%s : initial damage : FAIL\n",R[k].name); ++nfail;}
+		if (k == 2 && fabs(dmg->ham[T]-1.0/N) > tol) {printf("%s : damage not frozen : FAIL\n",R[k].name); ++nfail;}
+		dmg_free(dmg);
+	}
+
+	// rule 90: damage after 2^m steps is exactly two cells (Pascal's triangle mod 2),
+	// whatever the initial row; rule 150 stepped by its totalistic (T3:A) table kernel
+	// gives the same results as the default kernel
+
+	const word_t tab90[1] = {90}, tab150[1] = {150};
+	dmg_t* const dmg = dmg_run(n,3,tab90,NULL,T,nruns,0.0,iseed);
+	for (size_t t=1;t<=T;t*=2) if (fabs(dmg->ham[t]-2.0/N) > tol) {printf("rule 90 : damage at t = %zu : FAIL\n",t); ++nfail;}
+	dmg_free(dmg);
+	dmg_t* const dmg1 = dmg_run(n,3,tab150,NULL,           T,nruns,0.0,iseed);
+	dmg_t* const dmg2 = dmg_run(n,3,tab150,mw_filter_total,T,nruns,0.0,iseed);
+	if (memcmp(dmg1->ham,dmg2->ham,2*(T+1)*sizeof(double)) != 0 || dmg1->lyap != dmg2->lyap) {puts("rule 150 : kernel : FAIL"); ++nfail;}
+	dmg_free(dmg2);
+	dmg_free(dmg1);
+
+	printf("dmg: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
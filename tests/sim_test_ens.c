@@ -0,0 +1,118 @@
+#include "ens.h"
+#include "rtab.h"
+#include "clap.h"
+
+// Ensemble statistics (ens_run) against direct two-pass means and variances
+// over the members, and invariance under the number of threads and chunk size.
+
+static void ens_direct(const size_t E, const size_t I, const size_t n, const int B, const word_t* const tab, const int K, const double p0, const ulong iseed, double* const mean, double* const var)
+{
+	// observables ENS_DENS|ENS_BLOCK|ENS_HAMM for every member and generation, then moments
+	const size_t N = n*WBITS, nbk = POW2(K), nobs = 1+nbk+1;
+	double* const x = calloc(E*I*nobs,sizeof(double));
+	TEST_ALLOC(x);
+	word_t* const w  = mw_alloc(E*n);
+	word_t* const w1 = mw_alloc(n);
+	for (size_t e=0;e<E;++e) {
+		xr_t irng;
+		xr_seed(&irng,iseed+e);
+		mw_randomiseb_xr(n,w+e*n,p0,&irng);
+	}
+	for (size_t t=0;t<I;++t) {
+		for (size_t e=0;e<E;++e) {
+			const word_t* const we = w+e*n;
+			const word_t* const wp = e%2 == 1 ? we-n : we; // pair partner
+			double* const xe = x+(e*I+t)*nobs;
+			for (size_t i=0;i<N;++i) {
+				xe[0] += (double)BITON(we[i/WBITS],i%WBITS);
+				size_t b = 0;
+				for (int j=0;j<K;++j) {const size_t c = (i+(size_t)j)%N; b |= (size_t)BITON(we[c/WBITS],c%WBITS)<<j;}
+				xe[1+b] += 1.0;
+				if (e%2 == 1) xe[1+nbk] += (double)(BITON(we[i/WBITS],i%WBITS)^BITON(wp[i/WBITS],i%WBITS));
+			}
+			for (size_t j=0;j<nobs;++j) xe[j] /= (double)N;
+		}
+		for (size_t e=0;e<E;++e) {mw_filter(n,w1,w+e*n,B,tab); mw_copy(n,w+e*n,w1);}
+	}
+	for (size_t t=0;t<I;++t) for (size_t j=0;j<nobs;++j) {
+		const int hamm = j == nobs-1;
+		const size_t e0 = hamm ? 1 : 0, de = hamm ? 2 : 1, ne = hamm ? E/2 : E;
+		double s = 0.0, s2 = 0.0;
+		for (size_t e=e0;e<E;e+=de) s += x[(e*I+t)*nobs+j];
+		const double m = s/(double)ne;
+		for (size_t e=e0;e<E;e+=de) {const double d = x[(e*I+t)*nobs+j]-m; s2 += d*d;}
+		mean[t*nobs+j] = m;
+		var [t*nobs+j] = s2/(double)(ne-1);
+	}
+	free(w1);
+	free(w);
+	free(x);
+}
+
+static int ens_compare(const char* const what, const size_t I, const size_t nobs, const double* const mean, const double* const var, const ens_t* const ens, const double tol)
+{
+	double dmax = 0.0;
+	for (size_t k=0;k<I*nobs;++k) {
+		dmax = fmax(dmax,fabs(ens->mean[k]-mean[k]));
+		dmax = fmax(dmax,fabs(ens->var [k]-var [k]));
+	}
+	if (dmax <= tol) return 0;
+	printf("%s : max deviation %g : FAIL\n",what,dmax);
+	return 1;
+}
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(B,       int,     5,            "rule size");
+	CLAP_CARG(E,       size_t,  38,           "ensemble size");
+	CLAP_CARG(I,       size_t,  20,           "generations");
+	CLAP_CARG(n,       size_t,  3,            "row length (words)");
+	CLAP_CARG(K,       int,     3,            "block length");
+	CLAP_CARG(p0,      double,  0.3,          "initial density");
+	CLAP_CARG(iseed,   ulong,   17,           "initial rows random seed");
+	CLAP_CARG(rseed,   ulong,   1,            "CA rule random seed");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	mt_t rng;
+	mt_seed(&rng,rseed);
+	int nfail = 0;
+	word_t* const tab = rt_alloc(B);
+	rt_randomise(B,tab,0.5,&rng);
+	const int obs = ENS_DENS|ENS_BLOCK|ENS_HAMM;
+	const size_t nobs = 1+POW2(K)+1;
+	double* const mean = malloc(I*nobs*sizeof(double));
+	TEST_ALLOC(mean);
+	double* const var  = malloc(I*nobs*sizeof(double));
+	TEST_ALLOC(var);
+	ens_direct(E,I,n,B,tab,K,p0,iseed,mean,var);
+
+	// single thread, then uneven chunks over several threads (statistics combined)
+
+	ens_t* const ens1 = ens_run(E,I,n,B,tab,NULL,obs,K,p0,iseed,1,E);
+	if (ens1->nobs != nobs || ens1->cnt[0] != E || ens1->cnt[nobs-1] != E/2) {puts("ens_run : layout : FAIL"); ++nfail;}
+	else nfail += ens_compare("ens_run (1 thread)",I,nobs,mean,var,ens1,1e-12);
+	const int    T[] = {2,3,8};
+	const size_t S[] = {2,4,6};
+	for (size_t k=0;k<sizeof(T)/sizeof(T[0]);++k) {
+		ens_t* const ens = ens_run(E,I,n,B,tab,mw_filter_sel(B),obs,K,p0,iseed,T[k],S[k]);
+		char what[64];
+		sprintf(what,"ens_run (%d threads, chunk %zu)",T[k],S[k]);
+		nfail += ens_compare(what,I,nobs,ens1->mean,ens1->var,ens,1e-12);
+		ens_free(ens);
+	}
+	ens_free(ens1);
+
+	free(var);
+	free(mean);
+	free(tab);
+
+	printf("ens: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
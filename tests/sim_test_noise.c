@@ -0,0 +1,62 @@
+#include "word.h"
+#include "clap.h"
+
+// Bernoulli bit masks (word-at-a-time binary expansion above WBSKIP, geometric
+// skips below): density of random rows and flip rate of CA noise against p,
+// either side of WBSKIP and at the end points.
+
+static int bern_check(const char* const what, const double p, const size_t nset, const size_t N)
+{
+	// mean within 5 standard deviations (plus the WBPREC-digit rounding of p)
+	const double phat = (double)nset/(double)N;
+	const double tol  = 5.0*sqrt(p*(1.0-p)/(double)N)+1.0/(double)POW2(WBPREC);
+	if (fabs(phat-p) <= tol) return 0;
+	printf("%s : p = %g, mean = %g : FAIL\n",what,p,phat);
+	return 1;
+}
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(n,       size_t,  4096,         "row length (words)");
+	CLAP_CARG(nreps,   int,     16,           "rows per probability");
+	CLAP_CARG(rseed,   ulong,   1,            "random seed");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	mt_t rng;
+	mt_seed(&rng,rseed);
+	int nfail = 0;
+	word_t* const w  = mw_alloc(n);
+	word_t* const w1 = mw_alloc(n);
+	const size_t N = (size_t)nreps*n*WBITS;
+
+	const double P[] = {0.0,0.001,0.01,WBSKIP/2.0,WBSKIP,0.1,0.3,0.5,0.77,0.999,1.0};
+	for (size_t k=0;k<sizeof(P)/sizeof(P[0]);++k) {
+		const double p = P[k];
+		size_t nrow = 0, nword = 0, nflip = 0;
+		for (int r=0;r<nreps;++r) {
+			mw_randomiseb(n,w,p,&rng);
+			nrow += (size_t)mw_nsetbits(n,w);
+			for (size_t j=0;j<n;++j) nword += (size_t)wd_nsetbits(wd_randomb(p,&rng));
+			mw_randomise(n,w,&rng); // noise on an arbitrary row: flipped cells
+			mw_copy(n,w1,w);
+			wm_noisify(n,w1,p,&rng);
+			for (size_t j=0;j<n;++j) nflip += (size_t)wd_nsetbits(w1[j]^w[j]);
+		}
+		nfail += bern_check("mw_randomiseb",p,nrow, N);
+		nfail += bern_check("wd_randomb",   p,nword,N);
+		nfail += bern_check("wm_noisify",   p,nflip,N);
+	}
+
+	free(w1);
+	free(w);
+
+	printf("noise: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,89 @@
+#include "ca.h"
+#include "rtab.h"
+#include "clap.h"
+
+// Second-order (reversible) CA: untwisted runs against the twisted run,
+// forward then backward (ca_rewind2) back to the initial rows, and periods
+// (ca_period2) against running the pair on.
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(maxB,    int,     7,            "largest rule size");
+	CLAP_CARG(I,       size_t,  50,           "generations");
+	CLAP_CARG(n,       size_t,  2,            "ring length (words)");
+	CLAP_CARG(rseed,   ulong,   1,            "CA rule random seed");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	mt_t rng;
+	mt_seed(&rng,rseed);
+	int nfail = 0;
+	word_t* const ca0 = mw_alloc(I*n); // twisted (uto = 0)
+	word_t* const ca  = mw_alloc(I*n);
+	word_t* const cab = mw_alloc(I*n);
+	word_t* const wrot = mw_alloc(n);
+
+	for (int B=1;B<=maxB;++B) {
+		word_t* const tab = rt_alloc(B);
+		rt_randomise(B,tab,0.5,&rng);
+		const int C = B/2;
+		mw_randomise(2*n,ca0,&rng);
+		ca_run2(I,n,ca0,B,tab,0,NULL);
+		const int U[] = {0,1,C,B};
+		for (size_t u=0;u<sizeof(U)/sizeof(U[0]);++u) {
+			const int uto = U[u];
+
+			// stored row t is the twisted row rotated left by t*uto
+			mw_copy(n,ca,ca0);
+			mw_rotl(n,ca+n,ca0+n,(size_t)uto);
+			ca_run2(I,n,ca,B,tab,uto,mw_filter_sel(B));
+			size_t nbad = 0;
+			for (size_t t=0;t<I;++t) {mw_rotl(n,wrot,ca0+t*n,t*(size_t)uto); if (!mw_equal(n,wrot,ca+t*n)) ++nbad;}
+			if (nbad > 0) {printf("B = %d, uto = %d : untwisted run : FAIL\n",B,uto); ++nfail;}
+
+			// backwards: the reversed orbit, and backwards again the original
+			mw_copy(I*n,cab,ca);
+			ca_rewind2(I,n,cab,B,uto);
+			ca_run2(I,n,cab,B,tab,uto,NULL);
+			if (uto == C) { // stored rows are physical rows
+				nbad = 0;
+				for (size_t t=0;t<I;++t) if (!mw_equal(n,cab+t*n,ca+(I-1-t)*n)) ++nbad;
+				if (nbad > 0) {printf("B = %d, uto = %d : reversed orbit : FAIL\n",B,uto); ++nfail;}
+			}
+			ca_rewind2(I,n,cab,B,uto);
+			ca_run2(I,n,cab,B,tab,uto,NULL);
+			if (!mw_equal(I*n,cab,ca)) {printf("B = %d, uto = %d : round trip : FAIL\n",B,uto); ++nfail;}
+		}
+
+		// period of the twisted pair (a null rule, x_{t+1} = x_{t-1}, has period at most 2)
+		for (int k=0;k<2;++k) {
+			if (k == 1) mw_zero(rt_nwords(B),tab);
+			int rot;
+			const size_t p = ca_period2(I-2,n,ca0,B,tab,&rot);
+			if (k == 1 && p > 2) {printf("B = %d : null rule period %zu : FAIL\n",B,p); ++nfail;}
+			if (p < I-2) {
+				mw_copy(2*n,ca,ca0);
+				ca_run2(p+2,n,ca,B,tab,0,NULL);
+				mw_rotl(n,wrot,ca+p*n,(size_t)rot);
+				const int ok = mw_equal(n,ca0,wrot);
+				mw_rotl(n,wrot,ca+(p+1)*n,(size_t)rot);
+				if (!ok || !mw_equal(n,ca0+n,wrot)) {printf("B = %d : ca_period2 : FAIL\n",B); ++nfail;}
+			}
+		}
+		free(tab);
+	}
+
+	free(wrot);
+	free(cab);
+	free(ca);
+	free(ca0);
+
+	printf("order2: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,58 @@
+#include <string.h>
+
+#include "pool.h"
+#include "utils.h"
+#include "clap.h"
+
+// Task pool: every task run exactly once, on a valid worker, for any number of
+// tasks, chunk size and number of threads; per-worker task counts add up.
+
+typedef struct {
+	size_t  nthreads;
+	size_t* nrun;    // times each task was run
+	size_t* nbadw;   // tasks run on an out-of-range worker
+} ptest_t;
+
+static void ptest_task(void* const arg, const size_t k, const size_t tnum)
+{
+	ptest_t* const a = (ptest_t*)arg;
+	__atomic_fetch_add(&a->nrun[k],1,__ATOMIC_RELAXED);
+	if (tnum >= a->nthreads) __atomic_fetch_add(a->nbadw,1,__ATOMIC_RELAXED);
+}
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(maxthr,  size_t,  8,            "largest number of threads");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	int nfail = 0;
+	const size_t NT[] = {0,1,7,64,1000,4099};
+	const size_t CH[] = {1,3,64,5000};
+	for (size_t i=0;i<sizeof(NT)/sizeof(NT[0]);++i) for (size_t j=0;j<sizeof(CH)/sizeof(CH[0]);++j) for (size_t nthreads=1;nthreads<=maxthr;nthreads*=2) {
+		const size_t ntasks = NT[i], chunk = CH[j];
+		size_t* const nrun = calloc(ntasks+1,sizeof(size_t)); // zero-initialises
+		TEST_ALLOC(nrun);
+		size_t nbadw = 0;
+		ptest_t a = {nthreads,nrun,&nbadw};
+		pool_stat_t stat[nthreads];
+		pool_run(ntasks,chunk,nthreads,ptest_task,&a,stat);
+		size_t nbad = 0, ntot = 0;
+		for (size_t k=0;k<ntasks;++k) if (nrun[k] != 1) ++nbad;
+		for (size_t t=0;t<nthreads;++t) ntot += stat[t].ntasks;
+		if (nbad > 0 || nbadw > 0 || ntot != ntasks) {
+			printf("ntasks = %zu, chunk = %zu, nthreads = %zu : %zu tasks not run once, %zu on bad workers, %zu counted : FAIL\n",ntasks,chunk,nthreads,nbad,nbadw,ntot);
+			++nfail;
+		}
+		free(nrun);
+	}
+
+	printf("pool: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
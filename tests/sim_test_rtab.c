@@ -0,0 +1,195 @@
+#include <dirent.h>
+#include <unistd.h>
+
+#include "rtab.h"
+#include "rtnative.h"
+#include "clap.h"
+
+// Bit-packed rule tables (RTBIT/RTSET) against a byte-per-entry copy, rule
+// composition (rt_compose_filt, rt_run) against stepping the rule k times, the
+// size-specialised kernels (mw_filter_sel, wd_filter_sel) against the generic
+// ones, and native kernels for a rule and its symmetries (cached side by side).
+
+static int compose_bf(const int rsiz, const word_t* const rtab, const int k, const int fsiz, const word_t* const ftab, const word_t x)
+{
+	// filter o F^k on the open window x, one step at a time
+	word_t y = x;
+	int len = k*(rsiz-1)+fsiz;
+	for (int j=0;j<k;++j) {
+		word_t ynew = WZERO;
+		len -= rsiz-1;
+		for (int i=0;i<len;++i) ynew |= RTBIT(rtab,(y>>i)&(POW2(rsiz)-1))<<i;
+		y = ynew;
+	}
+	return (int)RTBIT(ftab,y);
+}
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(maxB,    int,     14,           "largest table size (packing)");
+	CLAP_CARG(n,       size_t,  3,            "ring length (words)");
+	CLAP_CARG(rseed,   ulong,   1,            "CA rule random seed");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	mt_t rng;
+	mt_seed(&rng,rseed);
+	xr_t xrng;
+	xr_seed(&xrng,rseed);
+	int nfail = 0;
+
+	// packing: set and read back every entry, hi-bits of short tables clear
+
+	for (int B=1;B<=maxB;++B) {
+		const size_t S = POW2(B);
+		unsigned char* const ref = malloc(S);
+		TEST_ALLOC(ref);
+		word_t* const tab = rt_alloc(B);
+		size_t nset = 0;
+		for (size_t r=0;r<S;++r) {ref[r] = (unsigned char)(mt_uint(&rng)&1); nset += ref[r];}
+		for (size_t r=0;r<S;++r) RTSET(tab,r,WONE); // set, then clear as required
+		for (size_t r=0;r<S;++r) if (!ref[r]) RTSET(tab,r,WZERO);
+		size_t nbad = 0;
+		for (size_t r=0;r<S;++r) if (RTBIT(tab,r) != ref[r]) ++nbad;
+		if (nbad > 0)                      {printf("B = %2d : %zu entries differ : FAIL\n",B,nbad); ++nfail;}
+		if (rt_nsetbits(B,tab) != nset)    {printf("B = %2d : rt_nsetbits : FAIL\n",B);            ++nfail;}
+		rt_invert(B,tab);
+		if (rt_nsetbits(B,tab) != S-nset)  {printf("B = %2d : rt_invert : FAIL\n",B);              ++nfail;}
+		rt_randomise_xr(B,tab,0.5,&xrng);
+		if (B < 6 && (tab[0]>>S) != 0)     {printf("B = %2d : rt_randomise_xr hi-bits : FAIL\n",B); ++nfail;}
+		free(tab);
+		free(ref);
+	}
+
+	// composed tables, entry by entry
+
+	for (int rsiz=1;rsiz<=5;++rsiz) for (int fsiz=1;fsiz<=3;++fsiz) for (int k=0;k<=4;++k) {
+		if (k*(rsiz-1)+fsiz > 16) continue;
+		word_t* const rtab = rt_alloc(rsiz);
+		word_t* const ftab = rt_alloc(fsiz);
+		rt_randomise(rsiz,rtab,0.5,&rng);
+		rt_randomise(fsiz,ftab,0.5,&rng);
+		int csiz;
+		word_t* const ctab = rt_compose_filt(rsiz,rtab,k,fsiz,ftab,&csiz);
+		if (csiz != k*(rsiz-1)+fsiz) {printf("rsiz = %d, fsiz = %d, k = %d : size %d : FAIL\n",rsiz,fsiz,k,csiz); ++nfail;}
+		size_t nbad = 0;
+		for (word_t x=0;x<POW2(csiz);++x) if ((int)RTBIT(ctab,x) != compose_bf(rsiz,rtab,k,fsiz,ftab,x)) ++nbad;
+		if (nbad > 0) {printf("rsiz = %d, fsiz = %d, k = %d : %zu entries differ : FAIL\n",rsiz,fsiz,k,nbad); ++nfail;}
+		free(ctab);
+		free(ftab);
+		free(rtab);
+	}
+
+	// composition budget: F^k fits, F^(k+1) does not (unless capped)
+
+	for (int B=2;B<=9;++B) for (size_t cbytes=1024;cbytes<=(size_t)4*1024*1024;cbytes*=4) {
+		const int k = rt_compose_k(B,cbytes);
+		const int s = k*(B-1)+1, s1 = (k+1)*(B-1)+1;
+		if (k > 1 && rt_nwords(s)*sizeof(word_t) > cbytes)         {printf("B = %d, cbytes = %zu : k = %d too big : FAIL\n",  B,cbytes,k); ++nfail;}
+		if (k < 16 && s1 < WBITS && rt_nwords(s1)*sizeof(word_t) <= cbytes) {printf("B = %d, cbytes = %zu : k = %d too small : FAIL\n",B,cbytes,k); ++nfail;}
+	}
+
+	// fast-forward by composed rule = plain run on the ring
+
+	word_t* const w0 = mw_alloc(n);
+	word_t* const w1 = mw_alloc(n);
+	word_t* const w2 = mw_alloc(n);
+	for (int B=2;B<=7;++B) {
+		word_t* const tab = rt_alloc(B);
+		rt_randomise(B,tab,0.5,&rng);
+		const size_t k = (size_t)rt_compose_k(B,0);
+		const size_t I[] = {0,1,k-1,k,5*k+3};
+		mw_randomise(n,w0,&rng);
+		for (size_t i=0;i<sizeof(I)/sizeof(I[0]);++i) {
+			mw_copy(n,w1,w0);
+			mw_copy(n,w2,w0);
+			rt_run(I[i],n,w1,B,tab);
+			mw_run(I[i],n,w2,B,tab);
+			if (!mw_equal(n,w1,w2)) {printf("B = %d, I = %zu : rt_run : FAIL\n",B,I[i]); ++nfail;}
+		}
+		free(tab);
+	}
+
+	// specialised kernels = generic kernels, for every specialised size and the fallback above
+
+	const size_t NW[] = {1,2,3,7};
+	word_t* const v0 = mw_alloc(7);
+	word_t* const v1 = mw_alloc(7);
+	word_t* const v2 = mw_alloc(7);
+	for (int B=1;B<=WFMAXB+1;++B) {
+		word_t* const tab = rt_alloc(B);
+		rt_randomise(B,tab,0.5,&rng);
+		const mw_filter_t mfilt = mw_filter_sel(B);
+		for (size_t i=0;i<sizeof(NW)/sizeof(NW[0]);++i) {
+			const size_t nw = NW[i];
+			mw_randomise(nw,v0,&rng);
+			mw_filter_gen(nw,v1,v0,B,tab);
+			mfilt(nw,v2,v0,B,tab);
+			if (!mw_equal(nw,v1,v2)) {printf("B = %2d, n = %zu : mw_filter_sel : FAIL\n",B,nw); ++nfail;}
+		}
+		const wd_filter_t wfilt = wd_filter_sel(B);
+		const int M[] = {B,B+1,B+7,WBITS/2};
+		for (size_t i=0;i<sizeof(M)/sizeof(M[0]);++i) {
+			const int m = M[i];
+			if (m > WBITS/2) continue;
+			size_t nbad = 0;
+			for (int j=0;j<100;++j) {
+				const word_t x = mt_uint(&rng)&(WONES>>(WBITS-m));
+				if (wfilt(m,x,B,tab) != wd_filter(m,x,B,tab)) ++nbad;
+			}
+			if (nbad > 0) {printf("B = %2d, m = %d : wd_filter_sel : %zu differ : FAIL\n",B,m,nbad); ++nfail;}
+		}
+		free(tab);
+	}
+	free(v2);
+	free(v1);
+	free(v0);
+
+	// native kernels: a rule and its reflection/complement have different cache entries
+	// (skipped if there is no compiler)
+
+	char cdir[] = "/tmp/caxplor_check_XXXXXX";
+	PASSERT(mkdtemp(cdir) != NULL,"failed to create temporary directory");
+	const int B = 5;
+	word_t* gtab[4];
+	mw_filter_t kern[4];
+	gtab[0] = rt_alloc(B);
+	rt_randomise(B,gtab[0],0.5,&rng);
+	for (int g=1;g<4;++g) {gtab[g] = rt_alloc(B); rt_symmetry(B,gtab[g],gtab[0],g);}
+	for (int pass=0;pass<2;++pass) for (int g=0;g<4;++g) { // second pass from cache
+		const mw_filter_t k = rt_native(B,gtab[g],cdir);
+		if (pass == 0) kern[g] = k;
+		if (kern[0] == NULL) {if (g == 0 && pass == 0) puts("rt_native : no compiler, skipped"); break;}
+		if (k == NULL || k != kern[g]) {printf("rt_native : symmetry %d, pass %d : kernel not loaded : FAIL\n",g,pass); ++nfail; continue;}
+		mw_randomise(n,w0,&rng);
+		mw_filter(n,w1,w0,B,gtab[g]);
+		k(n,w2,w0,B,gtab[g]);
+		if (!mw_equal(n,w1,w2)) {printf("rt_native : symmetry %d : FAIL\n",g); ++nfail;}
+	}
+	for (int g=0;g<4;++g) free(gtab[g]);
+	DIR* const dir = opendir(cdir);
+	if (dir != NULL) {
+		const size_t fnlen = strlen(cdir)+300;
+		char fname[fnlen];
+		for (struct dirent* de; (de = readdir(dir)) != NULL;) {
+			if (de->d_name[0] == '.') continue;
+			snprintf(fname,fnlen,"%s/%s",cdir,de->d_name);
+			remove(fname);
+		}
+		closedir(dir);
+	}
+	rmdir(cdir);
+
+	free(w2);
+	free(w1);
+	free(w0);
+
+	printf("rtab: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
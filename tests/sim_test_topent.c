@@ -0,0 +1,61 @@
+#include "rtab.h"
+#include "clap.h"
+
+// Topological entropy of the image language (rt_topent) for all 256
+// elementary CA, against brute-force counts N(L) of distinct image words:
+// log2(N(L)/N(L-1)) approaches the entropy as L grows.
+
+static double topent_bf(const int B, const word_t* const tab, const int L)
+{
+	const size_t N = POW2((size_t)L+(size_t)B-1);
+	const size_t M = POW2(L), M1 = POW2(L-1);
+	unsigned char* const seen  = calloc(M, 1);
+	TEST_ALLOC(seen);
+	unsigned char* const seen1 = calloc(M1,1);
+	TEST_ALLOC(seen1);
+	size_t c = 0, c1 = 0;
+	for (size_t x=0;x<N;++x) {
+		size_t y = 0;
+		for (int i=0;i<L;++i) y |= (size_t)RTBIT(tab,(x>>i)&(POW2(B)-1))<<i;
+		if (!seen [y     ]) {seen [y     ] = 1; ++c; }
+		if (!seen1[y&(M1-1)]) {seen1[y&(M1-1)] = 1; ++c1;}
+	}
+	free(seen1);
+	free(seen);
+	return log2((double)c/(double)c1);
+}
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(L,       int,     16,           "brute-force word length");
+	CLAP_CARG(tol,     double,  0.025,        "tolerance (finite-length bias)");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	int nfail = 0;
+	for (int r=0;r<256;++r) {
+		const word_t tab[1] = {(word_t)r};
+		const double H  = rt_topent(3,tab,100000,NULL,NULL);
+		const double Hb = topent_bf(3,tab,L);
+		if (!(fabs(H-Hb) < tol)) {
+			printf("ECA %3d : topent = %8.6f, brute force (L = %d) = %8.6f : FAIL\n",r,H,L,Hb);
+			++nfail;
+		}
+	}
+
+	// known values: rule 1 (golden mean shift), identity, rule 90 (surjective)
+
+	const word_t t1[1] = {1}, t204[1] = {204}, t90[1] = {90};
+	if (fabs(rt_topent(3,t1,  100000,NULL,NULL)-log2(0.5*(1.0+sqrt(5.0)))) > 1e-9) {puts("ECA 1 : FAIL");   ++nfail;}
+	if (fabs(rt_topent(3,t204,100000,NULL,NULL)-1.0) > 1e-9)                      {puts("ECA 204 : FAIL"); ++nfail;}
+	if (fabs(rt_topent(3,t90, 100000,NULL,NULL)-1.0) > 1e-9)                      {puts("ECA 90 : FAIL");  ++nfail;}
+
+	printf("topent: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,106 @@
+#include "rtab.h"
+#include "tune.h"
+#include "clap.h"
+
+// (Outer-)totalistic rules: adder-network kernels against table lookup and,
+// beyond table sizes, against counting the window directly; mask lambda;
+// classification of tables; rule lists with table-free rules.
+
+static void tot_step_bf(const size_t n, word_t* const wnew, const word_t* const w, const int B, const rtype_t rtype, const word_t mask)
+{
+	// output cell i from the count of cells i, ..., i+B-1 (ring)
+	const size_t N = n*WBITS;
+	const int C = B/2;
+	for (size_t i=0;i<N;++i) {
+		int c = 0, s = 0;
+		for (int j=0;j<B;++j) {
+			const size_t k = (i+(size_t)j)%N;
+			const int x = (int)BITON(w[k/WBITS],k%WBITS);
+			if (rtype == RT_OUTER && j == C) s = x; else c += x;
+		}
+		PUTBIT(wnew[i/WBITS],i%WBITS,BITON(mask,rtype == RT_OUTER ? 2*c+s : c));
+	}
+}
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(maxB,    int,     14,           "largest table size");
+	CLAP_CARG(nrules,  int,     4,            "random rules per size");
+	CLAP_CARG(n,       size_t,  3,            "ring length (words)");
+	CLAP_CARG(rseed,   ulong,   1,            "CA rule random seed");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	mt_t rng;
+	mt_seed(&rng,rseed);
+	int nfail = 0;
+	word_t* const w  = mw_alloc(n);
+	word_t* const w1 = mw_alloc(n);
+	word_t* const w2 = mw_alloc(n);
+
+	// kernels, lambda and classification
+
+	for (int t=0;t<2;++t) {
+		const rtype_t rtype = t == 0 ? RT_TOTAL : RT_OUTER;
+		const char tc = t == 0 ? 'T' : 'O';
+		for (int B=1;B<=rt_tot_maxb(rtype);++B) for (int k=0;k<nrules;++k) {
+			const word_t mask = rt_tot_random(B,rtype,0.5,&rng);
+			mw_randomise(n,w,&rng);
+			tot_step_bf(n,w1,w,B,rtype,mask);
+			rt_tot_kernel(rtype)(n,w2,w,B,&mask);
+			if (!mw_equal(n,w1,w2)) {printf("%c%d:%"PRIX64" : mask kernel : FAIL\n",tc,B,mask); ++nfail;}
+			if (B > maxB) continue;
+			word_t* const tab = rt_alloc(B);
+			rt_from_totalistic(B,tab,rtype,mask);
+			mw_filter(n,w2,w,B,tab);
+			if (!mw_equal(n,w1,w2)) {printf("%c%d:%"PRIX64" : table : FAIL\n",tc,B,mask); ++nfail;}
+			(rtype == RT_OUTER ? mw_filter_outer : mw_filter_total)(n,w2,w,B,tab);
+			if (!mw_equal(n,w1,w2)) {printf("%c%d:%"PRIX64" : table kernel : FAIL\n",tc,B,mask); ++nfail;}
+			if (fabs(rt_tot_lambda(B,rtype,mask)-rt_lambda(B,tab)) > 1e-12) {printf("%c%d:%"PRIX64" : lambda : FAIL\n",tc,B,mask); ++nfail;}
+			word_t cmask;
+			const rtype_t ctype = rt_totalistic(B,tab,&cmask); // totalistic takes precedence
+			word_t* const ctab = rt_alloc(B);
+			if (ctype != RT_TABLE) rt_from_totalistic(B,ctab,ctype,cmask);
+			if (ctype == RT_TABLE || (rtype == RT_TOTAL && ctype != RT_TOTAL) || !mw_equal(rt_nwords(B),tab,ctab)) {printf("%c%d:%"PRIX64" : classification : FAIL\n",tc,B,mask); ++nfail;}
+			free(ctab);
+			free(tab);
+		}
+	}
+
+	// rule lists: table-free beyond RT_TOTTABMAXB, classified on reading, kernel chosen from the type
+
+	FILE* const fs = tmpfile();
+	PASSERT(fs != NULL,"failed to open temporary file");
+	fputs("T40:1234567890\nO5:3A6\n6996\nT40:1234567890\n",fs); // duplicate is dropped; 6996 is 4-cell parity (T4:A)
+	rewind(fs);
+	rtl_t* const rule = rtl_fread(fs);
+	fclose(fs);
+	int nlist, nfilts;
+	free(rtl_nitems(rule,&nlist,&nfilts));
+	if (nlist != 3) {printf("rtl_fread : %d rules : FAIL\n",nlist); ++nfail;}
+	const rtl_t* const r1 = rule, * const r2 = r1 != NULL ? r1->next : NULL, * const r3 = r2 != NULL ? r2->next : NULL;
+	if (r1 == NULL || r1->tab != NULL || r1->size != 40 || r1->rtype != RT_TOTAL || r1->mask != 0x1234567890) {puts("rtl_fread T40 : FAIL"); ++nfail;}
+	if (r2 == NULL || r2->tab == NULL || r2->rtype != RT_OUTER || r2->mask != 0x3A6)                           {puts("rtl_fread O5 : FAIL");  ++nfail;}
+	if (r3 == NULL || r3->tab == NULL || r3->rtype != RT_TOTAL || r3->mask != 0xA)                             {puts("rtl_fread parity : FAIL"); ++nfail;}
+	if (r1 != NULL && r1->tab == NULL) {
+		if (rtl_find_tot(rule,40,RT_TOTAL,0x1234567890) != r1) {puts("rtl_find_tot : FAIL"); ++nfail;}
+		mw_randomise(n,w,&rng);
+		tot_step_bf(n,w1,w,r1->size,r1->rtype,r1->mask);
+		tune_kernel(r1->size,n,r1->tab,r1->rtype,"auto",0)(n,w2,w,r1->size,rtl_ktab(r1));
+		if (!mw_equal(n,w1,w2)) {puts("table-free kernel : FAIL"); ++nfail;}
+	}
+	rtl_free((rtl_t*)rule);
+
+	free(w2);
+	free(w1);
+	free(w);
+
+	printf("tot: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
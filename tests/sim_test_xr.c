@@ -0,0 +1,133 @@
+#include "word.h"
+#include "clap.h"
+
+// Lane-interleaved xoshiro256**: the vector stepping against a scalar reference
+// generator per lane, bulk fills against single draws, and the density of
+// Bernoulli fills against p. Philox4x64-10 against the Random123 known-answer
+// vectors, and keyed seeding (xr_seed_key) reproducible from the key alone.
+
+static uint64_t xr_ref_next(uint64_t s[4])
+{
+	// xoshiro256** (Blackman and Vigna), reference implementation
+	const uint64_t x = s[1]*5;
+	const uint64_t r = ((x<<7)|(x>>57))*9;
+	const uint64_t t = s[1]<<17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3]  = (s[3]<<45)|(s[3]>>19);
+	return r;
+}
+
+static int bern_check(const char* const what, const double p, const size_t nset, const size_t N)
+{
+	// mean within 5 standard deviations (plus the WBPREC-digit rounding of p)
+	const double phat = (double)nset/(double)N;
+	const double tol  = 5.0*sqrt(p*(1.0-p)/(double)N)+1.0/(double)POW2(WBPREC);
+	if (fabs(phat-p) <= tol) return 0;
+	printf("%s : p = %g, mean = %g : FAIL\n",what,p,phat);
+	return 1;
+}
+
+int sim_test(int argc, char* argv[], int info)
+{
+	// CLAP (command-line argument parser). Default values
+	// may be overriden on the command line as switches.
+	//
+	// Arg:   name     type     default       description
+	puts("\n---------------------------------------------------------------------------------------");
+	CLAP_CARG(n,       size_t,  4096,         "row length (words)");
+	CLAP_CARG(nreps,   int,     16,           "rows per probability");
+	CLAP_CARG(rseed,   ulong,   1,            "random seed");
+	puts("---------------------------------------------------------------------------------------\n");
+
+	if (info) return EXIT_SUCCESS; // display switches and return
+
+	int nfail = 0;
+	xr_t rng;
+
+	// interleaved lanes against the scalar generator, lane by lane
+
+	xr_seed(&rng,rseed);
+	uint64_t s[XR_LANES][4];
+	for (int l=0;l<XR_LANES;++l) for (int i=0;i<4;++i) s[l][i] = rng.s[i][l];
+	size_t nbad = 0;
+	for (int b=0;b<1000;++b) for (int l=0;l<XR_LANES;++l) if (xr_uint(&rng) != xr_ref_next(s[l])) ++nbad;
+	if (nbad > 0) {printf("xr_uint : %zu draws differ from reference : FAIL\n",nbad); ++nfail;}
+
+	// bulk fills (any length, from any point in the buffer) = single draws
+
+	xr_t rng1, rng2;
+	xr_seed(&rng1,rseed);
+	xr_seed(&rng2,rseed);
+	uint64_t x[3*XR_BLOCK+5];
+	nbad = 0;
+	for (size_t m=0;m<=3*XR_BLOCK+5;++m) {
+		xr_fill(&rng1,m,x);
+		for (size_t k=0;k<m;++k) if (x[k] != xr_uint(&rng2)) ++nbad;
+		if (xr_uint(&rng1) != xr_uint(&rng2)) ++nbad; // and leave the buffer in step
+	}
+	if (nbad > 0) {printf("xr_fill : %zu draws differ from xr_uint : FAIL\n",nbad); ++nfail;}
+
+	// Philox known answers (Salmon et al., Random123 kat_vectors)
+
+	const struct {uint64_t key[2]; uint64_t ctr[4]; uint64_t out[4];} KAT[] = {
+		{{0,0},{0,0,0,0},
+		 {UINT64_C(0x16554d9eca36314c),UINT64_C(0xdb20fe9d672d0fdc),UINT64_C(0xd7e772cee186176b),UINT64_C(0x7e68b68aec7ba23b)}},
+		{{UINT64_C(0x452821e638d01377),UINT64_C(0xbe5466cf34e90c6c)},
+		 {UINT64_C(0x243f6a8885a308d3),UINT64_C(0x13198a2e03707344),UINT64_C(0xa4093822299f31d0),UINT64_C(0x082efa98ec4e6c89)},
+		 {UINT64_C(0xa528f45403e61d95),UINT64_C(0x38c72dbd566e9788),UINT64_C(0xa5a1610e72fd18b5),UINT64_C(0x57bd43b5e52b7fe6)}},
+	};
+	for (size_t k=0;k<sizeof(KAT)/sizeof(KAT[0]);++k) {
+		uint64_t c[4];
+		memcpy(c,KAT[k].ctr,sizeof(c));
+		xr_philox(KAT[k].key,c);
+		if (memcmp(c,KAT[k].out,sizeof(c)) != 0) {printf("xr_philox : vector %zu : FAIL\n",k); ++nfail;}
+	}
+
+	// keyed seeding: same key, same stream (whatever came before); any key change, another stream
+
+	xr_seed_key(&rng1,rseed,3,1000);
+	for (int i=0;i<100;++i) (void)xr_uint(&rng1);
+	xr_seed_key(&rng1,rseed,3,999);
+	xr_seed_key(&rng2,rseed,3,999);
+	nbad = 0;
+	for (int i=0;i<100;++i) if (xr_uint(&rng1) != xr_uint(&rng2)) ++nbad;
+	if (nbad > 0) {puts("xr_seed_key : not reproducible : FAIL"); ++nfail;}
+	const uint64_t K3[3][3] = {{rseed+1,3,999},{rseed,4,999},{rseed,3,1000}};
+	xr_seed_key(&rng1,rseed,3,999);
+	const uint64_t x0 = xr_uint(&rng1);
+	for (int k=0;k<3;++k) {
+		xr_seed_key(&rng2,K3[k][0],K3[k][1],K3[k][2]);
+		if (xr_uint(&rng2) == x0) {printf("xr_seed_key : key %d gives the same stream : FAIL\n",k); ++nfail;}
+	}
+
+	// Bernoulli fills
+
+	word_t* const w  = mw_alloc(n);
+	word_t* const w1 = mw_alloc(n);
+	const size_t N = (size_t)nreps*n*WBITS;
+	const double P[] = {0.0,0.001,0.01,WBSKIP/2.0,WBSKIP,0.1,0.3,0.5,0.77,0.999,1.0};
+	for (size_t k=0;k<sizeof(P)/sizeof(P[0]);++k) {
+		const double p = P[k];
+		size_t nrow = 0, nflip = 0;
+		for (int r=0;r<nreps;++r) {
+			mw_randomiseb_xr(n,w,p,&rng);
+			nrow += (size_t)mw_nsetbits(n,w);
+			if (p >= WBSKIP) continue; // geometric skips only for small p
+			mw_randomise_xr(n,w,&rng);
+			mw_copy(n,w1,w);
+			mw_flipb_xr(n,w1,p,&rng);
+			for (size_t j=0;j<n;++j) nflip += (size_t)wd_nsetbits(w1[j]^w[j]);
+		}
+		nfail += bern_check("mw_randomiseb_xr",p,nrow,N);
+		if (p < WBSKIP) nfail += bern_check("mw_flipb_xr",p,nflip,N);
+	}
+	free(w1);
+	free(w);
+
+	printf("xr: %d failures\n",nfail);
+	return nfail == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,203 @@
+#include <time.h>
+#include <unistd.h>
+
+#include "tune.h"
+#include "rtab.h"
+#include "rtnative.h"
+
+#define TUNE_MINSECS 0.02 // minimum measurement time per candidate
+#define TUNE_MAXENT  256  // maximum profile entries held in memory
+
+typedef struct {
+	int     B;
+	size_t  n;  // rounded up to power of 2
+	tkern_t k;
+	double  ns; // ns per word step
+} tent_t;
+
+typedef struct {
+	int      B;
+	size_t   n;    // rounded up to power of 2
+	uint64_t hash; // of the rule table
+	tkern_t  k;
+} tnat_t;
+
+static tent_t tune_ent[TUNE_MAXENT];
+static size_t tune_nent   = 0;
+static int    tune_loaded = 0;
+static tnat_t tune_nat[TUNE_MAXENT]; // per-rule native choices (this session only)
+static size_t tune_nnat   = 0;
+
+static const char* const tune_names[TK_NUM] = {"generic","spec","native","total"};
+
+const char* tune_name(const tkern_t k)
+{
+	return k < TK_NUM ? tune_names[k] : "unknown";
+}
+
+static size_t tune_nbucket(const size_t n)
+{
+	size_t nb = 1;
+	while (nb < n) nb *= 2;
+	return nb;
+}
+
+static mw_filter_t tune_get(const tkern_t k, const int B, const word_t* const tab, const rtype_t rtype)
+{
+	switch (k) {
+		case TK_GENERIC: return mw_filter_gen;
+		case TK_SPEC:    return mw_filter_sel(B);
+		case TK_NATIVE:  return tab != NULL ? rt_native(B,tab,NULL) : NULL;
+		case TK_TOTAL:   switch (rtype) {
+			case RT_TOTAL: return mw_filter_total;
+			case RT_OUTER: return mw_filter_outer;
+			default:       return NULL;
+		}
+		default:         return NULL;
+	}
+}
+
+double tune_time(const tkern_t k, const int B, const size_t n, const word_t* const tab, const rtype_t rtype)
+{
+	// time kernel on random rows (random rule of size B if tab is NULL)
+	mt_t rng;
+	mt_seed(&rng,1);
+	word_t* const rtab = rt_alloc(B);
+	if (tab == NULL) rt_randomise(B,rtab,0.5,&rng); else rt_copy(B,rtab,tab);
+	const mw_filter_t filt = tune_get(k,B,rtab,tab == NULL ? RT_TABLE : rtype);
+	if (filt == NULL) {free(rtab); return INFINITY;}
+	word_t* const w1 = mw_alloc(n);
+	word_t* const w2 = mw_alloc(n);
+	mw_randomise(n,w1,&rng);
+	filt(n,w2,w1,B,rtab); // warm up
+	size_t reps = 16, steps = 0;
+	struct timespec t0, t1;
+	double secs = 0.0;
+	clock_gettime(CLOCK_MONOTONIC,&t0);
+	while (secs < TUNE_MINSECS) {
+		for (size_t r=0; r<reps; ++r) {filt(n,w2,w1,B,rtab); filt(n,w1,w2,B,rtab);}
+		steps += 2*reps;
+		reps *= 2;
+		clock_gettime(CLOCK_MONOTONIC,&t1);
+		secs = (double)(t1.tv_sec-t0.tv_sec)+1e-9*(double)(t1.tv_nsec-t0.tv_nsec);
+	}
+	free(w2);
+	free(w1);
+	free(rtab);
+	return 1e9*secs/((double)steps*(double)n);
+}
+
+static void tune_profile_name(char* const fname, const size_t fnlen)
+{
+	snprintf(fname,fnlen,"%s/tune.dat",rt_native_dir());
+}
+
+static void tune_load(void)
+{
+	// profile lines: host B n kernel ns/word (later entries supersede earlier)
+	if (tune_loaded) return;
+	tune_loaded = 1;
+	char fname[1100], host[256] = "", fhost[256];
+	tune_profile_name(fname,sizeof(fname));
+	gethostname(host,sizeof(host)-1);
+	FILE* const fs = fopen(fname,"r");
+	if (fs == NULL) return;
+	char line[512], kname[32];
+	int B;
+	size_t n;
+	double ns;
+	while (fgets(line,sizeof(line),fs) != NULL) {
+		if (line[0] == '#') continue;
+		if (sscanf(line,"%255s %d %zu %31s %lf",fhost,&B,&n,kname,&ns) != 5) continue;
+		if (strcmp(fhost,host) != 0) continue;
+		tkern_t k = TK_NUM;
+		for (int j=0; j<TK_NUM; ++j) if (strcmp(kname,tune_names[j]) == 0) k = (tkern_t)j;
+		if (k == TK_NUM || k == TK_NATIVE) continue; // native is rule-dependent (older profiles)
+		size_t i = 0;
+		while (i < tune_nent && (tune_ent[i].B != B || tune_ent[i].n != n)) ++i;
+		if (i == TUNE_MAXENT) break;
+		if (i == tune_nent) ++tune_nent;
+		tune_ent[i] = (tent_t){B,n,k,ns};
+	}
+	fclose(fs);
+}
+
+static void tune_save(const tent_t* const e)
+{
+	char fname[1100], host[256] = "";
+	tune_profile_name(fname,sizeof(fname));
+	gethostname(host,sizeof(host)-1);
+	FILE* const fs = fopen(fname,"a");
+	if (fs == NULL) return; // profile is only an optimisation
+	if (ftell(fs) == 0) fprintf(fs,"# caxplor kernel profile: host, rule size, words (rounded up to power of 2), kernel, ns/word step\n");
+	fprintf(fs,"%s\t%d\t%zu\t%s\t%.4f\n",host,e->B,e->n,tune_name(e->k),e->ns);
+	fclose(fs);
+}
+
+static tkern_t tune_native(const int B, const size_t nb, const word_t* const tab, const tkern_t k, const int retune, const int verbose)
+{
+	// the native kernel is the rule's own circuit, so its speed depends on the table: it is
+	// timed against the profiled kernel k on this table (once per session, not saved)
+	if (B > RT_NATIVE_MAXB) return k;
+	const uint64_t hash = rt_hash_tab(B,tab);
+	size_t i = 0;
+	while (i < tune_nnat && (tune_nat[i].B != B || tune_nat[i].n != nb || tune_nat[i].hash != hash)) ++i;
+	if (i < tune_nnat && !retune) return tune_nat[i].k;
+	const double ns  = tune_time(k,        B,nb,tab,RT_TABLE);
+	const double nsn = tune_time(TK_NATIVE,B,nb,tab,RT_TABLE);
+	const tkern_t kn = nsn < ns ? TK_NATIVE : k;
+	if (verbose) printf("kernel: %s (this rule: %s %.3f ns/word, %s %.3f ns/word)\n",tune_name(kn),tune_name(k),ns,tune_name(TK_NATIVE),nsn);
+	if (i == tune_nnat && tune_nnat < TUNE_MAXENT) ++tune_nnat;
+	if (i < tune_nnat) tune_nat[i] = (tnat_t){B,nb,hash,kn};
+	return kn;
+}
+
+tkern_t tune_choose(const int B, const size_t n, const word_t* const tab, const rtype_t rtype, const char* const kernel, const int verbose)
+{
+	const char* const kstr = kernel != NULL ? kernel : "auto";
+	for (int j=0; j<TK_NUM; ++j) if (strcmp(kstr,tune_names[j]) == 0) return (tkern_t)j; // forced
+
+	const int retune = strcmp(kstr,"retune") == 0;
+	ASSERT(retune || strcmp(kstr,"auto") == 0,"unknown kernel '%s' (must be auto, retune, generic, spec, native or total)",kstr);
+
+	if (rtype != RT_TABLE) {
+		if (verbose) printf("kernel: %s (totalistic rule)\n",tune_name(TK_TOTAL));
+		return TK_TOTAL;
+	}
+
+	tune_load();
+	const size_t nb = tune_nbucket(n);
+	size_t i = 0;
+	while (i < tune_nent && (tune_ent[i].B != B || tune_ent[i].n != nb)) ++i;
+	tkern_t k;
+	if (i < tune_nent && !retune) {
+		if (verbose) printf("kernel: %s (profiled, %.3f ns/word)\n",tune_name(tune_ent[i].k),tune_ent[i].ns);
+		k = tune_ent[i].k;
+	}
+	else { // tune: time each rule-independent candidate on rows of nb words
+		tent_t e = {B,nb,TK_SPEC,INFINITY};
+		for (int j=0; j<TK_NATIVE; ++j) {
+			const double ns = tune_time((tkern_t)j,B,nb,NULL,RT_TABLE);
+			if (verbose) printf("kernel: %-8s : %.3f ns/word\n",tune_names[j],ns);
+			if (ns < e.ns) {e.ns = ns; e.k = (tkern_t)j;}
+		}
+		if (verbose) printf("kernel: %s (tuned)\n",tune_name(e.k));
+		if (i == tune_nent && tune_nent < TUNE_MAXENT) ++tune_nent;
+		if (i < tune_nent) tune_ent[i] = e;
+		tune_save(&e);
+		k = e.k;
+	}
+	return tune_native(B,nb,tab,k,retune,verbose);
+}
+
+mw_filter_t tune_kernel(const int B, const size_t n, const word_t* const tab, const rtype_t rtype, const char* const kernel, const int verbose)
+{
+	if (tab == NULL) { // table-free (outer-)totalistic rule: mask kernel only
+		ASSERT(rtype != RT_TABLE,"no rule table");
+		if (verbose) printf("kernel: %s (table-free totalistic rule)\n",tune_name(TK_TOTAL));
+		return rt_tot_kernel(rtype);
+	}
+	const tkern_t k = tune_choose(B,n,tab,rtype,kernel,verbose);
+	const mw_filter_t filt = tune_get(k,B,tab,rtype);
+	return filt != NULL ? filt : mw_filter_sel(B); // e.g. native unavailable
+}
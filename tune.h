@@ -0,0 +1,42 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include "rtab.h"
+
+/*********************************************************************/
+/*                  stepping kernel autotuner                        */
+/*********************************************************************/
+
+// Candidate stepping kernels (for a rule of size B on rows of n words) are
+// microbenchmarked on first use; the winner is recorded in a profile in the
+// caxplor cache directory (keyed by host name, B and n rounded up to a power
+// of 2), and subsequently dispatched to without re-measuring. Only the
+// rule-independent kernels (generic, spec) are profiled: the speed of the
+// native kernel depends on the rule's circuit, so it is timed against the
+// profiled winner on the rule itself, once per rule and session.
+//
+// Kernel selection strings (e.g. for a "kernel" command-line switch):
+//
+//   auto    : profiled winner (tune now if not yet profiled)
+//   retune  : re-measure and update profile
+//   generic : generic scalar kernel
+//   spec    : rule-size specialised scalar kernel
+//   native  : compiled per-rule kernel (falls back to spec if unavailable)
+//   total   : bit-sliced adder-network kernel for (outer-)totalistic rules
+//             (falls back to spec if the rule is not totalistic)
+//
+// Since the adder-network kernel is faster than table lookup at all rule
+// sizes, auto and retune choose it for (outer-)totalistic rules without
+// consulting the profile. The rule type is supplied by the caller (classified
+// once, when the rule is made; see rtl_classify), not recomputed here. A rule
+// with no table (tab NULL, rtype not RT_TABLE) is always stepped by the mask
+// kernel, which then takes the mask in place of the table (see rtl_ktab).
+
+typedef enum {TK_GENERIC = 0, TK_SPEC, TK_NATIVE, TK_TOTAL, TK_NUM} tkern_t;
+
+const char* tune_name   (const tkern_t k);
+double      tune_time   (const tkern_t k, const int B, const size_t n, const word_t* const tab, const rtype_t rtype); // ns per word step (INFINITY if unavailable)
+tkern_t     tune_choose (const int B, const size_t n, const word_t* const tab, const rtype_t rtype, const char* const kernel, const int verbose);
+mw_filter_t tune_kernel (const int B, const size_t n, const word_t* const tab, const rtype_t rtype, const char* const kernel, const int verbose);
+
+#endif // TUNE_H
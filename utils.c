@@ -20,13 +20,15 @@ void report_compilation_options()
 #else
 	puts("\t-WITH_GD");
 #endif
-	puts("\ncaxplor available simulations:\n\tana\n\tbmark\n\ttest");
+	puts("\ncaxplor available simulations:\n\tana\n\tbmark\n\ttest\n\trclass\n\tperiod\n\tens\n\tdmg");
 #ifdef HAVE_X11
 	puts("\txplor");
 #endif
 #ifdef HAVE_PTHREADS
 	puts("\tddf");
 	puts("\tddr");
+	puts("\tddo");
+	puts("\tdde");
 #endif
 	putchar('\n');
 }
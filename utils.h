@@ -69,6 +69,7 @@ static inline void qsort_##type(const size_t n, type* const x) \
 
 QSORT_DEFINE(double)
 QSORT_DEFINE(int)
+QSORT_DEFINE(size_t)
 
 void hist(const size_t n, const double* const x, const size_t m, ulong* const  bin);
 
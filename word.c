@@ -153,17 +153,158 @@ void mw_print_bin(const size_t n, const word_t* const w)
 	mw_fprint_bin(n,w,stdout);
 }
 
+// The specialised kernels accumulate output bits by OR (no read-modify-write
+// of each output bit), with the cell loops fully unrolled for constant BB.
+// For BB <= 6 the (packed) rule table is a single word, held in a register.
+
+#define WF_LOOKUP(BB,f,f0,r) ((BB) <= 6 ? WONE&((f0)>>(r)) : RTBIT(f,r))
+
+#define WD_FILTER_DEFINE(BB) \
+static word_t wd_filter_##BB(const int n, const word_t w, const int B, const word_t* const f) \
+{ \
+	const word_t BMASK = WONES>>(WBITS-BB); \
+	const word_t f0 = f[0]; \
+	const word_t w2 = (w<<n)|w; \
+	word_t wnew = WZERO; \
+	for (int i=0; i<n; ++i) wnew |= WF_LOOKUP(BB,f,f0,(w2>>i)&BMASK)<<i; \
+	return wnew; \
+}
+
+#define MW_FILTER_DEFINE(BB) \
+static void mw_filter_##BB(const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f) \
+{ \
+	const word_t BMASK = WONES>>(WBITS-BB); \
+	const word_t f0 = f[0]; \
+	for (size_t k=0;k<n;++k) { \
+		const word_t wk  = w[k]; \
+		const word_t wk1 = k < n-1 ? w[k+1] : w[0]; \
+		word_t wnewk = WZERO; \
+		_Pragma("GCC unroll 64") \
+		for (int i=0;i<WBITS-BB;++i) wnewk |= WF_LOOKUP(BB,f,f0,(wk>>i)&BMASK)<<i; \
+		const word_t wks = (wk>>(WBITS-BB))|(wk1<<BB); /* splice in next word */ \
+		_Pragma("GCC unroll 64") \
+		for (int i=WBITS-BB;i<WBITS;++i) wnewk |= WF_LOOKUP(BB,f,f0,(wks>>(i-(WBITS-BB)))&BMASK)<<i; \
+		wnew[k] = wnewk; \
+	} \
+}
+
+#define WF_DEFINE(BB) WD_FILTER_DEFINE(BB) MW_FILTER_DEFINE(BB)
+
+WF_DEFINE(1)  WF_DEFINE(2)  WF_DEFINE(3)  WF_DEFINE(4)  WF_DEFINE(5)
+WF_DEFINE(6)  WF_DEFINE(7)  WF_DEFINE(8)  WF_DEFINE(9)  WF_DEFINE(10)
+WF_DEFINE(11) WF_DEFINE(12) WF_DEFINE(13) WF_DEFINE(14) WF_DEFINE(15)
+WF_DEFINE(16) WF_DEFINE(17) WF_DEFINE(18) WF_DEFINE(19) WF_DEFINE(20)
+
+static word_t wd_filter_gen(const int n, const word_t w, const int B, const word_t* const f) {return wd_filter(n,w,B,f);}
+void          mw_filter_gen(const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f) {mw_filter(n,wnew,w,B,f);}
+
+#define WF_TABLE(name) {NULL, \
+	name##_1,  name##_2,  name##_3,  name##_4,  name##_5,  name##_6,  name##_7,  name##_8,  name##_9,  name##_10, \
+	name##_11, name##_12, name##_13, name##_14, name##_15, name##_16, name##_17, name##_18, name##_19, name##_20}
+
+static const wd_filter_t wd_filter_tab[WFMAXB+1] = WF_TABLE(wd_filter);
+static const mw_filter_t mw_filter_tab[WFMAXB+1] = WF_TABLE(mw_filter);
+
+wd_filter_t wd_filter_sel(const int B)
+{
+	return B >= 1 && B <= WFMAXB ? wd_filter_tab[B] : wd_filter_gen;
+}
+
+mw_filter_t mw_filter_sel(const int B)
+{
+	return B >= 1 && B <= WFMAXB ? mw_filter_tab[B] : mw_filter_gen;
+}
+
+// The (outer-)totalistic kernels are specialised by the number KK of count
+// digits (so that the counters and multiplexer tree stay in registers); cells
+// are added in groups of 4 with carry-save adders. C is the centre cell for
+// outer-totalistic rules, else -1.
+
+#define MW_TOTAL_DEFINE(KK) \
+static void mw_total_##KK(const size_t n, word_t* const wnew, const word_t* const w, const int B, const int C, const word_t mask) \
+{ \
+	word_t lo[WBITS], dx[WBITS]; \
+	wd_mask_leaves(C < 0 ? KK : KK+1,mask,lo,dx); \
+	for (size_t k=0;k<n;++k) { \
+		const word_t wk  = w[k]; \
+		const word_t wk1 = k < n-1 ? w[k+1] : w[0]; \
+		word_t x[WBITS], s[KK+1] = {WZERO}; /* s[0] is centre state, s[1..KK] count digits */ \
+		word_t* const d = s+1; \
+		int m = 0; \
+		for (int j=0;j<B;++j) { \
+			const word_t xj = j == 0 ? wk : (wk>>j)|(wk1<<(WBITS-j)); /* bit i is cell i+j */ \
+			if (j == C) s[0] = xj; else x[m++] = xj; \
+		} \
+		int j = 0; \
+		if (KK >= 3) for (;j+4<=m;j+=4) { \
+			word_t c0, c1, c2; \
+			wd_csa(&c0,&d[0],d[0],x[j],  x[j+1]); \
+			wd_csa(&c1,&d[0],d[0],x[j+2],x[j+3]); \
+			wd_csa(&c2,&d[1],d[1],c0,c1); \
+			wd_csa_inc(KK-2,d+2,c2); \
+		} \
+		for (;j<m;++j) wd_csa_inc(KK,d,x[j]); \
+		wnew[k] = C < 0 ? wd_mask_select(KK,d,lo,dx) : wd_mask_select(KK+1,s,lo,dx); \
+	} \
+}
+
+MW_TOTAL_DEFINE(1) MW_TOTAL_DEFINE(2) MW_TOTAL_DEFINE(3)
+MW_TOTAL_DEFINE(4) MW_TOTAL_DEFINE(5) MW_TOTAL_DEFINE(6)
+
+static void mw_total_K(const int K, const size_t n, word_t* const wnew, const word_t* const w, const int B, const int C, const word_t mask)
+{
+	switch (K) {
+		case 1:  mw_total_1(n,wnew,w,B,C,mask); break;
+		case 2:  mw_total_2(n,wnew,w,B,C,mask); break;
+		case 3:  mw_total_3(n,wnew,w,B,C,mask); break;
+		case 4:  mw_total_4(n,wnew,w,B,C,mask); break;
+		case 5:  mw_total_5(n,wnew,w,B,C,mask); break;
+		default: mw_total_6(n,wnew,w,B,C,mask); break;
+	}
+}
+
+static inline int mw_total_digits(int c)
+{
+	// digits for counts up to c (at least 1)
+	int K = 1;
+	while (c >>= 1) ++K;
+	return K;
+}
+
+void mw_total(const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f)
+{
+	mw_total_K(mw_total_digits(B),n,wnew,w,B,-1,f[0]);
+}
+
+void mw_outer(const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f)
+{
+	mw_total_K(mw_total_digits(B-1),n,wnew,w,B,B/2,f[0]);
+}
+
+void mw_filter_total(const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f)
+{
+	const word_t mask = wd_total_mask(B,f);
+	mw_total(n,wnew,w,B,&mask);
+}
+
+void mw_filter_outer(const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f)
+{
+	const word_t mask = wd_outer_mask(B,f);
+	mw_outer(n,wnew,w,B,&mask);
+}
+
 void mw_run(const size_t I, const size_t n, word_t* const w, const int B, const word_t* const f)
 {
 	if (I == 0) return; // do nothing
+	const mw_filter_t filt = mw_filter_sel(B);
 	const size_t J = I/2;
 	word_t ww[n];
 	for (size_t j=0;j<J;++j) {
-		mw_filter(n,ww,w,B,f);
-		mw_filter(n,w,ww,B,f);
+		filt(n,ww,w,B,f);
+		filt(n,w,ww,B,f);
 	}
 	if (2*J != I) { // odd number of iterations - one more to go
-		mw_filter(n,ww,w,B,f);
+		filt(n,ww,w,B,f);
 		mw_copy(n,w,ww);
 	}
 }
@@ -8,6 +8,7 @@
 
 #include "utils.h"
 #include "mt64.h"
+#include "xr64.h"
 
 #ifndef UINT64_MAX
 #error No 64-bit unsigned integer type!
@@ -49,6 +50,13 @@ typedef uint64_t word_t;
 // Flip bit in word w at position p; w should be of type word_t
 #define FLIPBIT(w,p) ((w) ^= (WONE<<(p)))
 
+// Rule tables are bit-packed: entry r (WONE or WZERO) is bit r%64 of word r/64 of table t.
+// For tables of fewer than 64 entries, the unused hi-bits of the (single) word are kept clear.
+// Note that r may be evaluated more than once - careful!
+#define RTBIT(t,r)    (WONE&((t)[(r)>>6]>>((r)&63)))
+#define RTSET(t,r,b)  PUTBIT((t)[(r)>>6],(r)&63,b)
+#define RTFLIP(t,r)   FLIPBIT((t)[(r)>>6],(r)&63)
+
 // Index for binning mutual information
 #define MIIDX(wi,i,wj,j) ((((wi)>>(i))&WONE)|((((wj)>>(j))<<1)&WTWO))
 
@@ -68,10 +76,27 @@ static inline word_t wd_random(mt_t* const prng)
 	return mt_uint(prng);
 }
 
+// Bernoulli(p) words are built word-at-a-time from the binary expansion
+// p = 0.b_1 b_2 ... b_D: starting from the least significant 1 digit, each
+// further digit combines a fresh uniform word by OR (b_k = 1) or AND (b_k = 0),
+// so that D draws give 64 bits, exact for p rounded to WBPREC digits. For small
+// p multi-word masks are sampled instead by geometric skips between set bits.
+
+#define WBPREC 24             // binary digits of p used for Bernoulli words
+#define WBSKIP (1.0/16.0)     // multi-word masks by geometric skips below this p
+
 static inline word_t wd_randomb(const double p, mt_t* const prng)
 {
-	word_t w = WZERO;
-	for (int i=0; i<WBITS; ++i) if (mt_rand(prng) < p) SETBIT(w,i);
+	if (!(p > 0.0)) return WZERO;
+	if (p >= 1.0)   return WONES;
+	const word_t q = (word_t)(p*(double)POW2(WBPREC)+0.5); // p rounded to WBPREC digits
+	if (q == 0)            return WZERO;
+	if (q == POW2(WBPREC)) return WONES;
+	word_t w = mt_uint(prng); // least significant 1 digit
+	for (int k=__builtin_ctzll(q)+1;k<WBPREC;++k) {
+		const word_t u = mt_uint(prng);
+		w = ((q>>k)&WONE) ? (w|u) : (w&u);
+	}
 	return w;
 }
 
@@ -96,7 +121,7 @@ static inline word_t wd_filter(const int n, const word_t w, const int B, const w
 	const word_t BMASK = WONES>>(WBITS-B); // mask to clear bits above 1st B
 	word_t w2 = (w<<n)|w; // double-up word
 	word_t wnew = WZERO;
-	for (int i=0; i<n; ++i, w2>>=1) PUTBIT(wnew,i,f[w2&BMASK]);
+	for (int i=0; i<n; ++i, w2>>=1) PUTBIT(wnew,i,RTBIT(f,w2&BMASK));
 	return wnew;
 }
 
@@ -114,7 +139,7 @@ static inline word_t wd_reverse(word_t w)
 
 static inline void wd_noisify(word_t* const w, const double p, mt_t* const prng)
 {
-	for (int i=0; i<WBITS; ++i) if (mt_rand(prng) < p) FLIPBIT(*w,i);
+	*w ^= wd_randomb(p,prng);
 }
 
 static inline int wd_nsetbits(word_t w) // Kernighan!
@@ -162,11 +187,72 @@ static inline void mw_randomise(const size_t n, word_t* const w, mt_t* const prn
 	for (word_t* pw=w;pw<w+n;++pw) *pw = wd_random(prng);
 }
 
+static inline void mw_flipb(const size_t n, word_t* const w, const double p, mt_t* const prng)
+{
+	// flip bits independently with probability p, by geometric skips (for small p)
+	if (!(p > 0.0)) return;
+	const double lq = log1p(-p);
+	const double N  = (double)(n*WBITS);
+	for (double i=-1.0;;) {
+		i += 1.0+floor(log(mt_rand_pos(prng))/lq);
+		if (i >= N) return;
+		const size_t b = (size_t)i;
+		FLIPBIT(w[b/WBITS],b%WBITS);
+	}
+}
+
 static inline void mw_randomiseb(const size_t n, word_t* const w, const double p, mt_t* const prng)
 {
+	if (p < WBSKIP) {mw_zero(n,w); mw_flipb(n,w,p,prng); return;}
 	for (word_t* pw=w;pw<w+n;++pw) *pw = wd_randomb(p,prng);
 }
 
+// Bulk fills with the xoshiro256** generator (xr64.h): uniform words straight
+// from the interleaved lanes, Bernoulli words by the binary expansion above
+// applied to blocks of XR_BLOCK words at a time.
+
+#define XR_BLOCK 64 // words per Bernoulli block
+
+static inline void mw_randomise_xr(const size_t n, word_t* const w, xr_t* const prng)
+{
+	xr_fill(prng,n,w);
+}
+
+static inline void mw_flipb_xr(const size_t n, word_t* const w, const double p, xr_t* const prng)
+{
+	// flip bits independently with probability p, by geometric skips (for small p)
+	if (!(p > 0.0)) return;
+	const double lq = log1p(-p);
+	const double N  = (double)(n*WBITS);
+	for (double i=-1.0;;) {
+		i += 1.0+floor(log(xr_rand_pos(prng))/lq);
+		if (i >= N) return;
+		const size_t b = (size_t)i;
+		FLIPBIT(w[b/WBITS],b%WBITS);
+	}
+}
+
+static inline void mw_randomiseb_xr(const size_t n, word_t* const w, const double p, xr_t* const prng)
+{
+	if (!(p > 0.0)) {mw_zero(n,w); return;}
+	if (p >= 1.0)   {memset(w,0xFF,n*sizeof(word_t)); return;}
+	if (p < WBSKIP) {mw_zero(n,w); mw_flipb_xr(n,w,p,prng); return;}
+	const word_t q = (word_t)(p*(double)POW2(WBPREC)+0.5); // p rounded to WBPREC digits
+	if (q == POW2(WBPREC)) {memset(w,0xFF,n*sizeof(word_t)); return;}
+	const int k0 = __builtin_ctzll(q)+1;
+	word_t u[XR_BLOCK];
+	for (size_t j=0;j<n;j+=XR_BLOCK) {
+		const size_t m = j+XR_BLOCK <= n ? XR_BLOCK : n-j;
+		word_t* const wj = w+j;
+		xr_fill(prng,m,wj); // least significant 1 digit
+		for (int k=k0;k<WBPREC;++k) {
+			xr_fill(prng,m,u);
+			if ((q>>k)&WONE) for (size_t i=0;i<m;++i) wj[i] |= u[i];
+			else             for (size_t i=0;i<m;++i) wj[i] &= u[i];
+		}
+	}
+}
+
 static inline int mw_equal(const size_t n, const word_t* const w1, const word_t* const w2)
 {
 	return memcmp(w1,w2,n*sizeof(word_t)) == 0;
@@ -205,6 +291,7 @@ static inline void mw_reverse(const size_t n, word_t* const wrev, const word_t*
 
 static inline void wm_noisify(const size_t n, word_t* const w, const double p, mt_t* const prng)
 {
+	if (p < WBSKIP) {mw_flipb(n,w,p,prng); return;}
 	for (word_t* pw=w; pw<w+n; ++pw) wd_noisify(pw,p,prng);
 }
 
@@ -218,6 +305,36 @@ static inline int mw_equiv(const size_t n, const word_t* const w1, const word_t*
 	return -1;
 }
 
+static inline int mw_equiv2(const size_t n, const word_t* const w1, const word_t* const w2, const word_t* const u1, const word_t* const u2)
+{
+	// as mw_equiv, for pairs of rows under a common rotation
+	word_t urot[n];
+	for (size_t b=0;b<n*WBITS;++b) {
+		mw_rotl(n,urot,u1,b);
+		if (!mw_equal(n,w1,urot)) continue;
+		mw_rotl(n,urot,u2,b);
+		if (mw_equal(n,w2,urot)) return (int)b;
+	}
+	return -1;
+}
+
+static inline void mw_xor_rotr(const size_t n, word_t* const w, const word_t* const u, const size_t nbits)
+{
+	// w ^= u rotated right by nbits (cf. mw_rotr); w and u must not overlap
+	const int b = nbits%WBITS;
+	const size_t m = (nbits/WBITS)%n;
+	size_t j = m; // source word
+	if (b == 0) {
+		for (size_t k=0;k<n;++k) {w[k] ^= u[j]; if (++j == n) j = 0;}
+		return;
+	}
+	for (size_t k=0;k<n;++k) {
+		const size_t j1 = j+1 < n ? j+1 : 0;
+		w[k] ^= (u[j]>>b)|(u[j1]<<(WBITS-b));
+		j = j1;
+	}
+}
+
 static inline int mw_nsetbits(const size_t n, const word_t* const w)
 {
 	int b = 0;
@@ -240,15 +357,102 @@ static inline void mw_filter(const size_t n, word_t* const wnew, const word_t* c
 		const word_t wk1 = k < n-1 ? w[k+1] : w[0]; // next word : wrap to lo-word on last word
 		int i = 0;
 		word_t wnewk;
-		for (;i<WB;   ++i,wk>>=1) PUTBIT(wnewk,i,f[wk&BMASK]);
+		for (;i<WB;   ++i,wk>>=1) PUTBIT(wnewk,i,RTBIT(f,wk&BMASK));
 		wk |= (wk1<<B); // splice in next word
-		for (;i<WBITS;++i,wk>>=1) PUTBIT(wnewk,i,f[wk&BMASK]);
+		for (;i<WBITS;++i,wk>>=1) PUTBIT(wnewk,i,RTBIT(f,wk&BMASK));
 		wnew[k] = wnewk;
 	}
 }
 
 void mw_run(const size_t I, const size_t n, word_t* const w, const int B, const word_t* const f);
 
+// Kernels specialised by rule size (constant masks and loop bounds), selected
+// once per rule; sizes above WFMAXB fall back to the generic kernels.
+
+#define WFMAXB 20
+
+typedef word_t (*wd_filter_t)(const int n, const word_t w, const int B, const word_t* const f);
+typedef void   (*mw_filter_t)(const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f);
+
+wd_filter_t wd_filter_sel(const int B);
+mw_filter_t mw_filter_sel(const int B);
+void        mw_filter_gen(const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f); // generic (not inlined)
+
+// (Outer-)totalistic kernels: the output depends only on the number c of set
+// cells in the window (totalistic), or on the number c of set cells other than
+// the centre cell x_{B/2} and the centre state s (outer-totalistic). The counts
+// for 64 cells are accumulated bit-sliced by a carry-save adder network over
+// the shifted words, and the output selected from the rule mask f[0] (bit c, or
+// bit 2c+s) by a multiplexer tree on the count digits, so no 2^B table is
+// needed. mw_filter_total/mw_filter_outer take an (outer-)totalistic rule
+// *table* instead (the mask is read off the table on each call).
+
+#define WTOTMAXB 63 // totalistic mask has B+1 bits
+#define WOUTMAXB 32 // outer-totalistic mask has 2B bits
+
+static inline void wd_csa(word_t* const h, word_t* const l, const word_t a, const word_t b, const word_t c)
+{
+	// carry-save (full) adder, 64 bits at a time: a+b+c = 2h+l
+	const word_t u = a^b;
+	*h = (a&b)|(u&c);
+	*l = u^c;
+}
+
+static inline void wd_csa_inc(const int K, word_t* const s, word_t c)
+{
+	// add bit-sliced 1-bit numbers c to bit-sliced K-digit numbers s
+	for (int d=0;d<K;++d) {const word_t t = s[d]&c; s[d] ^= c; c = t;}
+}
+
+static inline void wd_mask_leaves(const int K, const word_t mask, word_t* const lo, word_t* const dx)
+{
+	// bottom level of the multiplexer tree for wd_mask_select (once per mask): lo[m] if digit 0 clear, else lo[m]^dx[m]
+	for (int m=0;m<(1<<(K-1));++m) {
+		lo[m] = WZERO-BITON(mask,2*m);
+		dx[m] = lo[m]^(WZERO-BITON(mask,2*m+1));
+	}
+}
+
+static inline word_t wd_mask_select(const int K, const word_t* const sel, const word_t* const lo, const word_t* const dx)
+{
+	// bit i of result is bit (K-digit number sel at bit i) of the mask: multiplexer tree, selector digit j at level j
+	word_t v[WBITS];
+	const int H = 1<<(K-1);
+	for (int m=0;m<H;++m) v[m] = lo[m]^(sel[0]&dx[m]);
+	for (int j=1,h=H/2;j<K;++j,h/=2) {
+		for (int m=0;m<h;++m) v[m] = v[2*m]^(sel[j]&(v[2*m]^v[2*m+1]));
+	}
+	return v[0];
+}
+
+static inline word_t wd_total_mask(const int B, const word_t* const f)
+{
+	// mask read off a totalistic table: entry with the c lowest cells set
+	word_t mask = WZERO;
+	for (int c=0;c<=B;++c) mask |= RTBIT(f,POW2(c)-1)<<c;
+	return mask;
+}
+
+static inline word_t wd_outer_entry(const int B, const int c, const word_t s)
+{
+	// table entry with c set cells other than the centre, and centre state s
+	const int C = B/2;
+	return (c <= C ? POW2(c)-1 : (POW2(c+1)-1)&~POW2(C))|(s<<C);
+}
+
+static inline word_t wd_outer_mask(const int B, const word_t* const f)
+{
+	// mask read off an outer-totalistic table
+	word_t mask = WZERO;
+	for (int c=0;c<B;++c) for (int s=0;s<2;++s) mask |= RTBIT(f,wd_outer_entry(B,c,(word_t)s))<<(2*c+s);
+	return mask;
+}
+
+void mw_total        (const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f); // f[0] is totalistic mask
+void mw_outer        (const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f); // f[0] is outer-totalistic mask
+void mw_filter_total (const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f); // f is totalistic table
+void mw_filter_outer (const size_t n, word_t* const wnew, const word_t* const w, const int B, const word_t* const f); // f is outer-totalistic table
+
 static inline word_t mw_get_part(const size_t n, const word_t* const w, const int B, const int b)
 {
 	const int WB = WBITS-B;
@@ -0,0 +1,111 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "xr64.h"
+
+static inline uint64_t xr_splitmix(uint64_t* const x)
+{
+	uint64_t z = (*x += UINT64_C(0x9E3779B97F4A7C15));
+	z = (z^(z>>30))*UINT64_C(0xBF58476D1CE4E5B9);
+	z = (z^(z>>27))*UINT64_C(0x94D049BB133111EB);
+	return z^(z>>31);
+}
+
+// initializes state
+uint64_t xr_seed(xr_t* const pstate, uint64_t seed)
+{
+	if (seed == 0) { // initialise from /dev/urandom
+		FILE* fp = fopen("/dev/urandom","r");
+		if (fp == NULL)                              {perror("xr_seed: failed to open /dev/urandom" ); exit(EXIT_FAILURE);}
+		if (fread(&seed,sizeof(uint64_t),1,fp) != 1) {perror("xr_seed: failed to read /dev/urandom" ); exit(EXIT_FAILURE);}
+		if (fclose(fp) != 0)                         {perror("xr_seed: failed to close /dev/urandom"); exit(EXIT_FAILURE);}
+	}
+
+	uint64_t x = seed;
+	for (int l=0;l<XR_LANES;++l) for (int i=0;i<4;++i) pstate->s[i][l] = xr_splitmix(&x); // never all zero
+	pstate->nbuf = 0;
+
+	return seed;
+}
+
+void xr_philox(const uint64_t key[2], uint64_t ctr[4])
+{
+	uint64_t k0 = key[0], k1 = key[1];
+	for (int r=0;r<10;++r) {
+		const __uint128_t p0 = (__uint128_t)UINT64_C(0xD2E7470EE14C6C93)*ctr[0];
+		const __uint128_t p1 = (__uint128_t)UINT64_C(0xCA5A826395121157)*ctr[2];
+		const uint64_t c1 = ctr[1], c3 = ctr[3];
+		ctr[0] = (uint64_t)(p1>>64)^c1^k0;
+		ctr[1] = (uint64_t)p1;
+		ctr[2] = (uint64_t)(p0>>64)^c3^k1;
+		ctr[3] = (uint64_t)p0;
+		k0 += UINT64_C(0x9E3779B97F4A7C15);
+		k1 += UINT64_C(0xBB67AE8584CAA73B);
+	}
+}
+
+void xr_seed_key(xr_t* const pstate, const uint64_t seed, const uint64_t job, const uint64_t idx)
+{
+	const uint64_t key[2] = {seed,job};
+	for (int l=0;l<XR_LANES;++l) { // one Philox block per lane
+		uint64_t c[4] = {idx,(uint64_t)l,0,0};
+		xr_philox(key,c);
+		for (int i=0;i<4;++i) pstate->s[i][l] = c[i];
+	}
+	pstate->nbuf = 0;
+}
+
+// Lanes are stepped together as GCC/Clang vector types (split by the compiler
+// into whatever SIMD registers the target has): left to itself the compiler
+// promotes the state to scalar registers and the lanes run one at a time.
+
+typedef uint64_t xr_vec_t __attribute__((vector_size(XR_LANES*sizeof(uint64_t))));
+
+#define XR_VROTL(x,k) (((x)<<(k))|((x)>>(64-(k))))
+
+// nb steps of every lane, XR_LANES outputs per step
+static void xr_steps(uint64_t s[4][XR_LANES], const size_t nb, uint64_t* const x)
+{
+	xr_vec_t s0, s1, s2, s3;
+	memcpy(&s0,s[0],sizeof(xr_vec_t));
+	memcpy(&s1,s[1],sizeof(xr_vec_t));
+	memcpy(&s2,s[2],sizeof(xr_vec_t));
+	memcpy(&s3,s[3],sizeof(xr_vec_t));
+	for (size_t b=0;b<nb;++b) {
+		const xr_vec_t y = (s1<<2)+s1;   // s1*5
+		const xr_vec_t r = XR_VROTL(y,7);
+		const xr_vec_t o = (r<<3)+r;     // *9
+		memcpy(x+b*XR_LANES,&o,sizeof(xr_vec_t));
+		const xr_vec_t t = s1<<17;
+		s2 ^= s0;
+		s3 ^= s1;
+		s1 ^= s2;
+		s0 ^= s3;
+		s2 ^= t;
+		s3  = XR_VROTL(s3,45);
+	}
+	memcpy(s[0],&s0,sizeof(xr_vec_t));
+	memcpy(s[1],&s1,sizeof(xr_vec_t));
+	memcpy(s[2],&s2,sizeof(xr_vec_t));
+	memcpy(s[3],&s3,sizeof(xr_vec_t));
+}
+
+void xr_refill(xr_t* const pstate)
+{
+	xr_steps(pstate->s,1,pstate->buf);
+	pstate->nbuf = XR_LANES;
+}
+
+void xr_fill(xr_t* const pstate, const size_t n, uint64_t* const x)
+{
+	size_t k = 0;
+	for (;k<n && pstate->nbuf > 0;++k) x[k] = pstate->buf[XR_LANES-pstate->nbuf--]; // drain buffer
+	const size_t nb = (n-k)/XR_LANES;
+	xr_steps(pstate->s,nb,x+k);
+	k += nb*XR_LANES;
+	if (k < n) {
+		xr_refill(pstate);
+		for (;k<n;++k) x[k] = pstate->buf[XR_LANES-pstate->nbuf--];
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef XR64_H
+#define XR64_H
+
+// xoshiro256** PRNG (Blackman and Vigna), with XR_LANES independent generators
+// interleaved lane-wise so that bulk fills vectorise (thread-safe). Much faster
+// than the Mersenne Twister (mt64.h) for filling rows and rule tables; the
+// output streams differ, so use mt_t to reproduce earlier runs.
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#define XR_LANES 8
+
+typedef struct {
+	uint64_t s[4][XR_LANES]; // state, lane-interleaved
+	uint64_t buf[XR_LANES];  // last batch, for single draws
+	int      nbuf;           // draws left in buf
+} xr_t;
+
+// initializes state (lanes seeded by splitmix64; seed 0 for unpredictable)
+uint64_t xr_seed(xr_t* const pstate, uint64_t seed);
+
+// Philox4x64-10 (Salmon et al., 2011), a counter-based generator: ctr is
+// replaced in place by a random function of (key, ctr)
+void xr_philox(const uint64_t key[2], uint64_t ctr[4]);
+
+// initializes state from a (seed, job, index) key via Philox, so that the stream
+// for any index may be regenerated independently of all others
+void xr_seed_key(xr_t* const pstate, const uint64_t seed, const uint64_t job, const uint64_t idx);
+
+// fills x with n random numbers on [0, 2^64-1]-interval (same stream as n calls to xr_uint)
+void xr_fill(xr_t* const pstate, const size_t n, uint64_t* const x);
+
+// refills buffer (used by xr_uint)
+void xr_refill(xr_t* const pstate);
+
+// generates a random number on [0, 2^64-1]-interval
+static inline uint64_t xr_uint(xr_t* const pstate)
+{
+	if (pstate->nbuf == 0) xr_refill(pstate);
+	return pstate->buf[XR_LANES-pstate->nbuf--];
+}
+
+// generates a random number uniform on [0,1)-real-interval
+static inline double xr_rand(xr_t* const pstate)
+{
+	return (double)(xr_uint(pstate) >> 11) * (1.0/9007199254740992.0);
+}
+
+// generates a random number uniform on (0,1)-real-interval
+static inline double xr_rand_pos(xr_t* const pstate)
+{
+	double x;
+	do x = (double)(xr_uint(pstate) >> 11) * (1.0/9007199254740992.0); while (x == 0.0);
+	return x;
+}
+
+#endif // XR64_H